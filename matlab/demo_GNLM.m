@@ -12,7 +12,7 @@ out1 = guidedNLMeans(noisy, L, guide,  256, 0.002); %GNLM1
 timealg1 = toc(startime);
 reg1 = out1(enl_area.y1:enl_area.y2, enl_area.x1:enl_area.x2);
 enl1 = (mean(reg1(:).^2)^2)/var(reg1(:).^2);
-fprintf('GNLM1 is done\n');
+fprintf('GNLM1 is done (%.2f s)\n', timealg1);
 
 fprintf('run GNLM2 ...\n');
 startime = tic();
@@ -20,7 +20,16 @@ out2 = guidedNLMeans(noisy, L, guide, 1521, 0.004); %GNLM2
 timealg2 = toc(startime);
 reg2 = out2(enl_area.y1:enl_area.y2, enl_area.x1:enl_area.x2);
 enl2 = (mean(reg2(:).^2)^2)/var(reg2(:).^2);
-fprintf('GNLM2 is done\n');
+fprintf('GNLM2 is done (%.2f s)\n', timealg2);
+
+fprintf('run GNLM1 and GNLM2 with a single block matching ...\n');
+startime = tic();
+options = struct('configs', [256, 0.002; 1521, 0.004]);
+out = guidedNLMeans(noisy, L, guide, 256, 0.002, 0.15, 2.0, 8, 39, 3, options);
+timealg12 = toc(startime);
+diff12 = max(max(max(abs(out(:,:,1) - out1))), max(max(abs(out(:,:,2) - out2))));
+fprintf('GNLM1 and GNLM2 are done (%.2f s, separate runs %.2f s, max difference %g)\n', ...
+    timealg12, timealg1 + timealg2, diff12);
 
 figure();
 subplot(2,2,1); imshow(uint8(guide));  title('Giude');
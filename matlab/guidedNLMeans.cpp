@@ -20,6 +20,7 @@
 //
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
+#include <string>
 #include <opencv/cv.h>
 #include "mex.h"
 #include "mex_cv_4b.hpp"
@@ -73,32 +74,305 @@ void mx2GuidedNLMeansProfile(const mxArray* mx, GuidedNLMeansProfile<T> &opt) {
      
      opt.config(NB,NS,NA,Nstep, tau_match, beta, alpha, thDist, lambda1, lambda2);
      
+     // parametri opzionali
+     if ( mxGetField(mx,0,"incremental") ) opt.incremental = ( mxGetScalar( mxGetField(mx,0,"incremental") ) != 0 );
+     if ( mxGetField(mx,0,"symmetric_cache") ) opt.symmetric_cache = mxGetScalar( mxGetField(mx,0,"symmetric_cache") );
+     if ( mxGetField(mx,0,"guide_bound") ) opt.guide_bound = ( mxGetScalar( mxGetField(mx,0,"guide_bound") ) != 0 );
+     if ( mxGetField(mx,0,"sar_bound") ) opt.sar_bound = ( mxGetScalar( mxGetField(mx,0,"sar_bound") ) != 0 );
+     if ( mxGetField(mx,0,"pca_dims") ) opt.pca_dims = (int) mxGetScalar( mxGetField(mx,0,"pca_dims") );
+     if ( mxGetField(mx,0,"pca_rerank") ) opt.pca_rerank = (int) mxGetScalar( mxGetField(mx,0,"pca_rerank") );
+     if ( mxGetField(mx,0,"knn_candidates") ) opt.knn_candidates = (int) mxGetScalar( mxGetField(mx,0,"knn_candidates") );
+     if ( mxGetField(mx,0,"patch_match") ) opt.patch_match = ( mxGetScalar( mxGetField(mx,0,"patch_match") ) != 0 );
+     if ( mxGetField(mx,0,"pm_passes") ) opt.pm_passes = (int) mxGetScalar( mxGetField(mx,0,"pm_passes") );
+     if ( mxGetField(mx,0,"pm_samples") ) opt.pm_samples = (int) mxGetScalar( mxGetField(mx,0,"pm_samples") );
+     if ( mxGetField(mx,0,"pyr_levels") ) opt.pyr_levels = (int) mxGetScalar( mxGetField(mx,0,"pyr_levels") );
+     if ( mxGetField(mx,0,"pyr_survivors") ) opt.pyr_survivors = (int) mxGetScalar( mxGetField(mx,0,"pyr_survivors") );
+     if ( mxGetField(mx,0,"propagate") ) opt.propagate = ( mxGetScalar( mxGetField(mx,0,"propagate") ) != 0 );
+     if ( mxGetField(mx,0,"sampling") ) opt.sampling = (int) mxGetScalar( mxGetField(mx,0,"sampling") );
+     if ( mxGetField(mx,0,"sample_budget") ) opt.sample_budget = mxGetScalar( mxGetField(mx,0,"sample_budget") );
+     if ( mxGetField(mx,0,"adaptive_step") ) opt.adaptive_step = (int) mxGetScalar( mxGetField(mx,0,"adaptive_step") );
+     if ( mxGetField(mx,0,"adaptive_fraction") ) opt.adaptive_fraction = mxGetScalar( mxGetField(mx,0,"adaptive_fraction") );
+     if ( mxGetField(mx,0,"min_search_diameter") ) opt.min_search_diameter = (int) mxGetScalar( mxGetField(mx,0,"min_search_diameter") );
+     if ( mxGetField(mx,0,"stack_tolerance") ) opt.stack_tolerance = mxGetScalar( mxGetField(mx,0,"stack_tolerance") );
+     if ( mxGetField(mx,0,"aggregate_all") ) opt.aggregate_all = ( mxGetScalar( mxGetField(mx,0,"aggregate_all") ) != 0 );
+     if ( mxGetField(mx,0,"temporal_joint") ) opt.temporal_joint = ( mxGetScalar( mxGetField(mx,0,"temporal_joint") ) != 0 );
+     if ( mxGetField(mx,0,"preview_passes") ) opt.preview_passes = (int) mxGetScalar( mxGetField(mx,0,"preview_passes") );
+     
+     if (opt.symmetric_cache < 0) mexErrMsgIdAndTxt(tool_id, "The parameter 'symmetric_cache' is not set correctly");
+     if (opt.pca_dims        < 0) mexErrMsgIdAndTxt(tool_id, "The parameter 'pca_dims' is not set correctly");
+     if (opt.pca_rerank      < 0) mexErrMsgIdAndTxt(tool_id, "The parameter 'pca_rerank' is not set correctly");
+     if (opt.knn_candidates  < 0) mexErrMsgIdAndTxt(tool_id, "The parameter 'knn_candidates' is not set correctly");
+     if (opt.pm_passes       < 0) mexErrMsgIdAndTxt(tool_id, "The parameter 'pm_passes' is not set correctly");
+     if (opt.pm_samples      < 0) mexErrMsgIdAndTxt(tool_id, "The parameter 'pm_samples' is not set correctly");
+     if (opt.pyr_levels      < 0) mexErrMsgIdAndTxt(tool_id, "The parameter 'pyr_levels' is not set correctly");
+     if (opt.pyr_survivors   < 1) mexErrMsgIdAndTxt(tool_id, "The parameter 'pyr_survivors' is not set correctly");
+     if (opt.sampling < 0 || opt.sampling > 3) mexErrMsgIdAndTxt(tool_id, "The parameter 'sampling' is not set correctly");
+     if (opt.sample_budget<=0 || opt.sample_budget > 1) mexErrMsgIdAndTxt(tool_id, "The parameter 'sample_budget' is not set correctly");
+     if (opt.adaptive_step   < 0) mexErrMsgIdAndTxt(tool_id, "The parameter 'adaptive_step' is not set correctly");
+     if (opt.adaptive_fraction<0 || opt.adaptive_fraction > 1) mexErrMsgIdAndTxt(tool_id, "The parameter 'adaptive_fraction' is not set correctly");
+     if (opt.min_search_diameter < 0) mexErrMsgIdAndTxt(tool_id, "The parameter 'min_search_diameter' is not set correctly");
+     if (opt.stack_tolerance<0 || opt.stack_tolerance >= 1) mexErrMsgIdAndTxt(tool_id, "The parameter 'stack_tolerance' is not set correctly");
+     
+}
+
+mxArray* GuidedNLMeansInfo2mx(const GuidedNLMeansInfo &info) {
+     const char* names[] = {"search_mode", "ignored_options",
+                            "cache_lookups", "cache_hits", "cache_bytes",
+                            "guide_bound_tests", "guide_bound_rejects",
+                            "sar_bound_tests", "sar_bound_rejects",
+                            "pca_dims", "pca_energy", "pca_rerank_changes", "pca_avoided",
+                            "knn_queries", "knn_distances",
+                            "pm_references", "pm_evaluations",
+                            "pyr_references", "pyr_evaluations", "pyr_candidates",
+                            "seed_evaluations", "seed_references", "seed_pruned",
+                            "references", "search_positions", "stack_blocks", "guide_distances",
+                            "guide_cache",
+                            "deadline_step", "deadline_diameter", "deadline_stack", "deadline_estimate",
+                            "deadline_time", "deadline_tiles", "deadline_fallbacks"};
+     mxArray* mx = mxCreateStructMatrix(1, 1, 35, names);
+     mxSetField(mx, 0, "search_mode",     mxCreateDoubleScalar(info.search_mode));
+     mxSetField(mx, 0, "ignored_options", mxCreateDoubleScalar(info.ignored_options));
+     mxSetField(mx, 0, "cache_lookups", mxCreateDoubleScalar(info.cache_lookups));
+     mxSetField(mx, 0, "cache_hits",    mxCreateDoubleScalar(info.cache_hits));
+     mxSetField(mx, 0, "cache_bytes",   mxCreateDoubleScalar(info.cache_bytes));
+     mxSetField(mx, 0, "guide_bound_tests",   mxCreateDoubleScalar(info.guide_bound_tests));
+     mxSetField(mx, 0, "guide_bound_rejects", mxCreateDoubleScalar(info.guide_bound_rejects));
+     mxSetField(mx, 0, "sar_bound_tests",     mxCreateDoubleScalar(info.sar_bound_tests));
+     mxSetField(mx, 0, "sar_bound_rejects",   mxCreateDoubleScalar(info.sar_bound_rejects));
+     mxSetField(mx, 0, "pca_dims",           mxCreateDoubleScalar(info.pca_dims));
+     mxSetField(mx, 0, "pca_energy",         mxCreateDoubleScalar(info.pca_energy));
+     mxSetField(mx, 0, "pca_rerank_changes", mxCreateDoubleScalar(info.pca_rerank_changes));
+     mxSetField(mx, 0, "pca_avoided",        mxCreateDoubleScalar(info.pca_avoided));
+     mxSetField(mx, 0, "knn_queries",   mxCreateDoubleScalar(info.knn_queries));
+     mxSetField(mx, 0, "knn_distances", mxCreateDoubleScalar(info.knn_distances));
+     mxSetField(mx, 0, "pm_references",  mxCreateDoubleScalar(info.pm_references));
+     mxSetField(mx, 0, "pm_evaluations", mxCreateDoubleScalar(info.pm_evaluations));
+     mxSetField(mx, 0, "pyr_references",  mxCreateDoubleScalar(info.pyr_references));
+     mxSetField(mx, 0, "pyr_evaluations", mxCreateDoubleScalar(info.pyr_evaluations));
+     mxSetField(mx, 0, "pyr_candidates",  mxCreateDoubleScalar(info.pyr_candidates));
+     mxSetField(mx, 0, "seed_evaluations", mxCreateDoubleScalar(info.seed_evaluations));
+     mxSetField(mx, 0, "seed_references",  mxCreateDoubleScalar(info.seed_references));
+     mxSetField(mx, 0, "seed_pruned",      mxCreateDoubleScalar(info.seed_pruned));
+     mxSetField(mx, 0, "references",       mxCreateDoubleScalar(info.references));
+     mxSetField(mx, 0, "search_positions", mxCreateDoubleScalar(info.search_positions));
+     mxSetField(mx, 0, "stack_blocks",     mxCreateDoubleScalar(info.stack_blocks));
+     mxSetField(mx, 0, "guide_distances",  mxCreateDoubleScalar(info.guide_distances));
+     mxSetField(mx, 0, "guide_cache",      mxCreateDoubleScalar(info.guide_cache));
+     mxSetField(mx, 0, "deadline_step",      mxCreateDoubleScalar(info.deadline_step));
+     mxSetField(mx, 0, "deadline_diameter",  mxCreateDoubleScalar(info.deadline_diameter));
+     mxSetField(mx, 0, "deadline_stack",     mxCreateDoubleScalar(info.deadline_stack));
+     mxSetField(mx, 0, "deadline_estimate",  mxCreateDoubleScalar(info.deadline_estimate));
+     mxSetField(mx, 0, "deadline_time",      mxCreateDoubleScalar(info.deadline_time));
+     mxSetField(mx, 0, "deadline_tiles",     mxCreateDoubleScalar(info.deadline_tiles));
+     mxSetField(mx, 0, "deadline_fallbacks", mxCreateDoubleScalar(info.deadline_fallbacks));
+     return mx;
+}
+
+template<typename T>
+void mx2GuidedNLMeansConfigs(const mxArray* mx, const GuidedNLMeansProfile<T> &opt, std::vector< GuidedNLMeansConfig<T> > &configs) {
+     // una configurazione per riga: [max_matched lambda1 lambda2] o [max_matched lambda1 lambda2 thDist]
+     cv::Mat_<double> cfg;
+     mx2cv(mx, cfg);
+     if (cfg.rows<1 || (cfg.cols!=3 && cfg.cols!=4)) mexErrMsgIdAndTxt(tool_id, "The parameter 'configs' is not set correctly");
+     for(int k=0; k<cfg.rows; k++) {
+          if (cfg(k,0)<1 || cfg(k,1)<0 || cfg(k,2)<0) mexErrMsgIdAndTxt(tool_id, "The parameter 'configs' is not set correctly");
+          T thDist = (cfg.cols==4) ? (T) cfg(k,3) : opt.thDist;
+          configs.push_back(GuidedNLMeansConfig<T>((int) cfg(k,0), (T) cfg(k,1), (T) cfg(k,2), thDist));
+     }
+}
+
+template<typename T>
+void mx2cv(const mxArray* mx, std::vector< cv::Mat_<T> > &mats) {
+     // immagini affiancate lungo la terza dimensione
+     if ( ! mxIsDouble(mx) ) mexErrMsgTxt("The array must be double");
+     const mwSize* dims = mxGetDimensions(mx);
+     mwSize K = (mxGetNumberOfDimensions(mx)>2) ? dims[2] : 1;
+     mats.resize(K);
+     double* mx_real = mxGetPr(mx);
+     for(size_t k=0; k < K; k++) {
+          mats[k].create(dims[0], dims[1]);
+          for(int n=0; n < dims[1]; n++)
+               for(int m=0; m < dims[0]; m++)
+                    mats[k](m,n) = (T) *(mx_real++);
+     }
+}
+
+template<typename T>
+mxArray* cv2mx(const std::vector< cv::Mat_<T> > &mats) {
+     // immagini affiancate lungo la terza dimensione
+     mwSize dims[3] = {(mwSize) mats[0].rows, (mwSize) mats[0].cols, (mwSize) mats.size()};
+     mxArray* mx = mxCreateNumericArray(3, dims, mxDOUBLE_CLASS, mxREAL);
+     double* mx_real = mxGetPr(mx);
+     for(size_t k=0; k < mats.size(); k++)
+          for(int n=0; n < mats[k].cols; n++)
+               for(int m=0; m < mats[k].rows; m++)
+                    *(mx_real++) = mats[k](m,n);
+     return mx;
 }
 
 typedef float PixelType;
 typedef cv::Vec<PixelType, GUIDA_NUM_BANDS> PixelGuidaType;
 
-void mexFunction(int nlhs, mxArray *plhs[],
+// errore del function handle di anteprima (MException), riportato da mexFunction
+struct PreviewError {
+     mxArray *exception;
+     explicit PreviewError(mxArray *exception_) : exception(exception_) {}
+};
+
+// anteprima progressiva: chiama il function handle "data" con l'immagine e la passata;
+// un errore interrompe l'elaborazione con un'eccezione C++, che libera la memoria
+// di guided_nlmeans (mexCallMATLAB ne salterebbe i distruttori)
+void preview2mx(const cv::Mat_<PixelType> &image, int pass, int passes, void *data) {
+     mxArray* args[4] = { (mxArray*) data, cv2mx(image), mxCreateDoubleScalar(pass), mxCreateDoubleScalar(passes) };
+     mxArray* exception = mexCallMATLABWithTrap(0, 0, 4, args, "feval");
+     for(int k=1; k<4; k++) mxDestroyArray(args[k]);
+     if (exception) throw PreviewError(exception);
+}
+
+void guided_nlmeans_mex(int nlhs, mxArray *plhs[],
     int nrhs, const mxArray *prhs[]) {
     
 	cv::Mat_< PixelType > noisy;
     cv::Mat_< PixelGuidaType > guida;
     cv::Mat_<bool> valClass;
+    cv::Mat_<unsigned char> diameters;
+    std::string guide_cache;
 	
     GuidedNLMeansProfile<PixelType> opt;
+    GuidedNLMeansInfo info;
 
 	/* check for proper number of arguments */
 	if (nrhs!=4) mexErrMsgIdAndTxt(tool_id, "Four inputs are required.");
 	if (nlhs< 1) mexErrMsgIdAndTxt(tool_id, "At least One output is required.");
-	if (nlhs> 2) mexErrMsgIdAndTxt(tool_id, "Max Twe outputs are required.");
+	if (nlhs> 3) mexErrMsgIdAndTxt(tool_id, "Max Three outputs are required.");
 	
 	mx2cv(prhs[0], noisy);
     mx2cv(prhs[1], guida);
     mx2cv(prhs[2], valClass);
     mx2GuidedNLMeansProfile(prhs[3],opt);
+    opt.info = &info;
 	if (noisy.rows<opt.block_rows) mexErrMsgIdAndTxt(tool_id, "The noisy image is not valid");
     if (noisy.cols<opt.block_cols) mexErrMsgIdAndTxt(tool_id, "The noisy image is not valid");
     
+    // diametri della zona di ricerca (uno per blocco, o per pixel)
+    if ( mxGetField(prhs[3],0,"diameters") ) {
+        cv::Mat_<double> map;
+        mx2cv(mxGetField(prhs[3],0,"diameters"), map);
+        if (map.rows<noisy.rows-opt.block_rows+1 || map.cols<noisy.cols-opt.block_cols+1)
+            mexErrMsgIdAndTxt(tool_id, "The parameter 'diameters' is not set correctly");
+        diameters.create(map.rows, map.cols);
+        for(int i=0; i<map.rows; i++)
+            for(int j=0; j<map.cols; j++) {
+                if (map(i,j) < 1) mexErrMsgIdAndTxt(tool_id, "The parameter 'diameters' is not set correctly");
+                diameters(i,j) = (unsigned char) std::min(map(i,j), 255.0);
+            }
+        opt.diameters = &diameters;
+    }
+    
+    // anteprime progressive
+    if ( mxGetField(prhs[3],0,"preview") ) {
+        if ( !mxIsClass(mxGetField(prhs[3],0,"preview"), "function_handle") )
+            mexErrMsgIdAndTxt(tool_id, "The parameter 'preview' is not set correctly");
+        opt.preview = preview2mx;
+        opt.preview_data = mxGetField(prhs[3],0,"preview");
+    }
+    
+    // file della cache delle distanze della guida
+    if ( mxGetField(prhs[3],0,"guide_cache") ) {
+        char *filename = mxArrayToString(mxGetField(prhs[3],0,"guide_cache"));
+        if (filename==0) mexErrMsgIdAndTxt(tool_id, "The parameter 'guide_cache' is not set correctly");
+        guide_cache = filename;
+        mxFree(filename);
+        opt.guide_cache = guide_cache.empty() ? 0 : guide_cache.c_str();
+    }
+    
+    // aggiornamento delle uscite precedenti dopo la modifica degli ingressi nei rettangoli "dirty"
+    if ( mxGetField(prhs[3],0,"dirty") ) {
+        cv::Mat_<double> rects;
+        cv::Mat_<PixelType> denoised, weights;
+        mx2cv(mxGetField(prhs[3],0,"dirty"), rects);
+        if (rects.cols!=4 || !mxGetField(prhs[3],0,"prev_clean") || !mxGetField(prhs[3],0,"prev_weights") ||
+                mxGetNumberOfDimensions(prhs[0])>2 || mxGetField(prhs[3],0,"configs"))
+            mexErrMsgIdAndTxt(tool_id, "The parameter 'dirty' is not set correctly");
+        mx2cv(mxGetField(prhs[3],0,"prev_clean"), denoised);
+        mx2cv(mxGetField(prhs[3],0,"prev_weights"), weights);
+        if (denoised.size()!=noisy.size() || weights.size()!=noisy.size())
+            mexErrMsgIdAndTxt(tool_id, "The previous outputs are not valid");
+        std::vector<cv::Rect> dirty;
+        for(int k=0; k<rects.rows; k++)
+            dirty.push_back(cv::Rect((int) rects(k,1)-1, (int) rects(k,0)-1, (int) rects(k,3), (int) rects(k,2)));
+        guided_nlmeans_update<PixelType, PixelGuidaType, DistanceSar_int_sum<PixelType>, DistanceAwgnVec<PixelType, GUIDA_NUM_BANDS > >(
+                noisy, guida, valClass, dirty, denoised, weights, opt);
+        plhs[0] = cv2mx(denoised);
+        if (nlhs>1) plhs[1] = cv2mx(weights);
+        if (nlhs>2) plhs[2] = GuidedNLMeansInfo2mx(info);
+        return;
+    }
+    
+    // rettangolo di interesse [prima riga, prima colonna, righe, colonne] (da 1)
+    if ( mxGetField(prhs[3],0,"roi") ) {
+        const mxArray *mx_roi = mxGetField(prhs[3],0,"roi");
+        if (mxGetNumberOfElements(mx_roi)!=4 || mxGetNumberOfDimensions(prhs[0])>2 || mxGetField(prhs[3],0,"configs"))
+            mexErrMsgIdAndTxt(tool_id, "The parameter 'roi' is not set correctly");
+        double *r = mxGetPr(mx_roi);
+        cv::Rect roi((int) r[1]-1, (int) r[0]-1, (int) r[3], (int) r[2]);
+        if (roi.x<0 || roi.y<0 || roi.width<1 || roi.height<1 || roi.x+roi.width>noisy.cols || roi.y+roi.height>noisy.rows)
+            mexErrMsgIdAndTxt(tool_id, "The parameter 'roi' is not set correctly");
+        cv::Mat_<PixelType> denoised, weights;
+        guided_nlmeans_roi<PixelType, PixelGuidaType, DistanceSar_int_sum<PixelType>, DistanceAwgnVec<PixelType, GUIDA_NUM_BANDS > >(
+                noisy, guida, valClass, roi, denoised, weights, opt);
+        plhs[0] = cv2mx(denoised);
+        if (nlhs>1) plhs[1] = cv2mx(weights);
+        if (nlhs>2) plhs[2] = GuidedNLMeansInfo2mx(info);
+        return;
+    }
+    
+    // elaborazione entro il tempo "deadline" (in secondi)
+    if ( mxGetField(prhs[3],0,"deadline") ) {
+        double budget = mxGetScalar(mxGetField(prhs[3],0,"deadline"));
+        if (!(budget>0) || mxGetNumberOfDimensions(prhs[0])>2 || mxGetField(prhs[3],0,"configs"))
+            mexErrMsgIdAndTxt(tool_id, "The parameter 'deadline' is not set correctly");
+        cv::Mat_<PixelType> denoised, weights;
+        guided_nlmeans_deadline<PixelType, PixelGuidaType, DistanceSar_int_sum<PixelType>, DistanceAwgnVec<PixelType, GUIDA_NUM_BANDS > >(
+                noisy, guida, valClass, denoised, weights, opt, budget);
+        plhs[0] = cv2mx(denoised);
+        if (nlhs>1) plhs[1] = cv2mx(weights);
+        if (nlhs>2) plhs[2] = GuidedNLMeansInfo2mx(info);
+        return;
+    }
+    
+    // serie multi-temporale o canali SAR (lungo la terza dimensione) con una sola guida
+    if ( mxGetNumberOfDimensions(prhs[0])>2 ) {
+        if ( mxGetField(prhs[3],0,"configs") ) mexErrMsgIdAndTxt(tool_id, "The parameter 'configs' is not supported with a time series");
+        bool channels = mxGetField(prhs[3],0,"sar_channels") && ( mxGetScalar( mxGetField(prhs[3],0,"sar_channels") ) != 0 );
+        std::vector< cv::Mat_<PixelType> > dates, denoised, weights;
+        mx2cv(prhs[0], dates);
+        if (guida.rows!=noisy.rows || guida.cols!=noisy.cols/(int)dates.size()) mexErrMsgIdAndTxt(tool_id, "The guide image is not valid");
+        if (channels)
+            guided_nlmeans_channels<PixelType, PixelGuidaType, DistanceSar_int_sum<PixelType>, DistanceAwgnVec<PixelType, GUIDA_NUM_BANDS > >(
+                dates, guida, valClass, denoised, weights, opt);
+        else
+            guided_nlmeans_temporal<PixelType, PixelGuidaType, DistanceSar_int_sum<PixelType>, DistanceAwgnVec<PixelType, GUIDA_NUM_BANDS > >(
+                dates, guida, valClass, denoised, weights, opt);
+        plhs[0] = cv2mx(denoised);
+        if (nlhs>1) plhs[1] = cv2mx(weights);
+        if (nlhs>2) plhs[2] = GuidedNLMeansInfo2mx(info);
+        return;
+    }
+    
+    // piu' configurazioni in un solo passo: uscite affiancate lungo la terza dimensione
+    if ( mxGetField(prhs[3],0,"configs") ) {
+        std::vector< GuidedNLMeansConfig<PixelType> > configs;
+        mx2GuidedNLMeansConfigs(mxGetField(prhs[3],0,"configs"), opt, configs);
+        std::vector< cv::Mat_<PixelType> > denoised, weights;
+        guided_nlmeans_multi<PixelType, PixelGuidaType, DistanceSar_int_sum<PixelType>, DistanceAwgnVec<PixelType, GUIDA_NUM_BANDS > >(
+                noisy, guida, valClass, denoised, weights, opt, configs);
+        plhs[0] = cv2mx(denoised);
+        if (nlhs>1) plhs[1] = cv2mx(weights);
+        if (nlhs>2) plhs[2] = GuidedNLMeansInfo2mx(info);
+        return;
+    }
+    
     cv::Mat_<PixelType> denoised( noisy.size() );
     cv::Mat_<PixelType> weights( noisy.size() );
 	guided_nlmeans<PixelType, PixelGuidaType, DistanceSar_int_sum<PixelType>, DistanceAwgnVec<PixelType, GUIDA_NUM_BANDS > >(
@@ -106,5 +380,26 @@ void mexFunction(int nlhs, mxArray *plhs[],
 
 	plhs[0] = cv2mx(denoised);
 	if (nlhs>1) plhs[1] = cv2mx(weights);
+	if (nlhs>2) plhs[2] = GuidedNLMeansInfo2mx(info);
+
+}
+
+void mexFunction(int nlhs, mxArray *plhs[],
+    int nrhs, const mxArray *prhs[]) {
 
+    // l'errore della funzione di anteprima e' rilanciato dopo la distruzione degli
+    // oggetti di guided_nlmeans_mex (mexErrMsgIdAndTxt non ritorna)
+    static char message[1024];
+    try {
+        guided_nlmeans_mex(nlhs, plhs, nrhs, prhs);
+        return;
+    } catch (PreviewError &e) {
+        mxArray *text = mxGetProperty(e.exception, 0, "message");
+        char *str = text ? mxArrayToString(text) : 0;
+        snprintf(message, sizeof(message), "Error in the 'preview' function: %s", str ? str : "unknown error");
+        if (str) mxFree(str);
+        if (text) mxDestroyArray(text);
+        mxDestroyArray(e.exception);
+    }
+    mexErrMsgIdAndTxt(tool_id, "%s", message);
 }
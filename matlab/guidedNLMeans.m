@@ -1,4 +1,4 @@
-function [ y, w_sum ] = guidedNLMeans( z, numLook, guide, stack_size, sharpness, balance, th_sar, block_size, win_size, stride)
+function [ y, w_sum, info ] = guidedNLMeans( z, numLook, guide, stack_size, sharpness, balance, th_sar, block_size, win_size, stride, options)
 % GNLM - Guided Non-Local Means
 % Date released 10/12/2018, version BETA.
 % Code for the guided denoising of a SAR image corrupted
@@ -9,10 +9,12 @@ function [ y, w_sum ] = guidedNLMeans( z, numLook, guide, stack_size, sharpness,
 % Please refer to this papers for a more detailed description of the algorithm.
 %
 %
-%   IMA_FIL = guidedNLMeans(IMA_NSE, L, GUIDE, STACK_SIZE, SHARPNESS, BALANCE, TH_SAR, BLOCK_SIZE, WIN_SIZE, STRIDE)
+%   [IMA_FIL, W_SUM, INFO] = guidedNLMeans(IMA_NSE, L, GUIDE, STACK_SIZE, SHARPNESS, BALANCE, TH_SAR, BLOCK_SIZE, WIN_SIZE, STRIDE, OPTIONS)
 %
 %       ARGUMENT DESCRIPTION:
-%               IMA_NSE    - Noisy image (in square root intensity) 
+%               IMA_NSE    - Noisy image (in square root intensity); for a time series of
+%                            co-registered dates sharing GUIDE, dates along the 3rd dimension
+%                            (or channels, see sar_channels)
 %               L          - Number of looks of the noisy image
 %               GUIDE      - Guide image (in [0,255] range)
 %               STACK_SIZE - Maximum size of the 3rd dimension of the stack (default 256, for sharpness configuration)
@@ -22,9 +24,122 @@ function [ y, w_sum ] = guidedNLMeans( z, numLook, guide, stack_size, sharpness,
 %               BLOCK_SIZE - Number of rows/cols of the block (default 8)
 %               WIN_SIZE   - Diameter of the search area (default 39)
 %               STRIDE     - Dimension of step in sliding window processing (default 3)
+%               OPTIONS    - Struct of optional processing settings (default struct()), fields:
+%                   incremental - if true and STRIDE is 1, block distances are updated
+%                                 column by column along each row (default false)
+%                   symmetric_cache - memory (MB) of the cache that reuses the distances
+%                                 between pairs of reference blocks (default 0, disabled)
+%                   guide_bound - if true, candidates are rejected by a lower bound of the
+%                                 guide distance computed from block statistics (default false)
+%                   sar_bound   - if true, candidates failing the SAR test are rejected by a
+%                                 lower bound computed from block log-means (default false)
+%                   pca_dims    - if positive, blocks are selected with guide distances approximated
+%                                 by distances between PCA descriptors of this size, e.g. 16-32;
+%                                 the weights use the exact distances of the selected blocks (default 0)
+%                   pca_rerank  - with pca_dims, PCA_RERANK*STACK_SIZE candidates are re-ranked
+%                                 by the exact guide distance (default 0, disabled); INFO reports
+%                                 the captured energy, the stack entries changed by re-ranking and
+%                                 the exact guide distances avoided (pca_avoided)
+%                   knn_candidates - if positive, only this number of candidates, the nearest
+%                                 to the reference in the PCA descriptor space (pca_dims, default
+%                                 16) found with per-tile kd-trees, are tested and scored exactly;
+%                                 useful with large WIN_SIZE (default 0, exhaustive search)
+%                   patch_match - if true, approximate matching: offsets selected by the
+%                                 neighbouring references plus pm_samples random positions
+%                                 (default 64), refined for pm_passes passes (default 3)
+%                                 around the selected blocks (default false)
+%                   pyr_levels  - if positive, coarse-to-fine matching: exhaustive search on
+%                                 the coarsest of PYR_LEVELS 2x reduced levels of the log-SAR and
+%                                 guide images, then only the pyr_survivors best offsets (default
+%                                 64) are refined at each finer level (default 0, disabled)
+%                   propagate   - if true, the blocks matched for the previous reference set
+%                                 an initial distance threshold, so that most candidates are
+%                                 rejected by the guide distance alone; the result is identical
+%                                 to the exhaustive search (default false)
+%                   sampling    - search on a subset of the window offsets: 0 = exhaustive,
+%                                 1 = uniform random, 2 = stratified (jittered grid), 3 = density
+%                                 decreasing with the distance from the centre (default 0)
+%                   sample_budget - fraction of the window area evaluated with sampling, in
+%                                 (0,1] (default 0.25)
+%                   adaptive_step - if larger than STRIDE, reference blocks use this stride
+%                                 (at most BLOCK_SIZE, so every pixel is covered) except on the
+%                                 adaptive_fraction (default 0.3) least homogeneous blocks, by
+%                                 guide gradient energy and SAR variation coefficient, which keep
+%                                 STRIDE (default 0, fixed stride)
+%                   diameters   - matrix of the search diameters of the reference blocks (at
+%                                 least size(IMA_NSE)-BLOCK_SIZE+1, top-left pixel of the block),
+%                                 clipped to WIN_SIZE and made odd (default [], WIN_SIZE everywhere)
+%                   min_search_diameter - if positive and diameters is not given, the search
+%                                 diameter decreases from WIN_SIZE in homogeneous areas to this
+%                                 value on edges and textures, by the same measure of adaptive_step
+%                                 (default 0, disabled); INFO reports the searched positions
+%                   stack_tolerance - if positive, the blocks of the stack whose weights sum to
+%                                 less than this fraction of the total weight are left out of
+%                                 the average, e.g. 1e-3 (default 0, whole stack); INFO reports the
+%                                 number of averaged blocks
+%                   aggregate_all - if true, the estimate of each stack is aggregated on all
+%                                 its blocks, weighted by their similarity to the reference, and
+%                                 not only on the reference block; allows STRIDE 6-8 (default false)
+%                   configs     - K x 2 matrix of [STACK_SIZE SHARPNESS] settings: a single block
+%                                 matching pass, with the largest stack, produces the K outputs
+%                                 IMA_FIL(:,:,k) and W_SUM(:,:,k); STACK_SIZE and SHARPNESS
+%                                 arguments are then ignored (default [], single output)
+%                   sweep       - struct of vectors stack_size, sharpness, balance and th_sar
+%                                 (a missing field takes the argument value): one output for each
+%                                 combination, IMA_FIL(:,:,k), with a single block matching pass at
+%                                 the loosest TH_SAR; INFO.sweep lists the combinations in the
+%                                 order of the outputs, one per row (default [], overrides configs)
+%                   temporal_joint - with a time series, if true all dates share the block
+%                                 selection and weights, from the mean SAR distance of the dates;
+%                                 otherwise each date has its own test, selection and weights
+%                                 (default false); in both cases guide distances are computed once
+%                                 for all dates and INFO reports their number
+%                   sar_channels - if true, the 3rd dimension of IMA_NSE holds co-registered
+%                                 channels (e.g. VV and VH) filtered jointly: one block matching
+%                                 with the sum of the SAR distances of the channels, and the same
+%                                 blocks and weights for every channel (default false)
+%                   guide_cache - file name of a cache of the guide distances, keyed by the GUIDE
+%                                 pixels, BLOCK_SIZE, WIN_SIZE and STRIDE: written by the first run and
+%                                 read (memory mapped) by the next ones on the same GUIDE, which skip
+%                                 the guide distances; uses 4*WIN_SIZE^2 bytes per reference block and
+%                                 only the exhaustive search with fixed STRIDE and WIN_SIZE (default '',
+%                                 disabled); INFO.guide_cache is 1 if written, 2 if read
+%                   roi         - [FIRST_ROW FIRST_COL ROWS COLS] region of interest: only the region
+%                                 with the needed border is processed and IMA_FIL, W_SUM are of size
+%                                 [ROWS COLS], equal to the same region of the whole-image result with
+%                                 the exhaustive search and fixed STRIDE (default [], whole image)
+%                   dirty       - K x 4 matrix of [FIRST_ROW FIRST_COL ROWS COLS] regions where IMA_NSE,
+%                                 GUIDE or the validity changed since a previous run, whose outputs are
+%                                 given in the field previous (struct with fields y and w_sum): only the
+%                                 outputs influenced by the regions are recomputed (default [])
+%                   preview_passes - if larger than 1, progressive processing: the first pass uses
+%                                 reference blocks at 2^(PREVIEW_PASSES-1)*STRIDE, each following pass
+%                                 halves the spacing, and the final result is the same as without
+%                                 passes (default 0, single pass). The blocks matched in the previous
+%                                 passes are kept for the final one: about 25% of the reference blocks
+%                                 x STACK_SIZE x 12 bytes (16 with configs)
+%                   preview     - function handle called after each pass as preview(Y, PASS, PASSES),
+%                                 with Y the current estimate, as IMA_FIL (default [], none); an error
+%                                 in the function stops the processing and is reported by guidedNLMeans
+%                   deadline    - time budget in seconds: the time per reference block is estimated
+%                                 on a sample of the image and the first setting in the sequence
+%                                 (STRIDE, WIN_SIZE, STACK_SIZE) -> larger STRIDE -> smaller WIN_SIZE ->
+%                                 smaller STACK_SIZE whose estimate fits is used, falling back to
+%                                 cheaper ones strip by strip if late (default [], no limit); INFO
+%                                 reports the chosen setting (deadline_*) and the time spent
 %
 %       OUTPUT DESCRIPTION:
-%               IMA_FIL  - Filtered image (in square root intensity)
+%               IMA_FIL  - Filtered image (in square root intensity), one per date of a time series
+%               W_SUM    - Sum of the weights for each reference block
+%               INFO     - Struct of processing statistics (e.g. cache hit counters); search_mode is
+%                          the block matching actually used (0 exhaustive, 1 incremental, 2 knn,
+%                          3 patch_match, 4 pyramid, 5 sampling, 6 propagate, 7 pca, 8 guide_cache)
+%                          and ignored_options the sum of the requested OPTIONS that were not used,
+%                          because of the precedence among search modes, configs/sweep (exhaustive
+%                          search only) or preview passes: 1 incremental, 2 knn_candidates,
+%                          4 patch_match, 8 pyr_levels, 16 sampling, 32 propagate, 64 pca_dims,
+%                          128 guide_cache, 256 symmetric_cache, 512 guide_bound, 1024 sar_bound,
+%                          2048 preview_passes, 4096 adaptive_step, 8192 min_search_diameter/diameters
 %
 %       NOTE:
 %         for smoothness configuration, set SHARPNESS to 0.004 and STACKSIZE to WIN_SIZE^2
@@ -43,6 +158,7 @@ function [ y, w_sum ] = guidedNLMeans( z, numLook, guide, stack_size, sharpness,
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
 	%%% Default parameters
+	if nargin<11, options    = struct(); end;
 	if nargin<10, stride     =  3;    end;
 	if nargin< 9, win_size   = 39;    end;
 	if nargin< 8, block_size =  8;    end;
@@ -51,8 +167,11 @@ function [ y, w_sum ] = guidedNLMeans( z, numLook, guide, stack_size, sharpness,
 	if nargin< 5, sharpness  = 0.002; end;
 	if nargin< 4, stack_size = 256;   end;
 	
-    %%% Removal of zeros
-    z = removezeros(double(z));
+    %%% Removal of zeros (for each date of a time series)
+    z = double(z);
+    for t = 1:size(z,3)
+        z(:,:,t) = removezeros(z(:,:,t));
+    end
     
     %%% Guida:
     guide = double(guide);
@@ -62,6 +181,11 @@ function [ y, w_sum ] = guidedNLMeans( z, numLook, guide, stack_size, sharpness,
     sigm_sar = block_size * sqrt(0.5*psi(1, numLook) - psi(1, 2*numLook));
     mu_sar   = block_size * block_size * (psi(0,2*numLook)-psi(0,numLook)-log(2));
     mu_guide = block_size * block_size * numBands;
+    if isfield(options, 'sar_channels') && options.sar_channels
+        %%%% Joint channels: statistics of the sum of the SAR distances
+        sigm_sar = sigm_sar * sqrt(size(z,3));
+        mu_sar   = mu_sar   * size(z,3);
+    end
     
     %%%% Parameters:
     opt = struct();
@@ -76,17 +200,54 @@ function [ y, w_sum ] = guidedNLMeans( z, numLook, guide, stack_size, sharpness,
     opt.lambda1   = sharpness*      balance  / mu_sar;
     opt.lambda2   = sharpness*(1.0- balance) / mu_guide;
     
+    %%%% Optional settings:
+    names = fieldnames(options);
+    for i = 1:numel(names)
+        opt.(names{i}) = options.(names{i});
+    end
+    if isfield(options, 'configs')
+        %%%% Settings of the single-pass outputs: [S_dim lambda1 lambda2]
+        cfg = double(options.configs);
+        opt.configs = [cfg(:,1), cfg(:,2)*balance/mu_sar, cfg(:,2)*(1.0-balance)/mu_guide];
+        opt.S_dim   = max(cfg(:,1));
+    end
+    if isfield(options, 'dirty')
+        %%%% Outputs of the previous run (in intensity)
+        opt = rmfield(opt, 'previous');
+        opt.prev_clean   = double(options.previous.y).^2;
+        opt.prev_weights = double(options.previous.w_sum);
+    end
+    if isfield(options, 'preview')
+        %%%% Preview in square root intensity
+        opt.preview = @(y_int, pass, passes) options.preview(sqrt(y_int), pass, passes);
+    end
+    sweep_grid = [];
+    if isfield(options, 'sweep')
+        %%%% Grid of weightings [S_dim sharpness balance th_sar], missing fields set by the arguments
+        sw = options.sweep;
+        if ~isfield(sw, 'stack_size'), sw.stack_size = stack_size; end;
+        if ~isfield(sw, 'sharpness'),  sw.sharpness  = sharpness;  end;
+        if ~isfield(sw, 'balance'),    sw.balance    = balance;    end;
+        if ~isfield(sw, 'th_sar'),     sw.th_sar     = th_sar;     end;
+        [g_S, g_sharp, g_bal, g_th] = ndgrid(double(sw.stack_size), double(sw.sharpness), double(sw.balance), double(sw.th_sar));
+        sweep_grid  = [g_S(:), g_sharp(:), g_bal(:), g_th(:)];
+        opt.configs = [g_S(:), g_sharp(:).*g_bal(:)/mu_sar, g_sharp(:).*(1.0-g_bal(:))/mu_guide, sigm_sar*g_th(:)+mu_sar];
+        opt.S_dim   = max(g_S(:));
+    end
+    
     %%%% Elaboration:
     z_int = z.^2;
+    valid = true(size(z,1), size(z,2));
     if numBands<=4
-		[y_int,w_sum] = guidedNLMeans_b04(z_int, guide, true(size(z)), opt);
+		[y_int,w_sum,info] = guidedNLMeans_b04(z_int, guide, valid, opt);
 	elseif numBands<=8
-		[y_int,w_sum] = guidedNLMeans_b08(z_int, guide, true(size(z)), opt);
+		[y_int,w_sum,info] = guidedNLMeans_b08(z_int, guide, valid, opt);
 	elseif numBands<=16
-	    [y_int,w_sum] = guidedNLMeans_b16(z_int, guide, true(size(z)), opt);
+	    [y_int,w_sum,info] = guidedNLMeans_b16(z_int, guide, valid, opt);
 	else
-	    [y_int,w_sum] = guidedNLMeans_b32(z_int, guide, true(size(z)), opt);
+	    [y_int,w_sum,info] = guidedNLMeans_b32(z_int, guide, valid, opt);
 	end
 	y = sqrt(y_int);
+	if ~isempty(sweep_grid), info.sweep = sweep_grid; end;
 end
 
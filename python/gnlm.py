@@ -0,0 +1,132 @@
+# %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+#
+# Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+# All rights reserved.
+# This software should be used, reproduced and modified only for informational and nonprofit purposes.
+#
+# By downloading and/or using any of these files, you implicitly agree to all the
+# terms of the license, as specified in the document LICENSE.txt
+# (included in this package) and online at
+# http://www.grip.unina.it/download/LICENSE_OPEN.txt
+#
+# %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+"""
+GNLM - interfaccia ctypes della libreria C (src/capi/gnlm.h).
+
+    clean, w_sum = gnlm_run(noisy, guide, mask=None, **profile)
+
+noisy (righe x colonne, intensita'), guide (righe x colonne x bande) e le
+uscite sono passati con i loro "strides": gli array float32 con le colonne
+contigue (anche viste ritagliate) non sono copiati, e ctypes rilascia il GIL
+durante l'elaborazione. I parametri di profile sono i campi di gnlm_profile
+(block_size, stack_size, search_diameter, step, alpha, lambda1, lambda2,
+thDist, ...). La libreria e' cercata in GNLM_LIBRARY o in src/capi/libgnlm.so.
+"""
+import ctypes
+import os
+import numpy as np
+
+
+class _Buffer(ctypes.Structure):
+    _fields_ = [('data', ctypes.c_void_p), ('rows', ctypes.c_int), ('cols', ctypes.c_int), ('bands', ctypes.c_int),
+                ('row_stride', ctypes.c_ssize_t), ('col_stride', ctypes.c_ssize_t), ('band_stride', ctypes.c_ssize_t)]
+
+
+class _Profile(ctypes.Structure):
+    _fields_ = [('size', ctypes.c_size_t), ('block_size', ctypes.c_int), ('stack_size', ctypes.c_int),
+                ('search_diameter', ctypes.c_int), ('step', ctypes.c_int),
+                ('tau_match', ctypes.c_double), ('beta', ctypes.c_double), ('alpha', ctypes.c_double),
+                ('lambda1', ctypes.c_double), ('lambda2', ctypes.c_double), ('thDist', ctypes.c_double),
+                ('incremental', ctypes.c_int), ('symmetric_cache', ctypes.c_double),
+                ('guide_bound', ctypes.c_int), ('sar_bound', ctypes.c_int),
+                ('pca_dims', ctypes.c_int), ('pca_rerank', ctypes.c_int), ('knn_candidates', ctypes.c_int),
+                ('patch_match', ctypes.c_int), ('pm_passes', ctypes.c_int), ('pm_samples', ctypes.c_int),
+                ('pyr_levels', ctypes.c_int), ('pyr_survivors', ctypes.c_int), ('propagate', ctypes.c_int),
+                ('sampling', ctypes.c_int), ('sample_budget', ctypes.c_double),
+                ('adaptive_step', ctypes.c_int), ('adaptive_fraction', ctypes.c_double),
+                ('min_search_diameter', ctypes.c_int), ('stack_tolerance', ctypes.c_double),
+                ('aggregate_all', ctypes.c_int)]
+
+
+class _Info(ctypes.Structure):
+    _fields_ = [('size', ctypes.c_size_t), ('references', ctypes.c_double), ('search_positions', ctypes.c_double),
+                ('stack_blocks', ctypes.c_double), ('guide_distances', ctypes.c_double), ('copies', ctypes.c_int)]
+
+
+_lib = None
+
+
+def _library():
+    global _lib
+    if _lib is None:
+        path = os.environ.get('GNLM_LIBRARY',
+                              os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'src', 'capi', 'libgnlm.so'))
+        _lib = ctypes.CDLL(path)
+        _lib.gnlm_profile_init.argtypes = [ctypes.POINTER(_Profile)]
+        _lib.gnlm_info_init.argtypes = [ctypes.POINTER(_Info)]
+        _lib.gnlm_run.argtypes = [ctypes.POINTER(_Profile)] + [ctypes.POINTER(_Buffer)] * 5 + [ctypes.POINTER(_Info)]
+        _lib.gnlm_run.restype = ctypes.c_int
+        _lib.gnlm_error_string.argtypes = [ctypes.c_int]
+        _lib.gnlm_error_string.restype = ctypes.c_char_p
+    return _lib
+
+
+def _buffer(a, dtype):
+    # array di tipo "dtype" (copiato solo se di altro tipo), descritto dai suoi strides
+    a = np.asarray(a)
+    if a.dtype != dtype:
+        a = a.astype(dtype)
+    rows, cols = a.shape[:2]
+    bands = a.shape[2] if a.ndim > 2 else 1
+    band_stride = a.strides[2] if a.ndim > 2 else a.itemsize
+    return a, _Buffer(a.ctypes.data, rows, cols, bands, a.strides[0], a.strides[1], band_stride)
+
+
+def gnlm_run(noisy, guide, mask=None, clean=None, w_sum=None, info=None, **profile):
+    """
+    Guided NLM di "noisy" con la guida "guide" e la maschera dei pixel validi
+    "mask" (None = tutti). "clean" e "w_sum" possono essere array float32
+    preallocati, scritti al loro posto; possono anche condividere memoria con
+    gli ingressi (es. clean=noisy): in quel caso, o se si sovrappongono tra
+    loro, sono calcolati a parte e copiati alla fine (w_sum dopo clean). Se
+    "info" e' un dizionario, riceve le statistiche (references, ..., copies).
+    """
+    lib = _library()
+    p = _Profile()
+    lib.gnlm_profile_init(ctypes.byref(p))
+    for name, value in profile.items():
+        if name not in dict(_Profile._fields_) or name == 'size':
+            raise TypeError('unknown parameter %s' % name)
+        setattr(p, name, value)
+
+    noisy, b_noisy = _buffer(noisy, np.float32)
+    guide = np.asarray(guide)
+    if guide.ndim == 2:
+        guide = guide[:, :, None]
+    guide, b_guide = _buffer(guide, np.float32)
+    b_mask = None
+    if mask is not None:
+        mask = np.asarray(mask)
+        if mask.dtype != np.bool_ and mask.dtype != np.uint8:
+            mask = mask != 0
+        mask, b_mask = _buffer(mask, mask.dtype)
+    if clean is None:
+        clean = np.empty(noisy.shape[:2], np.float32)
+    if w_sum is None:
+        w_sum = np.empty(noisy.shape[:2], np.float32)
+    if clean.dtype != np.float32 or w_sum.dtype != np.float32:
+        raise TypeError('the outputs must be float32')
+    clean, b_clean = _buffer(clean, np.float32)
+    w_sum, b_sum = _buffer(w_sum, np.float32)
+
+    stats = _Info()
+    lib.gnlm_info_init(ctypes.byref(stats))
+    code = lib.gnlm_run(ctypes.byref(p), ctypes.byref(b_noisy), ctypes.byref(b_guide),
+                        ctypes.byref(b_mask) if b_mask is not None else None,
+                        ctypes.byref(b_clean), ctypes.byref(b_sum), ctypes.byref(stats))
+    if code != 0:
+        raise RuntimeError('gnlm_run: %s' % lib.gnlm_error_string(code).decode())
+    if info is not None:
+        for name, _ in _Info._fields_[1:]:
+            info[name] = getattr(stats, name)
+    return clean, w_sum
@@ -31,6 +31,14 @@
 #include <limits>
 #include "core/block_matching.h"
 #include "core/block_matching_duo.hpp"
+#include "core/sliding_distance.hpp"
+#include "core/distance_cache.hpp"
+#include "core/descriptor_forest.hpp"
+#include "core/patch_match.hpp"
+#include "core/pyramid_search.hpp"
+#include "core/block_matching_seeded.hpp"
+#include "core/block_matching_temporal.hpp"
+#include "core/guide_cache.hpp"
 #include "core/aggregation.h"
 #include "core/collaborative_means.h"
 #include "utils/buffers.h"
@@ -38,12 +46,128 @@
 #include "utils/stripe.h"
 #include "utils/stripe_mat.h"
 #include "utils/stepper.h"
+#include "utils/homogeneity.h"
+#include "utils/wall_clock.h"
 #include "core/speckle/distanceSar_int_sum.hpp"
+#include "core/speckle/distanceSar_bound.hpp"
 #include "core/awgn/distanceAwgnVec.h"
 #include "core/awgn/distanceAwgn.h"
+#include "core/awgn/distanceAwgnBound.h"
+#include "core/awgn/pcaDescriptors.h"
 
 
 
+/*
+ * Statistiche dell'elaborazione (riempite se GuidedNLMeansProfile::info non e' nullo)
+ */
+struct GuidedNLMeansInfo
+{
+	/* block matching effettivamente usato (search_mode) */
+	enum Search { EXHAUSTIVE = 0, INCREMENTAL = 1, KNN = 2, PATCH_MATCH = 3, PYRAMID = 4,
+		SAMPLING = 5, PROPAGATE = 6, PCA = 7, GUIDE_CACHE = 8 };
+
+	/* opzioni del profilo (ignored_options e' la somma di quelle richieste ma non usate) */
+	enum Option { OPTION_INCREMENTAL = 1, OPTION_KNN = 2, OPTION_PATCH_MATCH = 4, OPTION_PYRAMID = 8,
+		OPTION_SAMPLING = 16, OPTION_PROPAGATE = 32, OPTION_PCA = 64, OPTION_GUIDE_CACHE = 128,
+		OPTION_SYMMETRIC_CACHE = 256, OPTION_GUIDE_BOUND = 512, OPTION_SAR_BOUND = 1024, OPTION_PREVIEW = 2048,
+		OPTION_ADAPTIVE_STEP = 4096, OPTION_DIAMETERS = 8192 };
+
+	/* modalita' effettive */
+	double search_mode;			// block matching usato (Search)
+	double ignored_options;		// opzioni richieste e non usate (somma di Option): precedenze, piu' configurazioni, anteprime
+
+	/* cache simmetrica delle distanze */
+	double cache_lookups;		// distanze richieste
+	double cache_hits;			// distanze lette dalla cache
+	double cache_bytes;			// memoria occupata dalla cache
+
+	/* limite inferiore della distanza della guida */
+	double guide_bound_tests;	// candidati valutati con il limite
+	double guide_bound_rejects;	// candidati scartati senza calcolare le distanze
+
+	/* limite inferiore della distanza SAR */
+	double sar_bound_tests;		// candidati valutati con il limite
+	double sar_bound_rejects;	// candidati scartati senza calcolare le distanze
+
+	/* descrittori PCA della guida */
+	double pca_dims;			// dimensione dei descrittori
+	double pca_energy;			// frazione dell'energia dei blocchi catturata dai descrittori
+	double pca_rerank_changes;	// blocchi dello stack cambiati dal re-ranking esatto
+	double pca_avoided;			// distanze esatte della guida evitate (candidati meno distanze calcolate)
+
+	/* preselezione dei candidati con i kd-tree dei descrittori */
+	double knn_queries;			// ricerche effettuate
+	double knn_distances;		// distanze tra descrittori calcolate
+
+	/* block matching approssimato (PatchMatch) */
+	double pm_references;		// riferimenti elaborati
+	double pm_evaluations;		// posizioni valutate
+
+	/* preselezione multiscala dei candidati */
+	double pyr_references;		// riferimenti elaborati
+	double pyr_evaluations;		// punteggi calcolati ai livelli ridotti
+	double pyr_candidates;		// candidati valutati al livello originale
+
+	/* soglia iniziale dai blocchi del riferimento precedente */
+	double seed_evaluations;	// "seed" valutati
+	double seed_references;		// riferimenti con soglia iniziale
+	double seed_pruned;			// candidati scartati con la soglia iniziale
+
+	/* griglia dei "reference block" */
+	double references;			// "reference block" elaborati
+
+	/* zona di ricerca adattativa */
+	double search_positions;	// posizioni dei vicinati dei "reference block" (somma delle aree)
+
+	/* troncamento degli stack */
+	double stack_blocks;		// blocchi mediati (somma sugli stack)
+
+	/* serie multi-temporale */
+	double guide_distances;		// distanze della guida calcolate (condivise dalle date)
+
+	/* cache su file delle distanze della guida */
+	double guide_cache;			// 0 = non usata, 1 = calcolata e scritta, 2 = letta dal file
+
+	/* elaborazione con scadenza */
+	double deadline_step;		// passo dei "reference block" scelto
+	double deadline_diameter;	// diametro della zona di ricerca scelto
+	double deadline_stack;		// lunghezza massima dello stack scelta
+	double deadline_estimate;	// tempo previsto (s) con le impostazioni scelte
+	double deadline_time;		// tempo impiegato (s), compresa la stima
+	double deadline_tiles;		// strisce elaborate
+	double deadline_fallbacks;	// strisce elaborate con impostazioni piu' economiche di quelle scelte
+
+	GuidedNLMeansInfo() : search_mode(0), ignored_options(0), cache_lookups(0), cache_hits(0), cache_bytes(0),
+		guide_bound_tests(0), guide_bound_rejects(0),
+		sar_bound_tests(0), sar_bound_rejects(0),
+		pca_dims(0), pca_energy(0), pca_rerank_changes(0), pca_avoided(0),
+		knn_queries(0), knn_distances(0),
+		pm_references(0), pm_evaluations(0),
+		pyr_references(0), pyr_evaluations(0), pyr_candidates(0),
+		seed_evaluations(0), seed_references(0), seed_pruned(0),
+		references(0), search_positions(0), stack_blocks(0), guide_distances(0), guide_cache(0),
+		deadline_step(0), deadline_diameter(0), deadline_stack(0), deadline_estimate(0),
+		deadline_time(0), deadline_tiles(0), deadline_fallbacks(0) {}
+};
+
+/*
+ * Configurazione del filtraggio collaborativo (lunghezza dello stack, pesi e
+ * soglia del test SAR), per produrre piu' uscite con un solo block matching
+ * (guided_nlmeans_multi)
+ */
+template <typename PixelType>
+struct GuidedNLMeansConfig
+{
+	int max_matched;			// numero massimo di blocchi dello stack
+	PixelType lambda1;			// peso della distanza SAR
+	PixelType lambda2;			// peso della distanza della guida
+	PixelType thDist;			// soglia della distanza SAR (NaN = soglia del profilo)
+
+	GuidedNLMeansConfig(int max_matched_, PixelType lambda1_, PixelType lambda2_,
+			PixelType thDist_ = std::numeric_limits<PixelType>::quiet_NaN())
+		: max_matched(max_matched_), lambda1(lambda1_), lambda2(lambda2_), thDist(thDist_) {}
+};
+
 template <typename PixelType>
 struct GuidedNLMeansProfile : BlockMatchOptions<PixelType>, AggregationOptions<PixelType>
 {
@@ -59,9 +183,47 @@ struct GuidedNLMeansProfile : BlockMatchOptions<PixelType>, AggregationOptions<P
     PixelType thDist;
     PixelType lambda1;
     PixelType lambda2;
+
+	/* modalita' di elaborazione */
+	bool incremental;			// distanze incrementali per colonna (solo con step=1)
+	double symmetric_cache;		// memoria (in MB) della cache simmetrica delle distanze (0 = disattivata)
+	bool guide_bound;			// scarta i candidati con il limite inferiore della distanza della guida
+	bool sar_bound;				// scarta i candidati con il limite inferiore della distanza SAR
+	int pca_dims;				// selezione con la distanza della guida approssimata con descrittori PCA, pesi con quella esatta (0 = distanza esatta)
+	int pca_rerank;				// re-ranking esatto di pca_rerank*max_matched candidati (0 = disattivato)
+	int knn_candidates;			// candidati preselezionati con i kd-tree dei descrittori (0 = ricerca esaustiva)
+	bool patch_match;			// block matching approssimato con propagazione e ricerca casuale
+	int pm_passes;				// [PATCHMATCH] passate di raffinamento
+	int pm_samples;				// [PATCHMATCH] posizioni casuali iniziali
+	int pyr_levels;				// livelli ridotti per la preselezione multiscala (0 = disattivata)
+	int pyr_survivors;			// [PIRAMIDE] offset conservati ad ogni livello
+	bool propagate;				// soglia iniziale dai blocchi selezionati per il riferimento precedente (come la ricerca esaustiva con stable_ties)
+	int sampling;				// ricerca a campione: 0 = esaustiva, 1 = casuale, 2 = stratificata, 3 = radiale
+	double sample_budget;		// [CAMPIONE] frazione dell'area del vicinato valutata
+	int adaptive_step;			// passo dei "reference block" nelle zone omogenee (0 = passo fisso)
+	double adaptive_fraction;	// [PASSO ADATTATIVO] frazione dei blocchi meno omogenei elaborati con passo "step"
+	const cv::Mat_<unsigned char> *diameters;	// diametro della zona di ricerca per ogni blocco (0 = search_diameter)
+	int min_search_diameter;	// diametro minimo della mappa automatica dei diametri (0 = disattivata)
+	double stack_tolerance;		// frazione della somma dei pesi trascurabile nella media dello stack (0 = stack intero)
+	bool aggregate_all;			// stima aggregata su tutti i blocchi dello stack (pesati), non solo sul riferimento
+	bool temporal_joint;		// [MULTI-TEMPORALE] selezione comune alle date, con la media delle distanze SAR
+	const char *guide_cache;	// file della cache delle distanze della guida (0 = disattivata)
+	cv::Rect roi;				// elabora solo i "reference block" che contribuiscono al rettangolo (vuoto = tutti)
+	int preview_passes;			// passate su reticoli di "reference block" via via piu' fitti (0 o 1 = una sola)
+	void (*preview)(const cv::Mat_<PixelType> &image, int pass, int passes, void *data);	// [ANTEPRIMA] chiamata dopo ogni passata (puo' interrompere con un'eccezione)
+	void *preview_data;			// [ANTEPRIMA] argomento di "preview"
+
+	/* statistiche d'uscita */
+	GuidedNLMeansInfo *info;
     
 	/* costruttore */
-	GuidedNLMeansProfile() {
+	GuidedNLMeansProfile() : incremental(false), symmetric_cache(0), guide_bound(false), sar_bound(false),
+			pca_dims(0), pca_rerank(0), knn_candidates(0),
+			patch_match(false), pm_passes(3), pm_samples(64),
+			pyr_levels(0), pyr_survivors(64), propagate(false),
+			sampling(0), sample_budget(0.25), adaptive_step(0), adaptive_fraction(0.3),
+			diameters(0), min_search_diameter(0), stack_tolerance(0), aggregate_all(false), temporal_joint(false), guide_cache(0),
+			preview_passes(0), preview(0), preview_data(0), info(0) {
 		config(8, 64, 39, 3, std::numeric_limits<PixelType>::infinity(), 2.0, 
                 0.5, std::numeric_limits<PixelType>::infinity(), 1, 1);
 	}
@@ -95,24 +257,75 @@ struct GuidedNLMeansProfile : BlockMatchOptions<PixelType>, AggregationOptions<P
 
 };
 
+/*
+ * Opzioni del profilo richieste (somma di GuidedNLMeansInfo::Option)
+ */
+template <typename PixelType>
+int requested_options(const GuidedNLMeansProfile<PixelType> &opt) {
+	int requested = 0;
+	if (opt.incremental)                            requested |= GuidedNLMeansInfo::OPTION_INCREMENTAL;
+	if (opt.knn_candidates>0)                       requested |= GuidedNLMeansInfo::OPTION_KNN;
+	if (opt.patch_match)                            requested |= GuidedNLMeansInfo::OPTION_PATCH_MATCH;
+	if (opt.pyr_levels>0)                           requested |= GuidedNLMeansInfo::OPTION_PYRAMID;
+	if (opt.sampling>0)                             requested |= GuidedNLMeansInfo::OPTION_SAMPLING;
+	if (opt.propagate)                              requested |= GuidedNLMeansInfo::OPTION_PROPAGATE;
+	if (opt.pca_dims>0)                             requested |= GuidedNLMeansInfo::OPTION_PCA;
+	if (opt.guide_cache)                            requested |= GuidedNLMeansInfo::OPTION_GUIDE_CACHE;
+	if (opt.symmetric_cache>0)                      requested |= GuidedNLMeansInfo::OPTION_SYMMETRIC_CACHE;
+	if (opt.guide_bound)                            requested |= GuidedNLMeansInfo::OPTION_GUIDE_BOUND;
+	if (opt.sar_bound)                              requested |= GuidedNLMeansInfo::OPTION_SAR_BOUND;
+	if (opt.preview_passes>1)                       requested |= GuidedNLMeansInfo::OPTION_PREVIEW;
+	if (opt.adaptive_step>opt.step)                 requested |= GuidedNLMeansInfo::OPTION_ADAPTIVE_STEP;
+	if (opt.diameters || opt.min_search_diameter>0) requested |= GuidedNLMeansInfo::OPTION_DIAMETERS;
+	return requested;
+}
+
 #ifdef TIME_INFO
 	#include "utils/timer.h"
 	#include "utils/time_info.h"
 #endif
 
-	
+
+/*
+ * Guided NLM con piu' configurazioni del filtraggio collaborativo: un solo
+ * block matching, con lo stack piu' lungo, e per ogni configurazione
+ * un'uscita ("clean_images") e la somma dei pesi ("sum_images"), calcolate
+ * dai primi max_matched blocchi selezionati.
+ * Con una sola configurazione il block matching usa direttamente i suoi
+ * parametri; con piu' configurazioni sono conservate le distanze SAR e della
+ * guida di ogni blocco, e non sono usate le modalita' incremental,
+ * patch_match, propagate e pca_dims (la ricerca e' esaustiva).
+ * Le opzioni del profilo non usate (per queste restrizioni, per le
+ * precedenze tra le modalita' di ricerca o per le anteprime, che escludono
+ * incremental e symmetric_cache) sono riportate in opt.info->ignored_options,
+ * con il block matching effettivo in opt.info->search_mode.
+ * Il block matching usa la soglia SAR piu' ampia; se le soglie differiscono,
+ * la lista conserva tutti i candidati del vicinato che la superano (senza
+ * limite di lunghezza, ordinati una volta per riferimento) e ogni
+ * configurazione seleziona i primi max_matched che superano la propria
+ * soglia. Con piu' configurazioni la lista usa sempre stable_ties (vedi
+ * BlockMatchingDataList): ogni uscita coincide con un block matching separato
+ * con stable_ties (con distanze identiche non con la regola di default).
+ * Con preview_passes>1 le prime passate elaborano reticoli di "reference
+ * block" via via piu' fitti (passo 2^k in unita' della griglia) e, dopo ogni
+ * passata, opt.preview riceve la stima corrente; l'ultima passata riusa i
+ * blocchi gia' selezionati e aggrega nell'ordine consueto, per cui le uscite
+ * coincidono con quelle senza anteprime (con block matching deterministico:
+ * non con patch_match e sampling casuale).
+ */
 template <typename PixelType1, typename PixelType2, typename OpDistance1, typename OpDistance2>
 #ifndef TIME_INFO
 void
 #else
 double
 #endif
-guided_nlmeans(const cv::Mat_<PixelType1> &noisy_image, 
+guided_nlmeans_multi(const cv::Mat_<PixelType1> &noisy_image, 
             const cv::Mat_<PixelType2> &guida_image, 
             const cv::Mat_<bool> &class_image, 
-            cv::Mat_<PixelType1> &clean_image,
-            cv::Mat_<PixelType1> &sum_image,
-            const GuidedNLMeansProfile<PixelType1> &opt)
+            std::vector< cv::Mat_<PixelType1> > &clean_images,
+            std::vector< cv::Mat_<PixelType1> > &sum_images,
+            const GuidedNLMeansProfile<PixelType1> &opt,
+            const std::vector< GuidedNLMeansConfig<PixelType1> > &configs)
 {
 	#ifdef TIME_INFO
 		Timer timer;
@@ -131,89 +344,428 @@ guided_nlmeans(const cv::Mat_<PixelType1> &noisy_image,
     typedef Sliding_Accessor<PixelType2> sliding2_t;
 	typedef Stack_Buffer<PixelType1> stack_t;
 
-	// immagine d'uscita
-	clean_image = PixelType1();  							 // azzera i pixel
-	sum_image   = PixelType1();  							 // azzera i pixel
+	// configurazioni: il block matching seleziona lo stack piu' lungo
+	int num_configs = (int) configs.size();
+	bool multi = num_configs > 1;
+	int max_matched = 0;
+	std::vector< PixelType1 > config_th(num_configs);
+	for(int c=0; c<num_configs; c++) {
+		max_matched  = std::max(max_matched, configs[c].max_matched);
+		config_th[c] = (configs[c].thDist == configs[c].thDist) ? configs[c].thDist : opt.thDist;
+	}
+	PixelType1 match_th = *std::max_element(config_th.begin(), config_th.end());
+	bool multi_th = false;
+	for(int c=0; c<num_configs; c++) multi_th = multi_th || (config_th[c] != match_th);
+	// con soglie diverse servono tutti i candidati sotto la soglia piu' alta: lista
+	// senza limite (max_matched = 0), ordinata una volta sola per riferimento
+	GuidedNLMeansProfile<PixelType1> match_opt( opt );
+	match_opt.max_matched = multi_th ? 0 : max_matched;
+	match_opt.stable_ties = opt.stable_ties || multi;
 
-	// immagine dei pesi (per la fase di 'aggregation')
-	cv::Mat_<PixelType1> weights_image( noisy_image.size() ); // crea la matrice
-	weights_image = PixelType1();  							 // azzera i pixel
+	// immagini d'uscita e immagini dei pesi (per la fase di 'aggregation')
+	clean_images.resize(num_configs);
+	sum_images.resize(num_configs);
+	std::vector< cv::Mat_<PixelType1> > weights_images(num_configs);
+	std::vector< sliding1_t* > clean_blocks(num_configs, (sliding1_t*) 0), weights_blocks(num_configs, (sliding1_t*) 0);
+	// accessori liberati anche se opt.preview interrompe l'elaborazione con un'eccezione
+	struct SlidingOwner {
+		std::vector< sliding1_t* > &clean, &weights;
+		SlidingOwner(std::vector< sliding1_t* > &clean_, std::vector< sliding1_t* > &weights_) : clean(clean_), weights(weights_) {}
+		~SlidingOwner() {
+			for(size_t c=0; c<clean.size(); c++) {
+				delete clean[c];
+				delete weights[c];
+			}
+		}
+	} sliding_owner( clean_blocks, weights_blocks );
+	for(int c=0; c<num_configs; c++) {
+		clean_images[c].create( noisy_image.size() );
+		sum_images[c].create( noisy_image.size() );
+		weights_images[c].create( noisy_image.size() );
+		clean_images[c]   = PixelType1();  					 // azzera i pixel
+		sum_images[c]     = PixelType1();  					 // azzera i pixel
+		weights_images[c] = PixelType1();  					 // azzera i pixel
+		clean_blocks[c]   = new sliding1_t( clean_images[c], opt.block_rows, opt.block_cols );
+		weights_blocks[c] = new sliding1_t( weights_images[c], opt.block_rows, opt.block_cols );
+	}
 
 	// suddividi le immagini in blocchi "sliding"
 	sliding1_t noisy_blocks( (cv::Mat_<PixelType1> &) noisy_image, opt.block_rows, opt.block_cols );
     sliding2_t guida_blocks( (cv::Mat_<PixelType2> &) guida_image, opt.block_rows, opt.block_cols );
-	sliding1_t clean_blocks( clean_image, opt.block_rows, opt.block_cols );
-	sliding1_t weights_blocks( weights_image, opt.block_rows, opt.block_cols );
 
-	// vicinato
-	NeighborhoodRect neighborhood( noisy_blocks.rows(),  noisy_blocks.cols() , opt.search_diameter );
+	// disomogeneita' dei blocchi (per il passo e per la zona di ricerca adattativi)
+	cv::Mat_<float> score;
+	if ((opt.adaptive_step > opt.step) || (opt.min_search_diameter > 0 && !opt.diameters))
+		homogeneity_map(noisy_image, guida_image, opt.block_rows, opt.block_cols, score);
+
+	// vicinato (con diametro variabile, al piu' search_diameter, se richiesto)
+	bool adaptive_window = opt.diameters || (opt.min_search_diameter > 0);
+	cv::Mat_<unsigned char> diameters( noisy_blocks.rows(), noisy_blocks.cols() );
+	if (opt.diameters) {
+		for(int i=0; i<diameters.rows; i++)
+			for(int j=0; j<diameters.cols; j++)
+				diameters(i,j) = (unsigned char) (std::min(std::max((int) (*opt.diameters)(i,j), 1), opt.search_diameter) | 1);
+	} else if (adaptive_window) {
+		diameter_map(score, opt.min_search_diameter, opt.search_diameter, diameters);
+	} else {
+		diameters = (unsigned char) opt.search_diameter;
+	}
+	NeighborhoodRect neighborhood_rect( noisy_blocks.rows(),  noisy_blocks.cols() , opt.search_diameter );
+	NeighborhoodRectSA neighborhood_sa( noisy_blocks.rows(),  noisy_blocks.cols() , diameters );
+	Neighborhood &neighborhood = adaptive_window ? (Neighborhood &) neighborhood_sa : (Neighborhood &) neighborhood_rect;
+	double search_positions = 0;
+	double stack_blocks = 0;
 
 	// distance
-    OpDistance1 funDistance1(opt);
-    OpDistance2 funDistance2(opt);
+    OpDistance1 funDistance1(match_opt);
+    OpDistance2 funDistance2(match_opt);
+
+	// pesi del block matching: con piu' configurazioni i dati della lista sono
+	// la distanza SAR (o della guida se alpha=1), l'altra si ricava da quella di selezione
+	PixelType1 match_lambda1 = multi ? PixelType1(opt.alpha==1 ? 0 : 1) : configs[0].lambda1;
+	PixelType1 match_lambda2 = multi ? PixelType1(opt.alpha==1 ? 1 : 0) : configs[0].lambda2;
+
+	// distanze incrementali (step=1): aggiornate colonna per colonna lungo ogni riga
+	bool incremental = opt.incremental && (opt.step==1) && !multi;
+
+	// passate di anteprima su reticoli di "reference block" via via piu' fitti
+	int passes = (opt.preview_passes > 1 && !incremental) ? opt.preview_passes : 1;
+	SlidingDistance<OpDistance1, PixelType1> slidDistance1( noisy_image, funDistance1, opt.block_rows, opt.block_cols, incremental ? opt.search_diameter : 1 );
+	SlidingDistance<OpDistance2, PixelType2> slidDistance2( guida_image, funDistance2, opt.block_rows, opt.block_cols, incremental ? opt.search_diameter : 1 );
     
     std::vector< std::pair<int,int> > matched;
 	std::vector< PixelType1 > matched_dist;
+	std::vector< PixelType1 > block_weights;
+
+	// distanze dei blocchi selezionati (con piu' configurazioni)
+	std::vector< PixelType1 > matched_sel, matched_dist1, matched_dist2;
+	std::vector< std::pair<int,int> > config_matched;
+	std::vector< PixelType1 > config_dist;
 
 	// stack di 'appoggio'
-	stack_t stack(opt.block_rows, opt.block_cols, opt.max_matched);
+	stack_t stack(opt.block_rows, opt.block_cols, max_matched);
 
-	/* scorri i "reference block" */
-	Stepper stepper( noisy_image.rows, noisy_image.cols, opt.block_rows, opt.block_cols, opt.step );
+	/* scorri i "reference block" (con passo "step" solo nelle zone disomogenee, se richiesto) */
+	cv::Mat_<unsigned char> dense;
+	if (opt.adaptive_step > opt.step)
+		heterogeneous_mask(score, opt.adaptive_fraction, dense);
+	AdaptiveStepper stepper( noisy_image.rows, noisy_image.cols, opt.block_rows, opt.block_cols, opt.step,
+			(opt.adaptive_step > opt.step) ? &dense : 0, opt.adaptive_step );
+
+	// cache delle distanze tra coppie di "reference block"
+	SymmetricDistanceCache<PixelType1> cache( stepper.row_indices(), stepper.col_indices(),
+			noisy_blocks.rows(), noisy_blocks.cols(), opt.search_diameter,
+			((incremental || passes>1) ? 0 : (size_t) (opt.symmetric_cache*1024*1024)) );
+	SymmetricDistanceCache<PixelType1> *cache_ptr = cache.enabled() ? &cache : 0;
+
+	// statistiche dei blocchi della guida (limite inferiore della distanza)
+	DistanceAwgnBound<PixelType1, PixelType2> guide_bound( guida_image, opt.block_rows, opt.block_cols, opt.guide_bound && !incremental );
+	const DistanceLowerBound<PixelType1> *guide_bound_ptr = (opt.guide_bound && !incremental) ? &guide_bound : 0;
+
+	// medie del log-intensita' dei blocchi SAR (limite inferiore della distanza)
+	DistanceSar_bound<PixelType1> sar_bound( noisy_image, opt.block_rows, opt.block_cols, opt.sar_bound && !incremental );
+	const DistanceLowerBound<PixelType1> *sar_bound_ptr = (opt.sar_bound && !incremental) ? &sar_bound : 0;
+
+	// descrittori PCA dei blocchi della guida (distanza della guida approssimata)
+	bool use_knn = (opt.knn_candidates>0) && !incremental;
+	bool use_pm  = opt.patch_match && !incremental && !use_knn && !multi;
+	bool use_pyr = (opt.pyr_levels>0) && !incremental && !use_knn && !use_pm;
+	bool use_smp  = (opt.sampling>0) && !incremental && !use_knn && !use_pm && !use_pyr;
+	bool use_seed = opt.propagate && !incremental && !use_knn && !use_pm && !use_pyr && !use_smp && !multi;
+	bool use_pca = (opt.pca_dims>0) && !incremental && !use_knn && !use_pm && !use_pyr && !use_smp && !use_seed && !multi;
+	int pca_dims = (opt.pca_dims>0) ? opt.pca_dims : 16;
+	PcaDescriptors<PixelType1, PixelType2> pca( guida_image, opt.block_rows, opt.block_cols, (use_pca || use_knn) ? pca_dims : 0 );
+	size_t pca_changes = 0, pca_avoided = 0;
+
+	// kd-tree dei descrittori, per tasselli del lato del vicinato
+	DescriptorForest< PcaDescriptors<PixelType1, PixelType2> > forest( pca, opt.search_diameter, use_knn );
+	std::vector< std::pair<int,int> > candidates;
+
+	// ricerca approssimata con propagazione degli offset tra riferimenti vicini
+	PatchMatchSearch patch_match( noisy_blocks.cols(), opt.search_diameter, opt.pm_passes, opt.pm_samples );
+
+	// piramidi del log SAR e della guida
+	PyramidSearch<PixelType1, PixelType2> pyramid( noisy_image, guida_image, opt.block_rows, opt.block_cols,
+			opt.search_diameter, use_pyr ? opt.pyr_levels : 0, opt.pyr_survivors, opt.alpha );
+	use_pyr = use_pyr && pyramid.enabled();
+
+	// offset della ricerca a campione
+	SampledOffsets sampled( use_smp ? opt.search_diameter : 1, opt.sampling, use_smp ? opt.sample_budget : 1.0 );
+
+	// block matching esaustivo con soglia iniziale propagata
+	SeededBlockMatching seeded( opt.search_diameter );
+
+	// distanze della guida lette da file (o calcolate e scritte), solo con la ricerca
+	// esaustiva e la griglia fissa dei "reference block"
+	bool use_roi = opt.roi.width > 0 && opt.roi.height > 0;
+	bool use_gcache = opt.guide_cache && !incremental && !use_knn && !use_pm && !use_pyr && !use_smp && !use_seed && !use_pca
+			&& !adaptive_window && !(opt.adaptive_step > opt.step) && !use_roi && passes==1;
+	GuideDistanceCache<PixelType1> guide_cache( use_gcache ? opt.guide_cache : 0, guida_image,
+			opt.block_rows, opt.block_cols, opt.search_diameter, opt.step, stepper.size() );
+	use_gcache = guide_cache.enabled();
+
+	// block matching effettivo e opzioni richieste ma non usate (riportati in opt.info)
+	int search_mode = incremental ? GuidedNLMeansInfo::INCREMENTAL : use_knn ? GuidedNLMeansInfo::KNN :
+			use_pm ? GuidedNLMeansInfo::PATCH_MATCH : use_pyr ? GuidedNLMeansInfo::PYRAMID :
+			use_smp ? GuidedNLMeansInfo::SAMPLING : use_seed ? GuidedNLMeansInfo::PROPAGATE :
+			use_pca ? GuidedNLMeansInfo::PCA : use_gcache ? GuidedNLMeansInfo::GUIDE_CACHE : GuidedNLMeansInfo::EXHAUSTIVE;
+	int used = GuidedNLMeansInfo::OPTION_ADAPTIVE_STEP | GuidedNLMeansInfo::OPTION_DIAMETERS;
+	if (incremental) used |= GuidedNLMeansInfo::OPTION_INCREMENTAL;
+	if (use_knn)     used |= GuidedNLMeansInfo::OPTION_KNN | GuidedNLMeansInfo::OPTION_PCA;	// pca_dims: dimensione dei descrittori
+	if (use_pm)      used |= GuidedNLMeansInfo::OPTION_PATCH_MATCH;
+	if (use_pyr)     used |= GuidedNLMeansInfo::OPTION_PYRAMID;
+	if (use_smp)     used |= GuidedNLMeansInfo::OPTION_SAMPLING;
+	if (use_seed)    used |= GuidedNLMeansInfo::OPTION_PROPAGATE;
+	if (use_pca)     used |= GuidedNLMeansInfo::OPTION_PCA;
+	if (use_gcache)  used |= GuidedNLMeansInfo::OPTION_GUIDE_CACHE;
+	if (passes>1)    used |= GuidedNLMeansInfo::OPTION_PREVIEW;
+	if (cache_ptr && (search_mode == GuidedNLMeansInfo::EXHAUSTIVE || use_knn || use_pyr || use_smp))
+		used |= GuidedNLMeansInfo::OPTION_SYMMETRIC_CACHE;
+	if (guide_bound_ptr && !use_pm && !use_pca && !use_gcache) used |= GuidedNLMeansInfo::OPTION_GUIDE_BOUND;
+	if (sar_bound_ptr) used |= GuidedNLMeansInfo::OPTION_SAR_BOUND;
+	int ignored = requested_options(opt) & ~used;
+
+	// estensione dei pixel aggiornati da un "reference block" oltre il blocco stesso
+	int roi_reach = opt.aggregate_all ? (opt.search_diameter-1)/2 : 0;
+	double references = 0;
+
+	// blocchi selezionati nelle passate di anteprima, riusati nell'ultima
+	std::vector< std::vector< std::pair<int,int> > > stored_matched( passes>1 ? stepper.size() : 0 );
+	std::vector< std::vector< PixelType1 > > stored_dist( passes>1 ? stepper.size() : 0 );
+	std::vector< std::vector< PixelType1 > > stored_sel( (passes>1 && multi) ? stepper.size() : 0 );
+	std::vector< bool > stored( passes>1 ? stepper.size() : 0, false );
+	cv::Mat_<PixelType1> preview_image;
 	#ifdef TIME_INFO
 		time_init += timer.stop();
 		timer.start();
 	#endif
-	for( int row = stepper.begin_row(); stepper.has_row(); row = stepper.next_row() ) {
-		// aggiorna il buffer
-		//noisy_log.move_forward(row);
-		for( int col = stepper.begin_col(); stepper.has_col(); col = stepper.next_col() ) {
-			// aggiorna il vicinato
-			neighborhood.set_center(std::make_pair(row, col));
-			#ifdef TIME_INFO
-				time_init += timer.stop();
-				timer.start();
-			#endif
+	for( int pass = passes-1; pass >= 0; pass-- ) {
+		// passo del reticolo della passata, in "reference block" della griglia; le
+		// anteprime aggregano su tutti i blocchi degli stack, per coprire l'immagine
+		int lattice = 1 << pass;
+		bool aggregate_all = opt.aggregate_all || (pass > 0);
+		size_t index = 0;
+		int grid_row = 0;
+		for( int row = stepper.begin_row(); stepper.has_row(); row = stepper.next_row(), grid_row++ ) {
+			// aggiorna il buffer
+			//noisy_log.move_forward(row);
+			int grid_col = 0;
+			for( int col = stepper.begin_col(); stepper.has_col(); col = stepper.next_col(), grid_col++, index++ ) {
+				// nelle passate di anteprima solo i nuovi "reference block" del reticolo
+				if (pass > 0 && (grid_row % lattice != 0 || grid_col % lattice != 0 || stored[index])) continue;
+				bool reuse = (pass == 0) && (passes > 1) && stored[index];
 
-            
-            // block matching
-            block_matching_duo_th(neighborhood, opt.alpha, opt.thDist,  
-                funDistance1, funDistance2, noisy_blocks, guida_blocks, 
-                opt.lambda1, opt.lambda2, matched, matched_dist, class_image);
+				// solo i "reference block" che contribuiscono al rettangolo di interesse
+				if (use_roi && (row-roi_reach >= opt.roi.y+opt.roi.height || row+opt.block_rows+roi_reach <= opt.roi.y ||
+						col-roi_reach >= opt.roi.x+opt.roi.width || col+opt.block_cols+roi_reach <= opt.roi.x)) continue;
+				references++;
+
+				// aggiorna il vicinato
+				neighborhood.set_center(std::make_pair(row, col));
+				if (!reuse) search_positions += (double) (neighborhood.downright().first - neighborhood.topleft().first + 1) *
+						(neighborhood.downright().second - neighborhood.topleft().second + 1);
+				#ifdef TIME_INFO
+					time_init += timer.stop();
+					timer.start();
+				#endif
+
+                
+                // block matching (o blocchi selezionati in una passata di anteprima)
+                if (reuse) {
+                    matched.swap(stored_matched[index]);
+                    matched_dist.swap(stored_dist[index]);
+                    if (multi) matched_sel.swap(stored_sel[index]);
+                } else if (incremental) {
+                    slidDistance1.set_center(std::make_pair(row, col));
+                    slidDistance2.set_center(std::make_pair(row, col));
+                    block_matching_duo_th_inc(neighborhood, opt.alpha, match_th,
+                        slidDistance1, slidDistance2,
+                        match_lambda1, match_lambda2, matched, matched_dist, class_image);
+                } else if (use_knn) {
+                    // esatto solo sui candidati preselezionati nello spazio dei descrittori
+                    forest.query(neighborhood.central(), neighborhood.topleft(), neighborhood.downright(),
+                        (size_t) opt.knn_candidates, candidates);
+                    IteratorList iter(candidates);
+                    if (cache_ptr) cache_ptr->set_center(std::make_pair(row, col));
+                    block_matching_duo_th_iter(iter, neighborhood, opt.alpha, match_th,
+                        funDistance1, funDistance2, noisy_blocks, guida_blocks,
+                        match_lambda1, match_lambda2, matched, matched_dist, class_image, cache_ptr, guide_bound_ptr, sar_bound_ptr, multi ? &matched_sel : 0);
+                } else if (use_pm) {
+                    patch_match.match(neighborhood, opt.alpha, match_th,
+                        funDistance1, funDistance2, noisy_blocks, guida_blocks,
+                        match_lambda1, match_lambda2, matched, matched_dist, class_image, sar_bound_ptr);
+                } else if (use_pyr) {
+                    // esatto solo sui candidati sopravvissuti ai livelli ridotti
+                    pyramid.search(neighborhood, candidates);
+                    IteratorList iter(candidates);
+                    if (cache_ptr) cache_ptr->set_center(std::make_pair(row, col));
+                    block_matching_duo_th_iter(iter, neighborhood, opt.alpha, match_th,
+                        funDistance1, funDistance2, noisy_blocks, guida_blocks,
+                        match_lambda1, match_lambda2, matched, matched_dist, class_image, cache_ptr, guide_bound_ptr, sar_bound_ptr, multi ? &matched_sel : 0);
+                } else if (use_smp) {
+                    IteratorOffsets iter(neighborhood, sampled.get(neighborhood.central()));
+                    if (cache_ptr) cache_ptr->set_center(std::make_pair(row, col));
+                    block_matching_duo_th_iter(iter, neighborhood, opt.alpha, match_th,
+                        funDistance1, funDistance2, noisy_blocks, guida_blocks,
+                        match_lambda1, match_lambda2, matched, matched_dist, class_image, cache_ptr, guide_bound_ptr, sar_bound_ptr, multi ? &matched_sel : 0);
+                } else if (use_seed) {
+                    seeded.match(neighborhood, opt.alpha, match_th,
+                        funDistance1, funDistance2, noisy_blocks, guida_blocks,
+                        match_lambda1, match_lambda2, matched, matched_dist, class_image, guide_bound_ptr, sar_bound_ptr);
+                } else if (use_pca) {
+                    block_matching_duo_th_desc(neighborhood, opt.alpha, match_th,
+                        funDistance1, funDistance2, noisy_blocks, guida_blocks,
+                        pca, (size_t) std::max(opt.pca_rerank, 0),
+                        match_lambda1, match_lambda2, matched, matched_dist, class_image, pca_changes, pca_avoided, sar_bound_ptr);
+                } else if (use_gcache) {
+                    block_matching_duo_th_table(neighborhood, opt.alpha, match_th, funDistance1, noisy_blocks,
+                        guide_cache.table(neighborhood, funDistance2, guida_blocks), opt.search_diameter,
+                        match_lambda1, match_lambda2, matched, matched_dist, class_image, sar_bound_ptr, multi ? &matched_sel : 0);
+                } else {
+                    if (cache_ptr) cache_ptr->set_center(std::make_pair(row, col));
+                    block_matching_duo_th(neighborhood, opt.alpha, match_th,  
+                        funDistance1, funDistance2, noisy_blocks, guida_blocks, 
+                        match_lambda1, match_lambda2, matched, matched_dist, class_image, cache_ptr, guide_bound_ptr, sar_bound_ptr, multi ? &matched_sel : 0);
+                }
+                if (pass > 0) {
+                    stored_matched[index] = matched;
+                    stored_dist[index] = matched_dist;
+                    if (multi) stored_sel[index] = matched_sel;
+                    stored[index] = true;
+                }
+
+                int Nmatched = matched.size();
+
+                // distanze SAR e della guida dei blocchi selezionati
+                if (multi) {
+                    matched_dist1.resize(Nmatched);
+                    matched_dist2.resize(Nmatched);
+                    for(int k=0; k<Nmatched; k++) {
+                        if (opt.alpha==0) {
+                            matched_dist1[k] = matched_dist[k];
+                            matched_dist2[k] = matched_sel[k];
+                        } else if (opt.alpha==1) {
+                            matched_dist1[k] = matched_sel[k];
+                            matched_dist2[k] = matched_dist[k];
+                        } else {
+                            matched_dist1[k] = matched_dist[k];
+                            matched_dist2[k] = (matched_sel[k] - opt.alpha*matched_dist[k]) / (1 - opt.alpha);
+                        }
+                    }
+                }
+                #ifdef TIME_INFO
+                    time_block += timer.stop();
+                    timer.start();
+                #endif
+
+                for(int c=0; c<num_configs; c++) {
+                    // primi max_matched blocchi, pesati con i parametri della configurazione
+                    std::vector< std::pair<int,int> > &points = multi ? config_matched : matched;
+                    std::vector< PixelType1 > &dists = multi ? config_dist : matched_dist;
+                    if (multi) {
+                        config_matched.clear();
+                        config_dist.clear();
+                        bool valid = class_image(row, col);
+                        for(int k=0; k<Nmatched && (int) config_matched.size()<configs[c].max_matched; k++) {
+                            if (valid && !(matched_dist1[k]<config_th[c])) continue;
+                            config_matched.push_back(matched[k]);
+                            config_dist.push_back(configs[c].lambda1*matched_dist1[k] + configs[c].lambda2*matched_dist2[k]);
+                        }
+                    }
+                    int Nb = multi ? (int) config_matched.size() : std::min(Nmatched, configs[c].max_matched);
+
+                    // pesi dei blocchi (una volta per il troncamento e per la media); blocchi
+                    // con peso trascurabile esclusi dalla media
+                    PixelType1 w_sum = collaborative_weights(dists, PixelType1(1.0), Nb, block_weights);
+                    int Nk = collaborative_truncation(points, dists, block_weights, w_sum, Nb, opt.stack_tolerance);
+                    stack_blocks += Nk;
+
+                    stack.fromBlock(noisy_blocks, points, Nk);
+
+                    // collaborative filtering
+                    collaborative_means_weighted(stack, block_weights, w_sum, Nk);
+                    #ifdef TIME_INFO
+                        time_filter += timer.stop();
+                        timer.start();
+                    #endif
+                    sum_images[c](row, col) = w_sum;
+                    PixelType1 scale = (PixelType1)Nb;
+
+                    // prima fase di 'aggregation' (su tutti i blocchi dello stack, se richiesto)
+                    if (aggregate_all) {
+                        for(int k=0; k<Nk; k++) block_weights[k] *= scale;
+                        aggregation_iter_weighted( stack, points, block_weights, *clean_blocks[c], *weights_blocks[c], opt, Nk );
+                    } else {
+                        aggregation1( stack[0], points[0], scale, *clean_blocks[c], *weights_blocks[c], opt );
+                    }
+                    #ifdef TIME_INFO
+                        time_aggre += timer.stop();
+                        timer.start();
+                    #endif
+                }
+
+			}
+		}
 
-            int Nb = matched.size();
-
-            stack.fromBlock(noisy_blocks, matched, Nb);
-            #ifdef TIME_INFO
-                time_block += timer.stop();
-                timer.start();
-            #endif
-
-            // collaborative filtering
-            PixelType1 w_sum = collaborative_means(stack, matched_dist, PixelType1(1.0), Nb);
-            #ifdef TIME_INFO
-                time_filter += timer.stop();
-                timer.start();
-            #endif
-            sum_image(row, col) = w_sum;
-            PixelType1 scale = (PixelType1)Nb;
-
-            // prima fase di 'aggregation'
-            aggregation1( stack[0], matched[0], scale, clean_blocks, weights_blocks, opt );
-            #ifdef TIME_INFO
-                time_aggre += timer.stop();
-                timer.start();
-            #endif
+		// anteprima normalizzata della prima configurazione (l'immagine SAR dove non ci sono stime)
+		if (opt.preview) {
+			preview_image.create( noisy_image.size() );
+			for(int i=0; i<preview_image.rows; i++)
+				for(int j=0; j<preview_image.cols; j++)
+					preview_image(i,j) = (weights_images[0](i,j) > 0) ? clean_images[0](i,j)/weights_images[0](i,j) : noisy_image(i,j);
+			opt.preview(preview_image, passes-pass, passes, opt.preview_data);
+		}
 
+		// l'ultima passata riparte da zero, nell'ordine dell'elaborazione non progressiva
+		if (pass > 0) {
+			for(int c=0; c<num_configs; c++) {
+				clean_images[c]   = PixelType1();
+				sum_images[c]     = PixelType1();
+				weights_images[c] = PixelType1();
+			}
+			stack_blocks = 0;
+			references = 0;
 		}
 	}
 
 	// seconda fase di 'aggregation'
-	clean_image /= weights_image;
+	for(int c=0; c<num_configs; c++)
+		clean_images[c] /= weights_images[c];
+	bool gcache_saved = use_gcache && !guide_cache.loaded() && guide_cache.save();
 	#ifdef TIME_INFO
 		time_aggre += timer.stop();
 	#endif
 
+	if (opt.info) {
+		opt.info->search_mode     = search_mode;
+		opt.info->ignored_options = ignored;
+		opt.info->cache_lookups = cache.lookups;
+		opt.info->cache_hits    = cache.hits;
+		opt.info->cache_bytes   = cache.bytes();
+		opt.info->guide_bound_tests   = guide_bound.tests;
+		opt.info->guide_bound_rejects = guide_bound.rejects;
+		opt.info->sar_bound_tests     = sar_bound.tests;
+		opt.info->sar_bound_rejects   = sar_bound.rejects;
+		opt.info->pca_dims           = pca.dims();
+		opt.info->pca_energy         = pca.energy();
+		opt.info->pca_rerank_changes = pca_changes;
+		opt.info->pca_avoided        = pca_avoided;
+		opt.info->knn_queries   = forest.queries;
+		opt.info->knn_distances = forest.distances;
+		opt.info->pm_references  = patch_match.references;
+		opt.info->pm_evaluations = patch_match.evaluations;
+		opt.info->pyr_references  = pyramid.references;
+		opt.info->pyr_evaluations = pyramid.evaluations;
+		opt.info->pyr_candidates  = pyramid.candidates;
+		opt.info->seed_evaluations = seeded.seeds;
+		opt.info->seed_references  = seeded.seeded;
+		opt.info->seed_pruned      = seeded.pruned;
+		opt.info->references       = references;
+		opt.info->search_positions = search_positions;
+		opt.info->stack_blocks     = stack_blocks;
+		opt.info->guide_cache      = guide_cache.loaded() ? 2 : (gcache_saved ? 1 : 0);
+	}
+
 	#ifdef TIME_INFO
 		#ifdef TIME_INFO_PRINT
 			printf("time   init: %7f \n", time_init  );
@@ -230,6 +782,519 @@ guided_nlmeans(const cv::Mat_<PixelType1> &noisy_image,
 
 }
 
+template <typename PixelType1, typename PixelType2, typename OpDistance1, typename OpDistance2>
+#ifndef TIME_INFO
+void
+#else
+double
+#endif
+guided_nlmeans(const cv::Mat_<PixelType1> &noisy_image, 
+            const cv::Mat_<PixelType2> &guida_image, 
+            const cv::Mat_<bool> &class_image, 
+            cv::Mat_<PixelType1> &clean_image,
+            cv::Mat_<PixelType1> &sum_image,
+            const GuidedNLMeansProfile<PixelType1> &opt)
+{
+	// una sola configurazione, quella del profilo (le uscite condividono i dati)
+	clean_image.create( noisy_image.size() );
+	sum_image.create( noisy_image.size() );
+	std::vector< GuidedNLMeansConfig<PixelType1> > configs(1, GuidedNLMeansConfig<PixelType1>(opt.max_matched, opt.lambda1, opt.lambda2, opt.thDist));
+	std::vector< cv::Mat_<PixelType1> > clean_images(1, clean_image), sum_images(1, sum_image);
+	return guided_nlmeans_multi<PixelType1, PixelType2, OpDistance1, OpDistance2>(
+			noisy_image, guida_image, class_image, clean_images, sum_images, opt, configs);
+}
+
+/*
+ * Copia del rettangolo "rect" di "src" in "dest" (continua).
+ */
+template <typename T>
+void copy_rect(const cv::Mat_<T> &src, const cv::Rect &rect, cv::Mat_<T> &dest) {
+	dest.create(rect.height, rect.width);
+	for(int i=0; i<rect.height; i++) {
+		const T *src_row = src[rect.y+i] + rect.x;
+		T *dest_row = dest[i];
+		for(int j=0; j<rect.width; j++) dest_row[j] = src_row[j];
+	}
+}
+
+/*
+ * Bordo (colonne, righe) oltre il quale i pixel d'ingresso non influenzano
+ * l'uscita di un pixel: zona di ricerca dei "reference block" i cui blocchi
+ * (o, con aggregate_all, i cui stack) contengono il pixel. Coincide con il
+ * bordo dei pixel d'uscita influenzati da un pixel d'ingresso.
+ */
+template <typename PixelType>
+cv::Size guided_nlmeans_halo(const GuidedNLMeansProfile<PixelType> &opt) {
+	int radius = (opt.search_diameter-1)/2 + (opt.aggregate_all ? (opt.search_diameter-1)/2 : 0);
+	return cv::Size(radius + opt.block_cols-1, radius + opt.block_rows-1);
+}
+
+/*
+ * Guided NLM del rettangolo "roi" di una scena. Le immagini della scena possono
+ * essere intestazioni su memoria esterna (puntatore e passo di riga, vedi il
+ * costruttore cv::Mat_(rows, cols, data, step)): e' copiato solo il rettangolo
+ * con un bordo di search_diameter/2 + block_rows-1 pixel (piu' search_diameter/2
+ * con aggregate_all), con l'origine sulla griglia dei "reference block" della
+ * scena, e sono elaborati solo i "reference block" che contribuiscono al
+ * rettangolo. Le uscite hanno le dimensioni di "roi" e, con la ricerca
+ * esaustiva e il passo fisso (anche con symmetric_cache, guide_bound,
+ * sar_bound e propagate), coincidono con il ritaglio di quelle di
+ * guided_nlmeans sulla scena intera; le modalita' che dipendono dall'intera
+ * immagine (adaptive_step, pca_dims, knn_candidates, patch_match, pyr_levels,
+ * sampling) restituiscono un'approssimazione.
+ */
+template <typename PixelType1, typename PixelType2, typename OpDistance1, typename OpDistance2>
+void
+guided_nlmeans_roi(const cv::Mat_<PixelType1> &noisy_scene,
+            const cv::Mat_<PixelType2> &guida_scene,
+            const cv::Mat_<bool> &class_scene,
+            const cv::Rect &roi,
+            cv::Mat_<PixelType1> &clean_image,
+            cv::Mat_<PixelType1> &sum_image,
+            const GuidedNLMeansProfile<PixelType1> &opt)
+{
+	assert( roi.x >= 0 && roi.y >= 0 && roi.width > 0 && roi.height > 0 );
+	assert( roi.x+roi.width <= noisy_scene.cols && roi.y+roi.height <= noisy_scene.rows );
+
+	// bordo: zona di ricerca dei "reference block" che contribuiscono al rettangolo
+	cv::Size halo = guided_nlmeans_halo(opt);
+	int halo_rows = halo.height;
+	int halo_cols = halo.width;
+
+	// rettangolo d'ingresso, con l'origine sulla griglia dei "reference block"; esteso
+	// al bordo della scena se ne resta meno di un blocco (l'ultimo riferimento e' sul bordo)
+	int y0 = (std::max(roi.y - halo_rows, 0) / opt.step) * opt.step;
+	int x0 = (std::max(roi.x - halo_cols, 0) / opt.step) * opt.step;
+	int y1 = std::min(roi.y + roi.height + halo_rows, noisy_scene.rows);
+	int x1 = std::min(roi.x + roi.width  + halo_cols, noisy_scene.cols);
+	if (noisy_scene.rows - y1 < opt.block_rows) y1 = noisy_scene.rows;
+	if (noisy_scene.cols - x1 < opt.block_cols) x1 = noisy_scene.cols;
+	cv::Rect in_rect(x0, y0, x1-x0, y1-y0);
+
+	cv::Mat_<PixelType1> noisy_image;
+	cv::Mat_<PixelType2> guida_image;
+	cv::Mat_<bool> class_image;
+	copy_rect(noisy_scene, in_rect, noisy_image);
+	copy_rect(guida_scene, in_rect, guida_image);
+	copy_rect(class_scene, in_rect, class_image);
+
+	// profilo riferito al rettangolo d'ingresso
+	GuidedNLMeansProfile<PixelType1> roi_opt( opt );
+	roi_opt.roi = cv::Rect(roi.x-x0, roi.y-y0, roi.width, roi.height);
+	cv::Mat_<unsigned char> diameters;
+	if (opt.diameters) {
+		copy_rect(*opt.diameters, cv::Rect(x0, y0, in_rect.width-opt.block_cols+1, in_rect.height-opt.block_rows+1), diameters);
+		roi_opt.diameters = &diameters;
+	}
+
+	cv::Mat_<PixelType1> clean_in, sum_in;
+	guided_nlmeans<PixelType1, PixelType2, OpDistance1, OpDistance2>(
+			noisy_image, guida_image, class_image, clean_in, sum_in, roi_opt);
+	copy_rect(clean_in, roi_opt.roi, clean_image);
+	copy_rect(sum_in, roi_opt.roi, sum_image);
+}
+
+/*
+ * Aggiornamento di "clean_image" e "sum_image", uscite di guided_nlmeans,
+ * dopo la modifica degli ingressi (SAR, guida o classi) nei rettangoli
+ * "dirty". I pixel d'uscita influenzati sono quelli entro il bordo di
+ * guided_nlmeans_halo dai rettangoli: sono ricalcolati, per rettangoli
+ * (uniti se sovrapposti), con guided_nlmeans_roi, cioe' elaborando i soli
+ * "reference block" che vi contribuiscono; gli altri pixel restano invariati.
+ * Nelle condizioni di esattezza di guided_nlmeans_roi il risultato coincide
+ * con una nuova elaborazione dell'intera immagine.
+ */
+template <typename PixelType1, typename PixelType2, typename OpDistance1, typename OpDistance2>
+void
+guided_nlmeans_update(const cv::Mat_<PixelType1> &noisy_image,
+            const cv::Mat_<PixelType2> &guida_image,
+            const cv::Mat_<bool> &class_image,
+            const std::vector<cv::Rect> &dirty,
+            cv::Mat_<PixelType1> &clean_image,
+            cv::Mat_<PixelType1> &sum_image,
+            const GuidedNLMeansProfile<PixelType1> &opt)
+{
+	assert( clean_image.rows == noisy_image.rows && clean_image.cols == noisy_image.cols );
+	assert( sum_image.rows == noisy_image.rows && sum_image.cols == noisy_image.cols );
+
+	// rettangoli d'uscita influenzati, uniti finche' si sovrappongono
+	cv::Size halo = guided_nlmeans_halo(opt);
+	std::vector<cv::Rect> rects;
+	for(size_t k=0; k<dirty.size(); k++) {
+		if (dirty[k].width <= 0 || dirty[k].height <= 0) continue;
+		int y0 = std::max(dirty[k].y - halo.height, 0);
+		int x0 = std::max(dirty[k].x - halo.width, 0);
+		int y1 = std::min(dirty[k].y + dirty[k].height + halo.height, noisy_image.rows);
+		int x1 = std::min(dirty[k].x + dirty[k].width  + halo.width,  noisy_image.cols);
+		if (y1 <= y0 || x1 <= x0) continue;
+		rects.push_back(cv::Rect(x0, y0, x1-x0, y1-y0));
+	}
+	for(bool merged = true; merged; ) {
+		merged = false;
+		for(size_t i=0; i<rects.size() && !merged; i++)
+			for(size_t j=i+1; j<rects.size() && !merged; j++) {
+				cv::Rect &a = rects[i], &b = rects[j];
+				if (a.x >= b.x+b.width || b.x >= a.x+a.width || a.y >= b.y+b.height || b.y >= a.y+a.height) continue;
+				int x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+				int x1 = std::max(a.x+a.width, b.x+b.width), y1 = std::max(a.y+a.height, b.y+b.height);
+				a = cv::Rect(x0, y0, x1-x0, y1-y0);
+				rects.erase(rects.begin()+j);
+				merged = true;
+			}
+	}
+
+	// ricalcolo dei rettangoli
+	double references = 0;
+	cv::Mat_<PixelType1> clean_roi, sum_roi;
+	for(size_t k=0; k<rects.size(); k++) {
+		const cv::Rect &r = rects[k];
+		guided_nlmeans_roi<PixelType1, PixelType2, OpDistance1, OpDistance2>(
+				noisy_image, guida_image, class_image, r, clean_roi, sum_roi, opt);
+		if (opt.info) references += opt.info->references;
+		for(int i=0; i<r.height; i++)
+			for(int j=0; j<r.width; j++) {
+				clean_image(r.y+i, r.x+j) = clean_roi(i, j);
+				sum_image(r.y+i, r.x+j)   = sum_roi(i, j);
+			}
+	}
+	if (opt.info) opt.info->references = references;
+}
+
+/*
+ * Impostazioni del costo dell'elaborazione (vedi guided_nlmeans_deadline)
+ */
+struct GuidedNLMeansSettings
+{
+	int step;					// distanza tra i "reference block"
+	int search_diameter;		// diametro della zona di ricerca
+	int max_matched;			// numero massimo di blocchi dello stack
+
+	GuidedNLMeansSettings(int step_, int search_diameter_, int max_matched_)
+		: step(step_), search_diameter(search_diameter_), max_matched(max_matched_) {}
+};
+
+/*
+ * Impostazioni via via piu' economiche a partire da quelle del profilo:
+ * prima il passo (raddoppiato, al piu' il lato del blocco), poi il diametro
+ * della zona di ricerca e la lunghezza dello stack.
+ */
+template <typename PixelType>
+void deadline_settings(const GuidedNLMeansProfile<PixelType> &opt, std::vector<GuidedNLMeansSettings> &levels) {
+	int B  = std::min(opt.block_rows, opt.block_cols);
+	int D  = opt.search_diameter;
+	int S  = opt.max_matched;
+	int s2 = std::max(opt.step, std::min(2*opt.step, B));
+	int D1 = std::min(D, std::max(3, (3*D/4) | 1));
+	int D2 = std::min(D, std::max(3, (D/2) | 1));
+	int D3 = std::min(D, std::max(3, (D/3) | 1));
+	levels.clear();
+	levels.push_back(GuidedNLMeansSettings(opt.step, D, S));
+	levels.push_back(GuidedNLMeansSettings(s2, D, S));
+	levels.push_back(GuidedNLMeansSettings(s2, D1, std::min(S, D1*D1)));
+	levels.push_back(GuidedNLMeansSettings(s2, D2, std::min(std::max(S/2, 16), D2*D2)));
+	levels.push_back(GuidedNLMeansSettings(std::max(s2, B), D2, std::min(std::max(S/4, 16), D2*D2)));
+	levels.push_back(GuidedNLMeansSettings(std::max(s2, B), D3, std::min(std::max(S/4, 16), D3*D3)));
+	// senza ripetizioni
+	for(size_t k=1; k<levels.size(); )
+		if (levels[k].step == levels[k-1].step && levels[k].search_diameter == levels[k-1].search_diameter &&
+				levels[k].max_matched == levels[k-1].max_matched)
+			levels.erase(levels.begin()+k);
+		else
+			k++;
+}
+
+/*
+ * Guided NLM entro il tempo "budget" (in secondi, compresa la stima): il tempo
+ * per "reference block" delle impostazioni (deadline_settings) e' misurato su
+ * un campione al centro dell'immagine (circa l'1% dei blocchi, con
+ * guided_nlmeans_roi), o previsto dall'ultima misura, e viene scelta la prima
+ * impostazione il cui tempo previsto rientra nel budget residuo. L'immagine e' poi elaborata per
+ * strisce orizzontali: se, corretta dal rapporto tra tempi misurati e
+ * previsti, la previsione per le strisce rimanenti supera il tempo
+ * rimasto, le strisce successive passano a impostazioni piu' economiche.
+ * Le impostazioni scelte e i tempi sono riportati in opt.info.
+ */
+template <typename PixelType1, typename PixelType2, typename OpDistance1, typename OpDistance2>
+void
+guided_nlmeans_deadline(const cv::Mat_<PixelType1> &noisy_image,
+            const cv::Mat_<PixelType2> &guida_image,
+            const cv::Mat_<bool> &class_image,
+            cv::Mat_<PixelType1> &clean_image,
+            cv::Mat_<PixelType1> &sum_image,
+            const GuidedNLMeansProfile<PixelType1> &opt,
+            double budget)
+{
+	double start = wall_clock();
+	const double safety = 0.9;
+	int rows = noisy_image.rows, cols = noisy_image.cols;
+
+	std::vector<GuidedNLMeansSettings> levels;
+	deadline_settings(opt, levels);
+	int num_levels = (int) levels.size();
+
+	// profili delle impostazioni
+	GuidedNLMeansInfo info;
+	std::vector< GuidedNLMeansProfile<PixelType1> > profiles(num_levels, opt);
+	for(int l=0; l<num_levels; l++) {
+		profiles[l].step = levels[l].step;
+		profiles[l].search_diameter = levels[l].search_diameter;
+		profiles[l].max_matched = levels[l].max_matched;
+		profiles[l].preview = 0;
+		profiles[l].preview_passes = 0;
+		profiles[l].info = &info;
+	}
+
+	// strisce: "reference block" che contribuiscono a piu' strisce calcolati piu' volte
+	int tile_rows = std::max((rows+7)/8, 8*opt.block_rows);
+	int reach = opt.aggregate_all ? (opt.search_diameter-1)/2 : 0;
+	double tile_factor = (double) std::min(tile_rows + opt.block_rows-1 + 2*reach, rows) / std::min(tile_rows, rows);
+
+	// tempo previsto di ogni impostazione: misurato su un campione al centro
+	// (tempo per "reference block"), oppure ricavato dall'ultima misura in
+	// proporzione ai "reference block" e all'area della zona di ricerca
+	int sample_rows = std::min(rows, std::max((int) (0.1*rows), 2*opt.block_rows));
+	int sample_cols = std::min(cols, std::max((int) (0.1*cols), 2*opt.block_cols));
+	cv::Rect sample((cols-sample_cols)/2, (rows-sample_rows)/2, sample_cols, sample_rows);
+	std::vector<double> estimate(num_levels), num_refs(num_levels);
+	for(int l=0; l<num_levels; l++)
+		num_refs[l] = AdaptiveStepper( rows, cols, opt.block_rows, opt.block_cols, levels[l].step ).size() * tile_factor;
+	cv::Mat_<PixelType1> clean_tile, sum_tile;
+	int level = num_levels-1;
+	int measured = -1;
+	for(int l=0; l<num_levels; l++) {
+		double remaining = budget - (wall_clock()-start);
+		if (measured >= 0) {
+			double area = (double) levels[l].search_diameter*levels[l].search_diameter /
+					((double) levels[measured].search_diameter*levels[measured].search_diameter);
+			estimate[l] = estimate[measured] * num_refs[l]/num_refs[measured] * area;
+			// misura solo le impostazioni che possono rientrare nel budget
+			if (l+1 < num_levels && estimate[l] > 2*safety*remaining) continue;
+		}
+		double t = wall_clock();
+		guided_nlmeans_roi<PixelType1, PixelType2, OpDistance1, OpDistance2>(
+				noisy_image, guida_image, class_image, sample, clean_tile, sum_tile, profiles[l]);
+		estimate[l] = (wall_clock() - t) / std::max(info.references, 1.0) * num_refs[l];
+		measured = l;
+		if (estimate[l] <= safety*(budget - (wall_clock()-start))) {
+			level = l;
+			break;
+		}
+	}
+	int chosen = level;
+	for(int l=chosen+1; l<num_levels; l++) {
+		double area = (double) levels[l].search_diameter*levels[l].search_diameter /
+				((double) levels[chosen].search_diameter*levels[chosen].search_diameter);
+		estimate[l] = estimate[chosen] * num_refs[l]/num_refs[chosen] * area;
+	}
+
+	// elaborazione per strisce
+	clean_image.create( noisy_image.size() );
+	sum_image.create( noisy_image.size() );
+	double predicted = 0, spent = 0, references = 0;
+	int tiles = 0, fallbacks = 0;
+	for(int y=0; y<rows; y+=tile_rows) {
+		int h = std::min(tile_rows, rows-y);
+		if (tiles > 0) {
+			// ripiego se la previsione corretta per le strisce rimanenti supera il tempo rimasto
+			double remaining = budget - (wall_clock()-start);
+			double ratio = (predicted > 0) ? spent/predicted : 1.0;
+			while (level+1 < num_levels && ratio*estimate[level]*(rows-y)/rows > remaining) level++;
+		}
+		cv::Rect tile(0, y, cols, h);
+		double t = wall_clock();
+		guided_nlmeans_roi<PixelType1, PixelType2, OpDistance1, OpDistance2>(
+				noisy_image, guida_image, class_image, tile, clean_tile, sum_tile, profiles[level]);
+		spent += wall_clock() - t;
+		predicted += estimate[level]*h/rows;
+		references += info.references;
+		for(int i=0; i<h; i++)
+			for(int j=0; j<cols; j++) {
+				clean_image(y+i, j) = clean_tile(i, j);
+				sum_image(y+i, j)   = sum_tile(i, j);
+			}
+		tiles++;
+		if (level > chosen) fallbacks++;
+	}
+
+	if (opt.info) {
+		*opt.info = info;
+		opt.info->ignored_options    = (int) info.ignored_options | (requested_options(opt) & GuidedNLMeansInfo::OPTION_PREVIEW);
+		opt.info->references         = references;
+		opt.info->deadline_step      = levels[chosen].step;
+		opt.info->deadline_diameter  = levels[chosen].search_diameter;
+		opt.info->deadline_stack     = levels[chosen].max_matched;
+		opt.info->deadline_estimate  = estimate[chosen];
+		opt.info->deadline_time      = wall_clock() - start;
+		opt.info->deadline_tiles     = tiles;
+		opt.info->deadline_fallbacks = fallbacks;
+	}
+}
+
+/*
+ * Guided NLM di piu' immagini SAR co-registrate ("noisy_images") con una sola
+ * guida: per ogni "reference block" la distanza della guida di ogni candidato
+ * e' calcolata una volta per tutte le immagini.
+ * Senza "joint" test SAR, selezione e pesi sono quelli di ciascuna immagine
+ * (uscite coincidenti con guided_nlmeans su ogni immagine, con ricerca
+ * esaustiva); con "joint" la selezione e i pesi sono comuni e usano la somma
+ * delle distanze SAR delle immagini moltiplicata per "joint_scale" (a cui
+ * si applicano thDist e lambda1).
+ * Sono usati passo fisso e vicinato rettangolare; stack_tolerance e
+ * aggregate_all sono applicati come in guided_nlmeans, le altre opzioni del
+ * profilo sono riportate in opt.info->ignored_options.
+ */
+template <typename PixelType1, typename PixelType2, typename OpDistance1, typename OpDistance2>
+void
+guided_nlmeans_shared(const std::vector< cv::Mat_<PixelType1> > &noisy_images,
+            const cv::Mat_<PixelType2> &guida_image,
+            const cv::Mat_<bool> &class_image,
+            std::vector< cv::Mat_<PixelType1> > &clean_images,
+            std::vector< cv::Mat_<PixelType1> > &sum_images,
+            const GuidedNLMeansProfile<PixelType1> &opt,
+            bool joint, double joint_scale)
+{
+	typedef Sliding_Accessor<PixelType1> sliding1_t;
+    typedef Sliding_Accessor<PixelType2> sliding2_t;
+	typedef Stack_Buffer<PixelType1> stack_t;
+
+	int num_dates = (int) noisy_images.size();
+
+	// immagini d'uscita e immagini dei pesi, per ogni data
+	clean_images.resize(num_dates);
+	sum_images.resize(num_dates);
+	std::vector< cv::Mat_<PixelType1> > weights_images(num_dates);
+	std::vector< const sliding1_t* > noisy_blocks(num_dates);
+	std::vector< sliding1_t* > clean_blocks(num_dates), weights_blocks(num_dates);
+	for(int t=0; t<num_dates; t++) {
+		clean_images[t].create( noisy_images[t].size() );
+		sum_images[t].create( noisy_images[t].size() );
+		weights_images[t].create( noisy_images[t].size() );
+		clean_images[t]   = PixelType1();  					 // azzera i pixel
+		sum_images[t]     = PixelType1();  					 // azzera i pixel
+		weights_images[t] = PixelType1();  					 // azzera i pixel
+		noisy_blocks[t]   = new sliding1_t( (cv::Mat_<PixelType1> &) noisy_images[t], opt.block_rows, opt.block_cols );
+		clean_blocks[t]   = new sliding1_t( clean_images[t], opt.block_rows, opt.block_cols );
+		weights_blocks[t] = new sliding1_t( weights_images[t], opt.block_rows, opt.block_cols );
+	}
+    sliding2_t guida_blocks( (cv::Mat_<PixelType2> &) guida_image, opt.block_rows, opt.block_cols );
+
+	// vicinato
+	NeighborhoodRect neighborhood( guida_blocks.rows(),  guida_blocks.cols() , opt.search_diameter );
+
+	// distance
+    OpDistance1 funDistance1(opt);
+    OpDistance2 funDistance2(opt);
+
+    std::vector< std::vector< std::pair<int,int> > > matched;
+	std::vector< std::vector< PixelType1 > > matched_dist;
+    std::vector< std::pair<int,int> > points;
+	std::vector< PixelType1 > dists;
+	std::vector< PixelType1 > block_weights;
+	double guide_distances = 0;
+	double stack_blocks = 0;
+
+	// stack di 'appoggio'
+	stack_t stack(opt.block_rows, opt.block_cols, opt.max_matched);
+
+	/* scorri i "reference block" */
+	Stepper stepper( guida_image.rows, guida_image.cols, opt.block_rows, opt.block_cols, opt.step );
+	double references = 0;
+	for( int row = stepper.begin_row(); stepper.has_row(); row = stepper.next_row() ) {
+		for( int col = stepper.begin_col(); stepper.has_col(); col = stepper.next_col() ) {
+			// aggiorna il vicinato
+			neighborhood.set_center(std::make_pair(row, col));
+			references++;
+
+            // block matching (distanze della guida condivise)
+            block_matching_duo_th_temporal(neighborhood, opt.alpha, opt.thDist,
+                funDistance1, funDistance2, noisy_blocks, guida_blocks,
+                opt.lambda1, opt.lambda2, matched, matched_dist, class_image, joint, joint_scale, guide_distances);
+
+            for(int t=0; t<num_dates; t++) {
+                // lista della data (o comune, con "joint")
+                points = matched[joint ? 0 : t];
+                dists  = matched_dist[joint ? 0 : t];
+                int Nb = points.size();
+
+                // pesi dei blocchi (una volta per il troncamento e per la media); blocchi
+                // con peso trascurabile esclusi dalla media
+                PixelType1 w_sum = collaborative_weights(dists, PixelType1(1.0), Nb, block_weights);
+                int Nk = collaborative_truncation(points, dists, block_weights, w_sum, Nb, opt.stack_tolerance);
+                stack_blocks += Nk;
+
+                stack.fromBlock(*noisy_blocks[t], points, Nk);
+
+                // collaborative filtering
+                collaborative_means_weighted(stack, block_weights, w_sum, Nk);
+                sum_images[t](row, col) = w_sum;
+                PixelType1 scale = (PixelType1)Nb;
+
+                // prima fase di 'aggregation'
+                if (opt.aggregate_all) {
+                    for(int k=0; k<Nk; k++) block_weights[k] *= scale;
+                    aggregation_iter_weighted( stack, points, block_weights, *clean_blocks[t], *weights_blocks[t], opt, Nk );
+                } else {
+                    aggregation1( stack[0], points[0], scale, *clean_blocks[t], *weights_blocks[t], opt );
+                }
+            }
+
+		}
+	}
+
+	// seconda fase di 'aggregation'
+	for(int t=0; t<num_dates; t++) {
+		clean_images[t] /= weights_images[t];
+		delete noisy_blocks[t];
+		delete clean_blocks[t];
+		delete weights_blocks[t];
+	}
+
+	if (opt.info) {
+		opt.info->search_mode     = GuidedNLMeansInfo::EXHAUSTIVE;
+		opt.info->ignored_options = requested_options(opt);
+		opt.info->references      = references;
+		opt.info->stack_blocks    = stack_blocks;
+		opt.info->guide_distances = guide_distances;
+	}
+}
+
+/*
+ * Serie multi-temporale di immagini SAR co-registrate con una sola guida:
+ * ogni data ha test SAR, selezione e pesi propri; con opt.temporal_joint la
+ * selezione e i pesi sono comuni e usano la media delle distanze SAR delle
+ * date (la soglia thDist e' applicata alla media).
+ */
+template <typename PixelType1, typename PixelType2, typename OpDistance1, typename OpDistance2>
+void
+guided_nlmeans_temporal(const std::vector< cv::Mat_<PixelType1> > &noisy_images,
+            const cv::Mat_<PixelType2> &guida_image,
+            const cv::Mat_<bool> &class_image,
+            std::vector< cv::Mat_<PixelType1> > &clean_images,
+            std::vector< cv::Mat_<PixelType1> > &sum_images,
+            const GuidedNLMeansProfile<PixelType1> &opt)
+{
+	guided_nlmeans_shared<PixelType1, PixelType2, OpDistance1, OpDistance2>(noisy_images, guida_image, class_image,
+			clean_images, sum_images, opt, opt.temporal_joint, 1.0/noisy_images.size());
+}
+
+/*
+ * Filtraggio congiunto di piu' canali SAR co-registrati (es. VV/VH): un solo
+ * block matching con la somma delle distanze SAR dei canali (thDist e lambda1
+ * si riferiscono alla somma), e gli stessi blocchi e pesi per tutti i canali.
+ */
+template <typename PixelType1, typename PixelType2, typename OpDistance1, typename OpDistance2>
+void
+guided_nlmeans_channels(const std::vector< cv::Mat_<PixelType1> > &noisy_channels,
+            const cv::Mat_<PixelType2> &guida_image,
+            const cv::Mat_<bool> &class_image,
+            std::vector< cv::Mat_<PixelType1> > &clean_channels,
+            std::vector< cv::Mat_<PixelType1> > &sum_images,
+            const GuidedNLMeansProfile<PixelType1> &opt)
+{
+	guided_nlmeans_shared<PixelType1, PixelType2, OpDistance1, OpDistance2>(noisy_channels, guida_image, class_image,
+			clean_channels, sum_images, opt, true, 1.0);
+}
+
 
 template <typename PixelType1, typename OpDistance1>
 #ifndef TIME_INFO
@@ -0,0 +1,306 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * gnlm.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Implementazione dell'interfaccia C (gnlm.h). Libreria condivisa (dalla
+ *  cartella src/capi, con le librerie della cartella lib_static_a64):
+ *
+ *    g++ -O3 -fPIC -shared -D_GLIBCXX_USE_CXX11_ABI=0 -I../../include gnlm.cpp
+ *        ../../lib_static_a64/libcv.a ../../lib_static_a64/libcxcore.a
+ *        ../../lib_static_a64/libopencv_lapack.a -o libgnlm.so
+ */
+#include <string.h>
+#include <opencv/cv.h>
+#include "gnlm.h"
+#include "../GNLM.hpp"
+
+namespace {
+
+typedef float PixelType;
+
+/* pixel a "offset" byte dall'inizio */
+template <typename T>
+inline T pixel(const gnlm_buffer &b, int i, int j, int k) {
+	return *(const T*) ((const char*) b.data + i*b.row_stride + j*b.col_stride + k*b.band_stride);
+}
+
+/* righe di pixel di "pixel_size" byte contigui, allineate e senza sovrapposizioni */
+inline bool wrappable(const gnlm_buffer &b, size_t pixel_size) {
+	return b.col_stride == (ptrdiff_t) pixel_size && b.row_stride >= (ptrdiff_t) (b.cols*pixel_size) &&
+			b.row_stride % sizeof(PixelType) == 0 && ((size_t) b.data) % sizeof(PixelType) == 0;
+}
+
+/* immagine float32: intestazione sui dati o copia */
+void float_image(const gnlm_buffer &b, cv::Mat_<PixelType> &dest, int &copies) {
+	if (wrappable(b, sizeof(PixelType))) {
+		dest = cv::Mat_<PixelType>(b.rows, b.cols, (PixelType*) b.data, (size_t) b.row_stride);
+		return;
+	}
+	dest.create(b.rows, b.cols);
+	for(int i=0; i<b.rows; i++)
+		for(int j=0; j<b.cols; j++) dest(i,j) = pixel<PixelType>(b, i, j, 0);
+	copies++;
+}
+
+/* guida interlacciata: intestazione sui dati; planare o con altri passi: copia */
+template <int NumBands>
+void guide_image(const gnlm_buffer &b, cv::Mat_< cv::Vec<PixelType, NumBands> > &dest, int &copies) {
+	if (b.band_stride == sizeof(PixelType) && wrappable(b, NumBands*sizeof(PixelType))) {
+		dest = cv::Mat_< cv::Vec<PixelType, NumBands> >(b.rows, b.cols, (cv::Vec<PixelType, NumBands>*) b.data, (size_t) b.row_stride);
+		return;
+	}
+	dest.create(b.rows, b.cols);
+	for(int i=0; i<b.rows; i++)
+		for(int j=0; j<b.cols; j++)
+			for(int k=0; k<NumBands; k++) dest(i,j)[k] = pixel<PixelType>(b, i, j, k);
+	copies++;
+}
+
+/* maschera: intestazione sui byte se contigui e gia' 0/1, altrimenti copia */
+void mask_image(const gnlm_buffer *b, int rows, int cols, cv::Mat_<bool> &dest, int &copies) {
+	if (!b) {
+		dest.create(rows, cols);
+		dest = true;
+		return;
+	}
+	bool binary = (b->col_stride == 1 && b->row_stride >= b->cols);
+	for(int i=0; i<b->rows && binary; i++)
+		for(int j=0; j<b->cols && binary; j++) binary = (pixel<unsigned char>(*b, i, j, 0) <= 1);
+	if (binary) {
+		dest = cv::Mat_<bool>(b->rows, b->cols, (bool*) b->data, (size_t) b->row_stride);
+		return;
+	}
+	dest.create(b->rows, b->cols);
+	for(int i=0; i<b->rows; i++)
+		for(int j=0; j<b->cols; j++) dest(i,j) = (pixel<unsigned char>(*b, i, j, 0) != 0);
+	copies++;
+}
+
+/* byte [first, last) occupati da un'immagine di "bands" bande, anche con passi negativi */
+void extent(const gnlm_buffer &b, int bands, size_t element_size, const char *&first, const char *&last) {
+	ptrdiff_t span[3] = { (b.rows-1)*b.row_stride, (b.cols-1)*b.col_stride, (bands-1)*b.band_stride };
+	first = last = (const char*) b.data;
+	for(int k=0; k<3; k++) {
+		if (span[k] < 0) first += span[k]; else last += span[k];
+	}
+	last += element_size;
+}
+
+bool overlap(const gnlm_buffer &a, int a_bands, size_t a_size, const gnlm_buffer &b, int b_bands, size_t b_size) {
+	const char *a_first, *a_last, *b_first, *b_last;
+	extent(a, a_bands, a_size, a_first, a_last);
+	extent(b, b_bands, b_size, b_first, b_last);
+	return a_first < b_last && b_first < a_last;
+}
+
+/* l'uscita condivide memoria con uno degli ingressi */
+bool shares_input(const gnlm_buffer &out, const gnlm_buffer &noisy, const gnlm_buffer &guide, const gnlm_buffer *mask) {
+	return overlap(out, 1, sizeof(PixelType), noisy, 1, sizeof(PixelType)) ||
+			overlap(out, 1, sizeof(PixelType), guide, guide.bands, sizeof(PixelType)) ||
+			(mask && overlap(out, 1, sizeof(PixelType), *mask, 1, 1));
+}
+
+/* copia di un'uscita calcolata a parte */
+void store(const cv::Mat_<PixelType> &src, gnlm_buffer &b) {
+	for(int i=0; i<b.rows; i++)
+		for(int j=0; j<b.cols; j++)
+			*(PixelType*) ((char*) b.data + i*b.row_stride + j*b.col_stride) = src(i,j);
+}
+
+template <int NumBands>
+int run(const GuidedNLMeansProfile<PixelType> &opt,
+		const gnlm_buffer &noisy_buf, const gnlm_buffer &guide_buf, const gnlm_buffer *mask_buf,
+		gnlm_buffer &clean_buf, gnlm_buffer *sum_buf, int &copies) {
+
+	typedef cv::Vec<PixelType, NumBands> PixelGuidaType;
+	cv::Mat_<PixelType> noisy, clean, sum;
+	cv::Mat_<PixelGuidaType> guida;
+	cv::Mat_<bool> valClass;
+	float_image(noisy_buf, noisy, copies);
+	guide_image<NumBands>(guide_buf, guida, copies);
+	mask_image(mask_buf, noisy.rows, noisy.cols, valClass, copies);
+
+	// uscite scritte al loro posto se possibile: non se condividono memoria con
+	// gli ingressi (letti per tutta l'elaborazione) o tra loro (sum copiata dopo clean)
+	bool outputs_overlap = sum_buf && overlap(clean_buf, 1, sizeof(PixelType), *sum_buf, 1, sizeof(PixelType));
+	bool clean_direct = wrappable(clean_buf, sizeof(PixelType)) && !outputs_overlap &&
+			!shares_input(clean_buf, noisy_buf, guide_buf, mask_buf);
+	bool sum_direct = sum_buf && wrappable(*sum_buf, sizeof(PixelType)) && !outputs_overlap &&
+			!shares_input(*sum_buf, noisy_buf, guide_buf, mask_buf);
+	if (clean_direct) clean = cv::Mat_<PixelType>(clean_buf.rows, clean_buf.cols, (PixelType*) clean_buf.data, (size_t) clean_buf.row_stride);
+	if (sum_direct) sum = cv::Mat_<PixelType>(sum_buf->rows, sum_buf->cols, (PixelType*) sum_buf->data, (size_t) sum_buf->row_stride);
+
+	guided_nlmeans<PixelType, PixelGuidaType, DistanceSar_int_sum<PixelType>, DistanceAwgnVec<PixelType, NumBands> >(
+			noisy, guida, valClass, clean, sum, opt);
+
+	if (!clean_direct) { store(clean, clean_buf); copies++; }
+	if (sum_buf && !sum_direct) { store(sum, *sum_buf); copies++; }
+	return GNLM_OK;
+}
+
+bool same_shape(const gnlm_buffer *b, int rows, int cols) {
+	return b->data && b->rows == rows && b->cols == cols;
+}
+
+} // namespace
+
+extern "C" {
+
+void gnlm_profile_init(gnlm_profile *profile) {
+	GuidedNLMeansProfile<PixelType> opt;
+	memset(profile, 0, sizeof(*profile));
+	profile->size              = sizeof(*profile);
+	profile->block_size        = opt.block_rows;
+	profile->stack_size        = opt.max_matched;
+	profile->search_diameter   = opt.search_diameter;
+	profile->step              = opt.step;
+	profile->tau_match         = std::numeric_limits<double>::infinity();
+	profile->beta              = 2.0;
+	profile->alpha             = opt.alpha;
+	profile->lambda1           = opt.lambda1;
+	profile->lambda2           = opt.lambda2;
+	profile->thDist            = opt.thDist;
+	profile->pm_passes         = opt.pm_passes;
+	profile->pm_samples        = opt.pm_samples;
+	profile->pyr_survivors     = opt.pyr_survivors;
+	profile->sample_budget     = opt.sample_budget;
+	profile->adaptive_fraction = opt.adaptive_fraction;
+}
+
+void gnlm_info_init(gnlm_info *info) {
+	memset(info, 0, sizeof(*info));
+	info->size = sizeof(*info);
+}
+
+void gnlm_buffer_init(gnlm_buffer *buffer, void *data, int rows, int cols, int bands, size_t element_size) {
+	buffer->data        = data;
+	buffer->rows        = rows;
+	buffer->cols        = cols;
+	buffer->bands       = bands;
+	buffer->band_stride = (ptrdiff_t) element_size;
+	buffer->col_stride  = (ptrdiff_t) (element_size * bands);
+	buffer->row_stride  = (ptrdiff_t) (element_size * bands * cols);
+}
+
+int gnlm_supports_bands(int bands) {
+	switch (bands) {
+		case 1: case 3: case 4: case 8: case 13: case 16: case 32: return 1;
+		default: return 0;
+	}
+}
+
+int gnlm_run(const gnlm_profile *profile,
+		const gnlm_buffer *noisy, const gnlm_buffer *guide, const gnlm_buffer *mask,
+		gnlm_buffer *clean, gnlm_buffer *sum, gnlm_info *info) {
+
+	if (!profile || !noisy || !guide || !clean || !noisy->data || !guide->data || !clean->data ||
+			(sum && !sum->data) || (mask && !mask->data)) return GNLM_ERROR_ARGUMENT;
+	if (profile->size < sizeof(size_t) || (info && info->size < sizeof(size_t))) return GNLM_ERROR_ARGUMENT;
+
+	// campi mancanti nelle versioni precedenti della struttura: valori di default
+	gnlm_profile p;
+	gnlm_profile_init(&p);
+	memcpy(&p, profile, std::min(profile->size, sizeof(p)));
+	p.size = sizeof(p);
+
+	if (p.alpha<0 || p.alpha>1 || p.lambda1<0 || p.lambda2<0 || p.block_size<2 || p.stack_size<1 ||
+			p.search_diameter<2 || p.step<1 || !(p.tau_match>0) || !(p.beta>0) || p.symmetric_cache<0 ||
+			p.pca_dims<0 || p.pca_rerank<0 || p.knn_candidates<0 || p.pm_passes<0 || p.pm_samples<0 ||
+			p.pyr_levels<0 || p.pyr_survivors<1 || p.sampling<0 || p.sampling>3 ||
+			p.sample_budget<=0 || p.sample_budget>1 || p.adaptive_step<0 ||
+			p.adaptive_fraction<0 || p.adaptive_fraction>1 || p.min_search_diameter<0 ||
+			p.stack_tolerance<0 || p.stack_tolerance>=1 ||
+			p.search_diameter%2==0 || (p.min_search_diameter>0 && p.min_search_diameter%2==0))
+		return GNLM_ERROR_ARGUMENT;
+
+	int rows = noisy->rows, cols = noisy->cols;
+	if (rows<p.block_size || cols<p.block_size || !same_shape(guide, rows, cols) || !same_shape(clean, rows, cols) ||
+			(mask && !same_shape(mask, rows, cols)) || (sum && !same_shape(sum, rows, cols)))
+		return GNLM_ERROR_SHAPE;
+	// il vicinato deve essere contenuto nelle posizioni dei blocchi
+	int positions = std::min(rows, cols) - p.block_size + 1;
+	if ((p.search_diameter-1)/2 >= positions || (p.min_search_diameter-1)/2 >= positions)
+		return GNLM_ERROR_SHAPE;
+	if (!gnlm_supports_bands(guide->bands)) return GNLM_ERROR_BANDS;
+
+	GuidedNLMeansProfile<PixelType> opt;
+	opt.config(p.block_size, p.stack_size, p.search_diameter, p.step, (PixelType) p.tau_match, (PixelType) p.beta,
+			(PixelType) p.alpha, (PixelType) p.thDist, (PixelType) p.lambda1, (PixelType) p.lambda2);
+	opt.incremental         = (p.incremental != 0);
+	opt.symmetric_cache     = p.symmetric_cache;
+	opt.guide_bound         = (p.guide_bound != 0);
+	opt.sar_bound           = (p.sar_bound != 0);
+	opt.pca_dims            = p.pca_dims;
+	opt.pca_rerank          = p.pca_rerank;
+	opt.knn_candidates      = p.knn_candidates;
+	opt.patch_match         = (p.patch_match != 0);
+	opt.pm_passes           = p.pm_passes;
+	opt.pm_samples          = p.pm_samples;
+	opt.pyr_levels          = p.pyr_levels;
+	opt.pyr_survivors       = p.pyr_survivors;
+	opt.propagate           = (p.propagate != 0);
+	opt.sampling            = p.sampling;
+	opt.sample_budget       = p.sample_budget;
+	opt.adaptive_step       = p.adaptive_step;
+	opt.adaptive_fraction   = p.adaptive_fraction;
+	opt.min_search_diameter = p.min_search_diameter;
+	opt.stack_tolerance     = p.stack_tolerance;
+	opt.aggregate_all       = (p.aggregate_all != 0);
+	GuidedNLMeansInfo stats;
+	opt.info = &stats;
+
+	int copies = 0;
+	int code;
+	try {
+		switch (guide->bands) {
+			case  1: code = run< 1>(opt, *noisy, *guide, mask, *clean, sum, copies); break;
+			case  3: code = run< 3>(opt, *noisy, *guide, mask, *clean, sum, copies); break;
+			case  4: code = run< 4>(opt, *noisy, *guide, mask, *clean, sum, copies); break;
+			case  8: code = run< 8>(opt, *noisy, *guide, mask, *clean, sum, copies); break;
+			case 13: code = run<13>(opt, *noisy, *guide, mask, *clean, sum, copies); break;
+			case 16: code = run<16>(opt, *noisy, *guide, mask, *clean, sum, copies); break;
+			default: code = run<32>(opt, *noisy, *guide, mask, *clean, sum, copies); break;
+		}
+	} catch (...) {
+		return GNLM_ERROR_FAILED;
+	}
+
+	// solo i campi presenti nella versione della struttura del chiamante
+	if (info) {
+#define GNLM_SET_INFO(field, value) \
+		if (info->size >= offsetof(gnlm_info, field) + sizeof(info->field)) info->field = value
+		GNLM_SET_INFO(references,       stats.references);
+		GNLM_SET_INFO(search_positions, stats.search_positions);
+		GNLM_SET_INFO(stack_blocks,     stats.stack_blocks);
+		GNLM_SET_INFO(guide_distances,  stats.guide_distances);
+		GNLM_SET_INFO(copies,           copies);
+#undef GNLM_SET_INFO
+	}
+	return code;
+}
+
+const char* gnlm_error_string(int code) {
+	switch (code) {
+		case GNLM_OK:             return "no error";
+		case GNLM_ERROR_ARGUMENT: return "invalid argument";
+		case GNLM_ERROR_SHAPE:    return "inconsistent image sizes";
+		case GNLM_ERROR_BANDS:    return "unsupported number of guide bands";
+		case GNLM_ERROR_FAILED:   return "processing failed";
+		default:                  return "unknown error";
+	}
+}
+
+} // extern "C"
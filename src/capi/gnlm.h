@@ -0,0 +1,148 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * gnlm.h
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Interfaccia C (ABI stabile) di guided_nlmeans, per l'uso da altri
+ *  linguaggi (es. Python con ctypes, che rilascia il GIL durante la chiamata).
+ *  Le immagini sono descritte da puntatore, dimensioni e passi in byte
+ *  (come gli "strides" di numpy): i dati float32 con le colonne contigue
+ *  sono usati senza copie, anche con righe non contigue (viste ritagliate);
+ *  gli altri sono copiati (contati in gnlm_info.copies).
+ *
+ *  Le strutture iniziano con "size" (impostato da gnlm_*_init): le versioni
+ *  successive aggiungono campi solo in coda. Di gnlm_profile si leggono i
+ *  campi compresi in "size" (gli altri hanno i valori di default), di
+ *  gnlm_info si scrivono solo quelli compresi in "size".
+ *
+ *  Le uscite possono condividere memoria con gli ingressi (es. "clean" sopra
+ *  "noisy"): in quel caso, o se "clean" e "sum" si sovrappongono, l'uscita e'
+ *  calcolata a parte e copiata alla fine ("sum" dopo "clean").
+ */
+#ifndef _GNLM_H_
+#define _GNLM_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GNLM_API_VERSION 1
+
+/* codici d'uscita */
+enum {
+	GNLM_OK = 0,
+	GNLM_ERROR_ARGUMENT,		/* parametri non validi */
+	GNLM_ERROR_SHAPE,			/* dimensioni delle immagini non coerenti */
+	GNLM_ERROR_BANDS,			/* numero di bande della guida non supportato */
+	GNLM_ERROR_FAILED			/* errore durante l'elaborazione (es. memoria) */
+};
+
+/*
+ * Immagine: il pixel (i,j) della banda b e' in
+ * data + i*row_stride + j*col_stride + b*band_stride (byte).
+ * Guida interlacciata (righe x colonne x bande, come numpy HxWxB):
+ * band_stride = 4, col_stride = 4*bands; planare (bande x righe x colonne):
+ * band_stride = rows*row_stride. La maschera e' di byte (0 = non valido).
+ */
+typedef struct gnlm_buffer {
+	void *data;
+	int rows;
+	int cols;
+	int bands;					/* 1 tranne che per la guida */
+	ptrdiff_t row_stride;		/* byte tra righe consecutive */
+	ptrdiff_t col_stride;		/* byte tra colonne consecutive */
+	ptrdiff_t band_stride;		/* byte tra bande consecutive */
+} gnlm_buffer;
+
+/* parametri (come le opzioni di guidedNLMeans.m / GuidedNLMeansProfile) */
+typedef struct gnlm_profile {
+	size_t size;				/* sizeof(gnlm_profile), da gnlm_profile_init */
+	int block_size;				/* righe/colonne del blocco */
+	int stack_size;				/* lunghezza max dello stack */
+	int search_diameter;		/* diametro della zona di ricerca */
+	int step;					/* distanza tra i "reference block" */
+	double tau_match;			/* distanza massima tra 2 blocchi (per pixel) */
+	double beta;				/* parametro della finestra di Kaiser */
+	double alpha;				/* peso della distanza SAR nel block matching */
+	double lambda1;				/* peso della distanza SAR */
+	double lambda2;				/* peso della distanza della guida */
+	double thDist;				/* soglia della distanza SAR */
+	/* modalita' di elaborazione (0 = disattivata) */
+	int incremental;
+	double symmetric_cache;
+	int guide_bound;
+	int sar_bound;
+	int pca_dims;
+	int pca_rerank;
+	int knn_candidates;
+	int patch_match;
+	int pm_passes;
+	int pm_samples;
+	int pyr_levels;
+	int pyr_survivors;
+	int propagate;
+	int sampling;
+	double sample_budget;
+	int adaptive_step;
+	double adaptive_fraction;
+	int min_search_diameter;
+	double stack_tolerance;
+	int aggregate_all;
+} gnlm_profile;
+
+/* statistiche d'uscita */
+typedef struct gnlm_info {
+	size_t size;				/* sizeof(gnlm_info), da gnlm_info_init */
+	double references;			/* "reference block" elaborati */
+	double search_positions;	/* posizioni del vicinato esaminate */
+	double stack_blocks;		/* blocchi degli stack */
+	double guide_distances;		/* distanze della guida calcolate */
+	int copies;					/* immagini copiate (non usate al loro posto) */
+} gnlm_info;
+
+/* valori di default (quelli di GuidedNLMeansProfile) */
+void gnlm_profile_init(gnlm_profile *profile);
+void gnlm_info_init(gnlm_info *info);
+
+/* descrizione di un'immagine float32 (o di byte per la maschera) contigua */
+void gnlm_buffer_init(gnlm_buffer *buffer, void *data, int rows, int cols, int bands, size_t element_size);
+
+/* bande della guida supportate (1 se "bands" lo e') */
+int gnlm_supports_bands(int bands);
+
+/*
+ * Guided NLM: "noisy" (intensita') e "guide" float32 delle stesse dimensioni,
+ * "mask" di byte (NULL = tutti validi), uscite float32 "clean" e "sum"
+ * (somma dei pesi, NULL se non richiesta) scritte al loro posto.
+ * "info" puo' essere NULL. Restituisce GNLM_OK o un codice d'errore:
+ * GNLM_ERROR_ARGUMENT anche se "size" e' minore di sizeof(size_t), con
+ * search_diameter (o min_search_diameter non nullo) pari e con dati NULL;
+ * GNLM_ERROR_SHAPE se il raggio del vicinato non e' minore del numero di
+ * posizioni dei blocchi (righe o colonne - block_size + 1).
+ */
+int gnlm_run(const gnlm_profile *profile,
+		const gnlm_buffer *noisy, const gnlm_buffer *guide, const gnlm_buffer *mask,
+		gnlm_buffer *clean, gnlm_buffer *sum, gnlm_info *info);
+
+/* descrizione di un codice d'uscita */
+const char* gnlm_error_string(int code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GNLM_H_ */
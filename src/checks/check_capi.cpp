@@ -0,0 +1,142 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * check_capi.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Interfaccia C (capi/gnlm.h): le uscite di gnlm_run devono coincidere con
+ *  guided_nlmeans per immagini contigue (senza copie), viste con righe non
+ *  contigue, guida planare, uscita "clean" sopra "noisy"; una gnlm_info di
+ *  una versione precedente non deve essere scritta oltre "size"; una "size"
+ *  non valida, diametri pari, vicinati piu' grandi dell'immagine e dati NULL
+ *  devono essere rifiutati (senza interrompere il processo). Si compila con
+ *  ../capi/gnlm.cpp.
+ */
+#include <string.h>
+#include "check_common.hpp"
+#include "../capi/gnlm.h"
+
+static void check_capi(const char *name, const gnlm_profile &p, gnlm_buffer &noisy, gnlm_buffer &guide, gnlm_buffer &mask,
+		gnlm_buffer &clean, gnlm_buffer &sum, const cv::Mat_<PixelType> &ref_clean, const cv::Mat_<PixelType> &ref_sum,
+		int expected_copies) {
+	gnlm_info info;
+	gnlm_info_init(&info);
+	int code = gnlm_run(&p, &noisy, &guide, &mask, &clean, &sum, &info);
+	cv::Mat_<PixelType> out_clean(clean.rows, clean.cols, (PixelType*) clean.data, (size_t) clean.row_stride);
+	cv::Mat_<PixelType> out_sum(sum.rows, sum.cols, (PixelType*) sum.data, (size_t) sum.row_stride);
+	double diff = std::max(check_difference(out_clean, ref_clean), check_difference(out_sum, ref_sum));
+	check_report(name, (code == GNLM_OK && info.copies == expected_copies) ? diff : HUGE_VAL, 0);
+}
+
+int main() {
+
+	cv::Mat_<PixelType> noisy;
+	cv::Mat_<PixelGuidaType> guide;
+	cv::Mat_<bool> valid;
+	check_scene(96, 104, 12345u, noisy, guide, valid);
+	GuidedNLMeansProfile<PixelType> opt;
+	check_profile(opt);
+	cv::Mat_<PixelType> clean, sum;
+	check_run(noisy, guide, valid, opt, clean, sum);
+	int rows = noisy.rows, cols = noisy.cols;
+
+	gnlm_profile p;
+	gnlm_profile_init(&p);
+	p.stack_size      = opt.max_matched;
+	p.search_diameter = opt.search_diameter;
+	p.alpha           = opt.alpha;
+	p.thDist          = opt.thDist;
+	p.lambda1         = opt.lambda1;
+	p.lambda2         = opt.lambda2;
+
+	// immagini contigue: usate al loro posto
+	cv::Mat_<PixelType> out_clean(rows, cols), out_sum(rows, cols);
+	gnlm_buffer b_noisy, b_guide, b_mask, b_clean, b_sum;
+	gnlm_buffer_init(&b_noisy, noisy.data, rows, cols, 1, sizeof(PixelType));
+	gnlm_buffer_init(&b_guide, guide.data, rows, cols, GUIDA_NUM_BANDS, sizeof(PixelType));
+	gnlm_buffer_init(&b_mask,  valid.data, rows, cols, 1, sizeof(bool));
+	gnlm_buffer_init(&b_clean, out_clean.data, rows, cols, 1, sizeof(PixelType));
+	gnlm_buffer_init(&b_sum,   out_sum.data, rows, cols, 1, sizeof(PixelType));
+	check_capi("capi, contiguous", p, b_noisy, b_guide, b_mask, b_clean, b_sum, clean, sum, 0);
+
+	// SAR e uscite in viste con righe non contigue, guida planare (copiata)
+	int pad = 7;
+	std::vector<PixelType> wide_noisy(rows*(cols+pad)), wide_clean(rows*(cols+pad)), wide_sum(rows*(cols+pad));
+	std::vector<PixelType> planar(GUIDA_NUM_BANDS*rows*cols);
+	for(int i=0; i<rows; i++)
+		for(int j=0; j<cols; j++) {
+			wide_noisy[i*(cols+pad)+j] = noisy(i,j);
+			for(int b=0; b<GUIDA_NUM_BANDS; b++) planar[(b*rows + i)*cols + j] = guide(i,j)[b];
+		}
+	gnlm_buffer_init(&b_noisy, &wide_noisy[0], rows, cols, 1, sizeof(PixelType));
+	gnlm_buffer_init(&b_clean, &wide_clean[0], rows, cols, 1, sizeof(PixelType));
+	gnlm_buffer_init(&b_sum,   &wide_sum[0], rows, cols, 1, sizeof(PixelType));
+	b_noisy.row_stride = b_clean.row_stride = b_sum.row_stride = (cols+pad)*sizeof(PixelType);
+	gnlm_buffer_init(&b_guide, &planar[0], rows, cols, GUIDA_NUM_BANDS, sizeof(PixelType));
+	b_guide.col_stride  = sizeof(PixelType);
+	b_guide.row_stride  = cols*sizeof(PixelType);
+	b_guide.band_stride = rows*cols*sizeof(PixelType);
+	check_capi("capi, strided views, planar guide", p, b_noisy, b_guide, b_mask, b_clean, b_sum, clean, sum, 1);
+
+	// "clean" sopra "noisy": calcolata a parte e copiata alla fine (una copia in piu')
+	b_clean = b_noisy;
+	check_capi("capi, clean over noisy", p, b_noisy, b_guide, b_mask, b_clean, b_sum, clean, sum, 2);
+
+	// gnlm_info di una versione precedente (senza "copies") e dimensioni non valide
+	for(int i=0; i<rows; i++)
+		for(int j=0; j<cols; j++) wide_noisy[i*(cols+pad)+j] = noisy(i,j);
+	gnlm_buffer_init(&b_clean, out_clean.data, rows, cols, 1, sizeof(PixelType));
+	gnlm_info info;
+	gnlm_info_init(&info);
+	info.size = offsetof(gnlm_info, copies);
+	info.copies = -1;
+	int code = gnlm_run(&p, &b_noisy, &b_guide, &b_mask, &b_clean, &b_sum, &info);
+	check_report("capi, older gnlm_info", (code == GNLM_OK && info.references > 0 && info.copies == -1) ? 0 : 1, 0);
+	gnlm_profile bad( p );
+	bad.size = 0;
+	check_report("capi, invalid size", (gnlm_run(&bad, &b_noisy, &b_guide, &b_mask, &b_clean, &b_sum, 0) == GNLM_ERROR_ARGUMENT) ? 0 : 1, 0);
+	bad = p;
+	bad.search_diameter = 20;
+	check_report("capi, even search_diameter", (gnlm_run(&bad, &b_noisy, &b_guide, &b_mask, &b_clean, &b_sum, 0) == GNLM_ERROR_ARGUMENT) ? 0 : 1, 0);
+	bad = p;
+	bad.min_search_diameter = 10;
+	check_report("capi, even min_search_diameter", (gnlm_run(&bad, &b_noisy, &b_guide, &b_mask, &b_clean, &b_sum, 0) == GNLM_ERROR_ARGUMENT) ? 0 : 1, 0);
+
+	// vicinato (D = 21, raggio 10) non contenuto nelle 24-8+1 = 17 posizioni di un'immagine 24x40
+	gnlm_buffer small_noisy = b_noisy, small_guide = b_guide, small_mask = b_mask, small_clean = b_clean, small_sum = b_sum;
+	small_noisy.rows = small_guide.rows = small_mask.rows = small_clean.rows = small_sum.rows = 24;
+	small_noisy.cols = small_guide.cols = small_mask.cols = small_clean.cols = small_sum.cols = 40;
+	bad = p;
+	bad.search_diameter = 39;
+	check_report("capi, search window larger than the image",
+			(gnlm_run(&bad, &small_noisy, &small_guide, &small_mask, &small_clean, &small_sum, 0) == GNLM_ERROR_SHAPE) ? 0 : 1, 0);
+	bad.search_diameter = 21;
+	bad.min_search_diameter = 35;
+	check_report("capi, large min_search_diameter",
+			(gnlm_run(&bad, &small_noisy, &small_guide, &small_mask, &small_clean, &small_sum, 0) == GNLM_ERROR_SHAPE) ? 0 : 1, 0);
+	bad.min_search_diameter = 0;
+	check_report("capi, search window inside a small image",
+			(gnlm_run(&bad, &small_noisy, &small_guide, &small_mask, &small_clean, &small_sum, 0) == GNLM_OK) ? 0 : 1, 0);
+
+	// dati NULL
+	gnlm_buffer null_clean = b_clean, null_sum = b_sum, null_mask = b_mask;
+	null_clean.data = null_sum.data = null_mask.data = 0;
+	int codes[3] = { gnlm_run(&p, &b_noisy, &b_guide, &b_mask, &null_clean, &b_sum, 0),
+			gnlm_run(&p, &b_noisy, &b_guide, &b_mask, &b_clean, &null_sum, 0),
+			gnlm_run(&p, &b_noisy, &b_guide, &null_mask, &b_clean, &b_sum, 0) };
+	check_report("capi, NULL data", (codes[0] == GNLM_ERROR_ARGUMENT && codes[1] == GNLM_ERROR_ARGUMENT &&
+			codes[2] == GNLM_ERROR_ARGUMENT) ? 0 : 1, 0);
+
+	return check_failures;
+}
@@ -0,0 +1,115 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * check_common.hpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Dati sintetici e confronti comuni ai controlli di questa cartella. Ogni
+ *  check_*.cpp e' un programma a se' che confronta un punto d'ingresso con
+ *  guided_nlmeans sugli stessi dati (con uscite identiche dove la
+ *  documentazione lo garantisce) e termina con 0 se tutti i confronti sono
+ *  superati. run_checks.sh li compila e li esegue tutti.
+ */
+#ifndef _CHECK_COMMON_HPP_
+#define _CHECK_COMMON_HPP_
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <opencv/cv.h>
+#include "../GNLM.hpp"
+
+#ifndef GUIDA_NUM_BANDS
+#define GUIDA_NUM_BANDS 4
+#endif
+
+typedef float PixelType;
+typedef cv::Vec<PixelType, GUIDA_NUM_BANDS> PixelGuidaType;
+typedef DistanceSar_int_sum<PixelType> CheckDistance1;
+typedef DistanceAwgnVec<PixelType, GUIDA_NUM_BANDS> CheckDistance2;
+
+static double check_uniform(unsigned int &seed) {
+	seed = seed * 1664525u + 1013904223u;
+	return ((seed >> 8) + 1.0) / 16777217.0;		// in (0,1)
+}
+
+/*
+ * Scena sintetica: riflettivita' costante su celle 16x16, speckle esponenziale
+ * (1 look), guida a GUIDA_NUM_BANDS bande legata alla riflettivita' e un
+ * rettangolo di pixel non validi.
+ */
+static void check_scene(int rows, int cols, unsigned int seed,
+		cv::Mat_<PixelType> &noisy, cv::Mat_<PixelGuidaType> &guide, cv::Mat_<bool> &valid) {
+	noisy.create(rows, cols);
+	guide.create(rows, cols);
+	valid.create(rows, cols);
+	int cells_cols = (cols + 15) / 16;
+	std::vector<double> levels( ((rows + 15) / 16) * cells_cols );
+	for(size_t k=0; k<levels.size(); k++) levels[k] = 20.0 + 200.0 * check_uniform(seed);
+	for(int i=0; i<rows; i++)
+		for(int j=0; j<cols; j++) {
+			double r = levels[(i/16)*cells_cols + j/16];
+			noisy(i,j) = (PixelType) (r * -log(check_uniform(seed)));
+			for(int b=0; b<GUIDA_NUM_BANDS; b++)
+				guide(i,j)[b] = (PixelType) (r * (1.0 + 0.1*b) + 5.0 * (check_uniform(seed) - 0.5));
+			valid(i,j) = !(i >= rows/2 && i < rows/2+6 && j >= cols/3 && j < cols/3+10);
+		}
+}
+
+/* guida a valori interi: con alpha = 0 molte distanze identiche (regola di BlockMatchingDataList) */
+static void check_integer_guide(cv::Mat_<PixelGuidaType> &guide) {
+	for(int i=0; i<guide.rows; i++)
+		for(int j=0; j<guide.cols; j++)
+			for(int b=0; b<GUIDA_NUM_BANDS; b++) guide(i,j)[b] = (PixelType) floor(guide(i,j)[b] / 40);
+}
+
+/* parametri di default di guidedNLMeans.m (1 look), con zona di ricerca ridotta */
+static void check_profile(GuidedNLMeansProfile<PixelType> &opt, int stack_size = 64, int search_diameter = 21, int step = 3) {
+	int B = 8;
+	double sigm_sar = B * sqrt(0.5*1.6449340668 - 0.6449340668);
+	double mu_sar   = B * B * (1.0 - log(2.0));
+	double mu_guide = B * B * GUIDA_NUM_BANDS;
+	opt.config(B, stack_size, search_diameter, step, std::numeric_limits<PixelType>::infinity(), 2.0,
+			0.0, (PixelType) (sigm_sar * 2.0 + mu_sar), (PixelType) (0.002 * 0.15 / mu_sar), (PixelType) (0.002 * 0.85 / mu_guide));
+}
+
+static void check_run(const cv::Mat_<PixelType> &noisy, const cv::Mat_<PixelGuidaType> &guide, const cv::Mat_<bool> &valid,
+		const GuidedNLMeansProfile<PixelType> &opt, cv::Mat_<PixelType> &clean, cv::Mat_<PixelType> &sum) {
+	guided_nlmeans<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(noisy, guide, valid, clean, sum, opt);
+}
+
+/* differenza relativa massima (mean = 0) o media (mean = 1) tra due immagini */
+static double check_difference(const cv::Mat_<PixelType> &a, const cv::Mat_<PixelType> &b, bool mean = false) {
+	if (a.rows != b.rows || a.cols != b.cols) return HUGE_VAL;
+	double diff = 0;
+	for(int i=0; i<a.rows; i++)
+		for(int j=0; j<a.cols; j++) {
+			double d = fabs((double) a(i,j) - b(i,j)) / (fabs((double) b(i,j)) + 1e-6);
+			if (d != d) return HUGE_VAL;
+			diff = mean ? diff + d : std::max(diff, d);
+		}
+	return mean ? diff / ((double) a.rows * a.cols) : diff;
+}
+
+/* esito di un confronto (tolerance = 0: uscite identiche); conta i fallimenti */
+static int check_failures = 0;
+
+static bool check_report(const char *name, double difference, double tolerance) {
+	bool ok = (difference <= tolerance);
+	printf("%-44s %-12g %s\n", name, difference, ok ? "ok" : "FAILED");
+	if (!ok) check_failures++;
+	return ok;
+}
+
+#endif /* _CHECK_COMMON_HPP_ */
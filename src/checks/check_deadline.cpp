@@ -0,0 +1,68 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * check_deadline.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  guided_nlmeans_deadline: con un budget ampio devono essere scelte le
+ *  impostazioni del profilo e le uscite devono coincidere con guided_nlmeans;
+ *  con un budget minimo devono essere scelte impostazioni piu' economiche,
+ *  con uscite piu' vicine a quelle di guided_nlmeans che l'immagine SAR.
+ *  Con un budget pari a meta' del tempo di guided_nlmeans il tempo
+ *  impiegato (deadline_time, compresa la stima) non deve superarlo.
+ */
+#include "check_common.hpp"
+
+int main() {
+
+	cv::Mat_<PixelType> noisy;
+	cv::Mat_<PixelGuidaType> guide;
+	cv::Mat_<bool> valid;
+	check_scene(96, 104, 12345u, noisy, guide, valid);
+	GuidedNLMeansProfile<PixelType> opt;
+	check_profile(opt);
+	cv::Mat_<PixelType> clean, sum;
+	check_run(noisy, guide, valid, opt, clean, sum);
+
+	GuidedNLMeansInfo info;
+	GuidedNLMeansProfile<PixelType> timed( opt );
+	timed.info = &info;
+	cv::Mat_<PixelType> clean_d, sum_d;
+	guided_nlmeans_deadline<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, clean_d, sum_d, timed, 1000.0);
+	check_report("deadline, ample budget", std::max(check_difference(clean_d, clean), check_difference(sum_d, sum)), 0);
+	check_report("deadline, ample budget settings", (info.deadline_step == opt.step &&
+			info.deadline_diameter == opt.search_diameter && info.deadline_fallbacks == 0) ? 0 : 1, 0);
+
+	guided_nlmeans_deadline<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, clean_d, sum_d, timed, 1e-6);
+	check_report("deadline, minimum budget settings", (info.deadline_step > opt.step &&
+			info.deadline_diameter < opt.search_diameter) ? 0 : 1, 0);
+	check_report("deadline, minimum budget", check_difference(clean_d, clean, true), check_difference(noisy, clean, true));
+
+	// budget pari a meta' del tempo di guided_nlmeans (il minimo di tre misure): deve essere rispettato
+	double full = HUGE_VAL;
+	for(int k=0; k<3; k++) {
+		double t = wall_clock();
+		check_run(noisy, guide, valid, opt, clean_d, sum_d);
+		full = std::min(full, wall_clock() - t);
+	}
+	double budget = 0.5*full;
+	guided_nlmeans_deadline<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, clean_d, sum_d, timed, budget);
+	check_report("deadline, half budget met", (info.deadline_time <= budget) ? 0 : info.deadline_time/budget - 1, 0);
+	check_report("deadline, half budget", check_difference(clean_d, clean, true), check_difference(noisy, clean, true));
+
+	return check_failures;
+}
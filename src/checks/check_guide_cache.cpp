@@ -0,0 +1,81 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * check_guide_cache.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Cache su file delle distanze della guida (opt.guide_cache): la prima
+ *  elaborazione scrive il file, la seconda lo legge, un file alterato o di
+ *  un'altra guida e' ricalcolato; in tutti i casi le uscite devono
+ *  coincidere con guided_nlmeans senza cache.
+ *
+ *    check_guide_cache [FILE]
+ */
+#include <stdlib.h>
+#include "check_common.hpp"
+
+/* elaborazione con la cache: confronto delle uscite e dello stato della cache */
+static void check_cached(const char *name, const cv::Mat_<PixelType> &noisy, const cv::Mat_<PixelGuidaType> &guide,
+		const cv::Mat_<bool> &valid, const GuidedNLMeansProfile<PixelType> &opt, const char *path, int expected) {
+	cv::Mat_<PixelType> clean_ref, sum_ref, clean, sum;
+	check_run(noisy, guide, valid, opt, clean_ref, sum_ref);
+	GuidedNLMeansProfile<PixelType> cached( opt );
+	GuidedNLMeansInfo info;
+	cached.guide_cache = path;
+	cached.info = &info;
+	check_run(noisy, guide, valid, cached, clean, sum);
+	double diff = std::max(check_difference(clean, clean_ref), check_difference(sum, sum_ref));
+	if ((int) info.guide_cache != expected) {
+		printf("%s: guide_cache %d instead of %d\n", name, (int) info.guide_cache, expected);
+		diff = HUGE_VAL;
+	}
+	check_report(name, diff, 0);
+}
+
+int main(int argc, char *argv[]) {
+
+	const char *path = (argc > 1) ? argv[1] : "check_guide_cache.gdc";
+	remove(path);
+
+	cv::Mat_<PixelType> noisy, other;
+	cv::Mat_<PixelGuidaType> guide, other_guide;
+	cv::Mat_<bool> valid;
+	check_scene(96, 104, 12345u, noisy, guide, valid);
+	GuidedNLMeansProfile<PixelType> opt;
+	check_profile(opt);
+
+	check_cached("guide_cache, written", noisy, guide, valid, opt, path, 1);
+	check_cached("guide_cache, read", noisy, guide, valid, opt, path, 2);
+
+	// altra acquisizione SAR con la stessa guida: stesso file
+	check_scene(96, 104, 54321u, other, other_guide, valid);
+	check_cached("guide_cache, read (other SAR image)", other, guide, valid, opt, path, 2);
+
+	// byte alterato nelle tabelle: somma di controllo errata, tabella ricalcolata
+	FILE *f = fopen(path, "r+b");
+	if (f) {
+		fseek(f, -64, SEEK_END);
+		int c = fgetc(f);
+		fseek(f, -64, SEEK_END);
+		fputc(c ^ 0x5a, f);
+		fclose(f);
+	}
+	check_cached("guide_cache, corrupted file", noisy, guide, valid, opt, path, 1);
+
+	// altra guida: chiave diversa, file riscritto
+	check_cached("guide_cache, other guide", noisy, other_guide, valid, opt, path, 1);
+
+	remove(path);
+	return check_failures;
+}
@@ -0,0 +1,126 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * check_multi.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  guided_nlmeans_multi: ogni configurazione (stack, pesi e soglia SAR
+ *  diversi) deve dare le stesse uscite di guided_nlmeans con i suoi parametri
+ *  e stable_ties, anche con molte distanze identiche (guida a valori interi).
+ *  Le opzioni non usate (ricerca approssimata con piu' configurazioni, cache
+ *  con le anteprime) devono essere riportate in GuidedNLMeansInfo.
+ */
+#include "check_common.hpp"
+
+/* confronto di ogni configurazione con un'elaborazione separata */
+static void check_configs(const char *name, const cv::Mat_<PixelType> &noisy, const cv::Mat_<PixelGuidaType> &guide,
+		const cv::Mat_<bool> &valid, const GuidedNLMeansProfile<PixelType> &opt,
+		const std::vector< GuidedNLMeansConfig<PixelType> > &configs) {
+	std::vector< cv::Mat_<PixelType> > clean_images, sum_images;
+	guided_nlmeans_multi<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, clean_images, sum_images, opt, configs);
+	for(size_t c=0; c<configs.size(); c++) {
+		GuidedNLMeansProfile<PixelType> single( opt );
+		single.stable_ties = true;
+		single.max_matched = configs[c].max_matched;
+		single.lambda1 = configs[c].lambda1;
+		single.lambda2 = configs[c].lambda2;
+		if (configs[c].thDist == configs[c].thDist) single.thDist = configs[c].thDist;
+		cv::Mat_<PixelType> clean, sum;
+		check_run(noisy, guide, valid, single, clean, sum);
+		char label[64];
+		sprintf(label, "%s, config %d", name, (int) c);
+		check_report(label, std::max(check_difference(clean_images[c], clean), check_difference(sum_images[c], sum)), 0);
+	}
+}
+
+/* block matching effettivo e opzioni non usate */
+static void check_modes(const cv::Mat_<PixelType> &noisy, const cv::Mat_<PixelGuidaType> &guide,
+		const cv::Mat_<bool> &valid, const GuidedNLMeansProfile<PixelType> &opt,
+		const std::vector< GuidedNLMeansConfig<PixelType> > &configs) {
+	std::vector< cv::Mat_<PixelType> > clean_ref, sum_ref, clean_images, sum_images;
+	GuidedNLMeansInfo info;
+	GuidedNLMeansProfile<PixelType> flags( opt );
+	flags.info = &info;
+	guided_nlmeans_multi<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, clean_ref, sum_ref, flags, configs);
+
+	// piu' configurazioni: patch_match, propagate e pca_dims non usati (ricerca esaustiva)
+	flags.patch_match = true;
+	flags.propagate = true;
+	flags.pca_dims = 8;
+	guided_nlmeans_multi<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, clean_images, sum_images, flags, configs);
+	double diff = 0;
+	for(size_t c=0; c<configs.size(); c++)
+		diff = std::max(diff, std::max(check_difference(clean_images[c], clean_ref[c]), check_difference(sum_images[c], sum_ref[c])));
+	check_report("modes, configs ignore approximate search", diff, 0);
+	check_report("modes, configs ignored options", (info.search_mode == GuidedNLMeansInfo::EXHAUSTIVE &&
+			info.ignored_options == (GuidedNLMeansInfo::OPTION_PATCH_MATCH | GuidedNLMeansInfo::OPTION_PROPAGATE |
+			GuidedNLMeansInfo::OPTION_PCA)) ? 0 : 1, 0);
+
+	// una configurazione: patch_match usato, propagate e pca_dims esclusi dalla precedenza
+	std::vector< GuidedNLMeansConfig<PixelType> > single(1, configs[0]);
+	guided_nlmeans_multi<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, clean_images, sum_images, flags, single);
+	check_report("modes, precedence", (info.search_mode == GuidedNLMeansInfo::PATCH_MATCH &&
+			info.ignored_options == (GuidedNLMeansInfo::OPTION_PROPAGATE | GuidedNLMeansInfo::OPTION_PCA)) ? 0 : 1, 0);
+
+	// anteprime: symmetric_cache non usata; con incremental (passo 1) le anteprime non sono usate
+	GuidedNLMeansProfile<PixelType> preview( opt );
+	preview.info = &info;
+	preview.preview_passes = 3;
+	preview.symmetric_cache = 64;
+	guided_nlmeans_multi<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, clean_images, sum_images, preview, single);
+	check_report("modes, preview ignores symmetric_cache", (info.search_mode == GuidedNLMeansInfo::EXHAUSTIVE &&
+			info.ignored_options == GuidedNLMeansInfo::OPTION_SYMMETRIC_CACHE) ? 0 : 1, 0);
+	preview.step = 1;
+	preview.incremental = true;
+	preview.symmetric_cache = 0;
+	guided_nlmeans_multi<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, clean_images, sum_images, preview, single);
+	check_report("modes, incremental ignores preview", (info.search_mode == GuidedNLMeansInfo::INCREMENTAL &&
+			info.ignored_options == GuidedNLMeansInfo::OPTION_PREVIEW) ? 0 : 1, 0);
+}
+
+int main() {
+
+	cv::Mat_<PixelType> noisy;
+	cv::Mat_<PixelGuidaType> guide;
+	cv::Mat_<bool> valid;
+	check_scene(96, 104, 12345u, noisy, guide, valid);
+	GuidedNLMeansProfile<PixelType> opt;
+	check_profile(opt);
+
+	// stack e sharpness diversi (GNLM1 e GNLM2)
+	std::vector< GuidedNLMeansConfig<PixelType> > configs;
+	configs.push_back(GuidedNLMeansConfig<PixelType>(32,  opt.lambda1,   opt.lambda2));
+	configs.push_back(GuidedNLMeansConfig<PixelType>(256, opt.lambda1*2, opt.lambda2*2));
+	check_configs("stack/sharpness", noisy, guide, valid, opt, configs);
+
+	// soglie SAR diverse: lista completa dei candidati
+	configs.clear();
+	configs.push_back(GuidedNLMeansConfig<PixelType>(64,  opt.lambda1, opt.lambda2, opt.thDist));
+	configs.push_back(GuidedNLMeansConfig<PixelType>(64,  opt.lambda1, opt.lambda2, opt.thDist*0.9f));
+	configs.push_back(GuidedNLMeansConfig<PixelType>(128, opt.lambda1*2, opt.lambda2, opt.thDist*1.2f));
+	check_configs("thresholds", noisy, guide, valid, opt, configs);
+	check_modes(noisy, guide, valid, opt, configs);
+
+	// distanze identiche
+	check_integer_guide(guide);
+	check_configs("thresholds, ties", noisy, guide, valid, opt, configs);
+
+	return check_failures;
+}
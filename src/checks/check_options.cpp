@@ -0,0 +1,312 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * check_options.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Modalita' di GuidedNLMeansProfile a confronto con la ricerca esaustiva:
+ *  quelle esatte devono dare le stesse uscite, quelle approssimate (e le
+ *  distanze incrementali, uguali a meno degli arrotondamenti) restare entro
+ *  la differenza relativa media indicata.
+ */
+#include "check_common.hpp"
+
+/* uscite e statistiche di un'elaborazione */
+struct OptionRun {
+	cv::Mat_<PixelType> clean, sum;
+	GuidedNLMeansInfo info;
+};
+
+struct OptionCheck {
+	const char *name;
+	void (*set)(GuidedNLMeansProfile<PixelType> &opt);
+	int step;					// passo dei "reference block" (anche del riferimento)
+	int stack_size;				// lunghezza dello stack (anche del riferimento)
+	bool mean;					// differenza relativa media (modalita' approssimate) o massima
+	double tolerance;
+	const char *property_name;	// proprieta' della modalita' (0 = nessuna)
+	double (*property)(const OptionRun &ref, const OptionRun &run, const GuidedNLMeansProfile<PixelType> &opt);
+};
+
+static void set_incremental(GuidedNLMeansProfile<PixelType> &opt)     { opt.incremental = true; }
+static void set_symmetric_cache(GuidedNLMeansProfile<PixelType> &opt) { opt.symmetric_cache = 64; }
+static void set_guide_bound(GuidedNLMeansProfile<PixelType> &opt)     { opt.guide_bound = true; }
+static void set_sar_bound(GuidedNLMeansProfile<PixelType> &opt)       { opt.sar_bound = true; }
+static void set_pca(GuidedNLMeansProfile<PixelType> &opt)             { opt.pca_dims = 8; opt.pca_rerank = 4; }
+static void set_knn(GuidedNLMeansProfile<PixelType> &opt)             { opt.knn_candidates = 192; }
+static void set_patch_match(GuidedNLMeansProfile<PixelType> &opt)     { opt.patch_match = true; }
+static void set_pyramid(GuidedNLMeansProfile<PixelType> &opt)         { opt.pyr_levels = 1; opt.pyr_survivors = 48; }
+static void set_propagate(GuidedNLMeansProfile<PixelType> &opt)       { opt.propagate = true; }
+static void set_sampling(GuidedNLMeansProfile<PixelType> &opt)        { opt.sampling = 2; opt.sample_budget = 0.5; }
+static void set_adaptive_step(GuidedNLMeansProfile<PixelType> &opt)   { opt.adaptive_step = 6; opt.adaptive_fraction = 0.5; }
+static void set_adaptive_coarse(GuidedNLMeansProfile<PixelType> &opt) { opt.adaptive_step = 24; opt.adaptive_fraction = 0.1; }
+static void set_search_diameter(GuidedNLMeansProfile<PixelType> &opt) { opt.min_search_diameter = 11; }
+static void set_stack_tolerance(GuidedNLMeansProfile<PixelType> &opt) { opt.stack_tolerance = 0.01; }
+static void set_aggregate_all(GuidedNLMeansProfile<PixelType> &opt)   { opt.aggregate_all = true; }
+
+/*
+ * Proprieta' delle modalita' approssimate rispetto al riferimento (0 = verificata)
+ */
+static double patch_match_evaluations(const OptionRun &ref, const OptionRun &run, const GuidedNLMeansProfile<PixelType> &) {
+	return (run.info.pm_references == run.info.references && run.info.pm_evaluations < ref.info.search_positions) ? 0 : 1;
+}
+
+static double pyramid_candidates(const OptionRun &ref, const OptionRun &run, const GuidedNLMeansProfile<PixelType> &opt) {
+	// distanze esatte solo sul riferimento e sui figli (3x3) dei sopravvissuti
+	return (run.info.pyr_references == run.info.references &&
+			run.info.pyr_candidates <= run.info.references*(9.0*opt.pyr_survivors+1) &&
+			run.info.pyr_candidates < ref.info.search_positions) ? 0 : 1;
+}
+
+static double adaptive_step_coverage(const OptionRun &ref, const OptionRun &run, const GuidedNLMeansProfile<PixelType> &) {
+	// ogni pixel coperto da almeno un "reference block" (la seconda aggregazione da' 0
+	// dove la somma dei pesi e' nulla, mentre la scena e' positiva)
+	double uncovered = 0;
+	for(int i=0; i<run.clean.rows; i++)
+		for(int j=0; j<run.clean.cols; j++)
+			if (!(run.clean(i,j) > 0)) uncovered++;
+	return (run.info.references < ref.info.references) ? uncovered : 1;
+}
+
+static double search_diameter_positions(const OptionRun &ref, const OptionRun &run, const GuidedNLMeansProfile<PixelType> &opt) {
+	// aree dei vicinati tra quelle dei diametri min_search_diameter e search_diameter
+	AdaptiveStepper stepper( run.clean.rows, run.clean.cols, opt.block_rows, opt.block_cols, opt.step );
+	NeighborhoodRect neighborhood( run.clean.rows-opt.block_rows+1, run.clean.cols-opt.block_cols+1, opt.min_search_diameter );
+	double min_positions = 0;
+	for(int row = stepper.begin_row(); stepper.has_row(); row = stepper.next_row())
+		for(int col = stepper.begin_col(); stepper.has_col(); col = stepper.next_col()) {
+			neighborhood.set_center(std::make_pair(row, col));
+			min_positions += (double) (neighborhood.downright().first - neighborhood.topleft().first + 1) *
+					(neighborhood.downright().second - neighborhood.topleft().second + 1);
+		}
+	return (run.info.search_positions >= min_positions && run.info.search_positions < ref.info.search_positions) ? 0 : 1;
+}
+
+static double stack_tolerance_weights(const OptionRun &ref, const OptionRun &run, const GuidedNLMeansProfile<PixelType> &opt) {
+	// somma dei pesi conservata almeno per la frazione 1-stack_tolerance, ad ogni riferimento
+	double lost = 0;
+	for(int i=0; i<run.sum.rows; i++)
+		for(int j=0; j<run.sum.cols; j++)
+			if (run.sum(i,j) < (1-opt.stack_tolerance)*(1-1e-6)*ref.sum(i,j) || run.sum(i,j) > ref.sum(i,j)*(1+1e-6)) lost++;
+	return (run.info.stack_blocks < ref.info.stack_blocks) ? lost : 1;
+}
+
+static const OptionCheck option_checks[] = {
+	{ "incremental (step 1)",             set_incremental,     1, 64, true,  1e-5,  0, 0 },
+	{ "symmetric_cache",                  set_symmetric_cache, 3, 64, false, 0,     0, 0 },
+	{ "guide_bound",                      set_guide_bound,     3, 64, false, 0,     0, 0 },
+	{ "sar_bound",                        set_sar_bound,       3, 64, false, 0,     0, 0 },
+	{ "pca_dims 8, pca_rerank 4",         set_pca,             3, 64, true,  0.02,  0, 0 },
+	{ "knn_candidates 192",               set_knn,             3, 64, true,  0.02,  0, 0 },
+	{ "patch_match",                      set_patch_match,     3, 64, true,  0.05,  "patch_match, fewer evaluations", patch_match_evaluations },
+	{ "pyr_levels 1, pyr_survivors 48",   set_pyramid,         3, 64, true,  0.02,  "pyr_levels, fewer exact distances", pyramid_candidates },
+	{ "propagate",                        set_propagate,       3, 64, false, 0,     0, 0 },
+	{ "sampling 2, sample_budget 0.5",    set_sampling,        3, 64, true,  0.15,  0, 0 },
+	{ "adaptive_step 6",                  set_adaptive_step,   3, 64, true,  0.05,  "adaptive_step, coverage", adaptive_step_coverage },
+	{ "adaptive_step 24, fraction 0.1",   set_adaptive_coarse, 3, 64, true,  0.1,   "adaptive_step 24, coverage", adaptive_step_coverage },
+	{ "min_search_diameter 11",           set_search_diameter, 3, 64, true,  0.05,  "min_search_diameter, window areas", search_diameter_positions },
+	{ "stack_tolerance 0.01",             set_stack_tolerance, 3, 64, true,  0.01,  "stack_tolerance, weight kept", stack_tolerance_weights },
+	{ "aggregate_all (stack 1)",          set_aggregate_all,   3,  1, false, 0,     0, 0 },
+};
+
+/*
+ * Descrittori PCA senza re-ranking: le distanze dello stack (da cui i pesi)
+ * devono essere quelle esatte dei blocchi selezionati, e le distanze esatte
+ * evitate i candidati che superano il test SAR meno i blocchi selezionati.
+ */
+static void check_pca_distances(const cv::Mat_<PixelType> &noisy, const cv::Mat_<PixelGuidaType> &guide, const cv::Mat_<bool> &valid) {
+	typedef std::pair<int,int> pair;
+	GuidedNLMeansProfile<PixelType> opt;
+	check_profile(opt);
+	Sliding_Accessor<PixelType> noisy_blocks( (cv::Mat_<PixelType> &) noisy, opt.block_rows, opt.block_cols );
+	Sliding_Accessor<PixelGuidaType> guide_blocks( (cv::Mat_<PixelGuidaType> &) guide, opt.block_rows, opt.block_cols );
+	NeighborhoodRect neighborhood( noisy_blocks.rows(), noisy_blocks.cols(), opt.search_diameter );
+	CheckDistance1 distance1( opt );
+	CheckDistance2 distance2( opt );
+	PcaDescriptors<PixelType, PixelGuidaType> pca( guide, opt.block_rows, opt.block_cols, 8 );
+
+	double diff = 0, candidates = 0;
+	size_t changes = 0, avoided = 0;
+	std::vector<pair> points;
+	std::vector<PixelType> dists;
+	for(int row=0; row<noisy_blocks.rows(); row+=7)
+		for(int col=0; col<noisy_blocks.cols(); col+=7) {
+			pair center(row, col);
+			neighborhood.set_center(center);
+			block_matching_duo_th_desc(neighborhood, opt.alpha, opt.thDist, distance1, distance2, noisy_blocks, guide_blocks,
+					pca, 0, opt.lambda1, opt.lambda2, points, dists, valid, changes, avoided);
+			if (!valid(row, col)) continue;
+			cv::Mat_<PixelType> ref1 = noisy_blocks(row, col);
+			cv::Mat_<PixelGuidaType> ref2 = guide_blocks(row, col);
+			for(size_t k=0; k<points.size(); k++) {
+				PixelType d1 = distance1.computeDistance(noisy_blocks(points[k].first, points[k].second), ref1, opt.max_distance);
+				PixelType d2 = distance2.computeDistance(guide_blocks(points[k].first, points[k].second), ref2,
+						std::numeric_limits<PixelType>::max());
+				PixelType exact = opt.lambda1*d1+opt.lambda2*d2;
+				diff = std::max(diff, fabs((double) dists[k] - exact) / (fabs((double) exact) + 1e-6));
+			}
+			IteratorScan2Fast iter(neighborhood);
+			while (iter.hasNext()) {
+				pair pos = iter.next();
+				if (valid(pos.first, pos.second) &&
+						distance1.computeDistance(noisy_blocks(pos.first, pos.second), ref1, opt.max_distance) < opt.thDist) candidates++;
+			}
+			candidates -= points.size();
+		}
+	check_report("pca, exact stack distances", diff, 0);
+	check_report("pca, avoided guide distances", (avoided > 0 && avoided == candidates) ? 0 : 1, 0);
+}
+
+/*
+ * Preselezione knn: la ricerca nei kd-tree deve restituire il riferimento e
+ * gli M-1 blocchi del vicinato piu' vicini nello spazio dei descrittori
+ * (nessun blocco escluso strettamente piu' vicino dell'ultimo restituito),
+ * calcolando meno distanze tra descrittori della ricerca esaustiva.
+ */
+static void check_knn_candidates(const cv::Mat_<PixelGuidaType> &guide) {
+	typedef std::pair<int,int> pair;
+	const int B = 8, D = 21;
+	const size_t M = 48;
+	PcaDescriptors<PixelType, PixelGuidaType> pca( guide, B, B, 16 );
+	DescriptorForest< PcaDescriptors<PixelType, PixelGuidaType> > forest( pca, D, true );
+	NeighborhoodRect neighborhood( pca.rows(), pca.cols(), D );
+
+	double wrong = 0, positions = 0;
+	std::vector<pair> candidates;
+	for(int row=0; row<pca.rows(); row+=5)
+		for(int col=0; col<pca.cols(); col+=5) {
+			pair center(row, col);
+			neighborhood.set_center(center);
+			pair tl = neighborhood.topleft(), dr = neighborhood.downright();
+			forest.query(center, tl, dr, M, candidates);
+			cv::Mat_<unsigned char> chosen( dr.first-tl.first+1, dr.second-tl.second+1, (unsigned char) 0 );
+			PixelType farthest = 0;
+			for(size_t k=0; k<candidates.size(); k++) {
+				pair p = candidates[k];
+				if (p.first < tl.first || p.first > dr.first || p.second < tl.second || p.second > dr.second) { wrong++; continue; }
+				chosen(p.first-tl.first, p.second-tl.second) = 1;
+				if (p != center) farthest = std::max(farthest, pca(p, center));
+			}
+			size_t area = (size_t) chosen.rows * chosen.cols;
+			positions += area-1;
+			if (candidates.size() != std::min(M, area) || !chosen(center.first-tl.first, center.second-tl.second)) wrong++;
+			for(int i=0; i<chosen.rows; i++)
+				for(int j=0; j<chosen.cols; j++)
+					if (!chosen(i,j) && pca(std::make_pair(tl.first+i, tl.second+j), center) < farthest) wrong++;
+		}
+	check_report("knn, nearest descriptors", wrong, 0);
+	check_report("knn, pruned descriptor distances", (forest.distances < positions) ? 0 : 1, 0);
+}
+
+/*
+ * Ricerca a campione: ogni configurazione di offset di SampledOffsets deve
+ * contenere round(sample_budget*D*D) offset distinti interni al vicinato,
+ * compreso quello nullo, per tutti gli schemi di campionamento.
+ */
+static void check_sampled_offsets() {
+	typedef std::pair<int,int> pair;
+	const int D = 21, R = (D-1)/2;
+	const double budgets[] = { 0.1, 0.25, 0.5, 1.0 };
+	double wrong = 0;
+	for(int pattern=SampledOffsets::RANDOM; pattern<=SampledOffsets::RADIAL; pattern++)
+		for(size_t b=0; b<sizeof(budgets)/sizeof(budgets[0]); b++) {
+			SampledOffsets sampled( D, pattern, budgets[b] );
+			size_t count = (size_t) (budgets[b]*D*D + 0.5);
+			for(int v=0; v<8; v++) {
+				std::vector<pair> offsets = sampled.get(std::make_pair(0, v));
+				std::sort(offsets.begin(), offsets.end());
+				if (offsets.size() != count || std::unique(offsets.begin(), offsets.end()) != offsets.end() ||
+						!std::binary_search(offsets.begin(), offsets.end(), std::make_pair(0,0))) wrong++;
+				for(size_t k=0; k<offsets.size(); k++)
+					if (abs(offsets[k].first) > R || abs(offsets[k].second) > R) wrong++;
+			}
+		}
+	check_report("sampling, offsets per sample_budget", wrong, 0);
+}
+
+/*
+ * aggregate_all con lo stack intero: con passo maggiore del blocco (9 > 8)
+ * l'aggregazione dei soli "reference block" lascia pixel scoperti (a 0 dopo
+ * la seconda aggregazione), l'aggregazione di tutti i blocchi degli stack no.
+ */
+static void check_aggregate_all(const cv::Mat_<PixelType> &noisy, const cv::Mat_<PixelGuidaType> &guide, const cv::Mat_<bool> &valid) {
+	GuidedNLMeansProfile<PixelType> opt;
+	check_profile(opt, 64, 21, 9);
+	cv::Mat_<PixelType> clean_ref, sum_ref, clean, sum;
+	check_run(noisy, guide, valid, opt, clean_ref, sum_ref);
+	opt.aggregate_all = true;
+	check_run(noisy, guide, valid, opt, clean, sum);
+	double uncovered_ref = 0, uncovered = 0;
+	for(int i=0; i<clean.rows; i++)
+		for(int j=0; j<clean.cols; j++) {
+			if (!(clean_ref(i,j) > 0)) uncovered_ref++;
+			if (!(clean(i,j) > 0)) uncovered++;
+		}
+	check_report("aggregate_all (step 9), uncovered pixels", (uncovered_ref > 0) ? uncovered : 1, 0);
+	check_report("aggregate_all (step 9), reference sums", check_difference(sum, sum_ref), 0);
+}
+
+/*
+ * Distanze identiche (guida a valori interi, alpha = 0): la ricerca con
+ * soglia iniziale deve coincidere con quella esaustiva con stable_ties, e le
+ * due regole di BlockMatchingDataList devono dare uscite diverse (la scena
+ * contiene davvero blocchi a pari distanza).
+ */
+static void check_ties(const cv::Mat_<PixelType> &noisy, const cv::Mat_<bool> &valid, const cv::Mat_<PixelGuidaType> &float_guide) {
+	cv::Mat_<PixelGuidaType> guide;
+	float_guide.copyTo(guide);
+	check_integer_guide(guide);
+	GuidedNLMeansProfile<PixelType> opt;
+	check_profile(opt);
+	cv::Mat_<PixelType> clean_default, sum_default, clean_stable, sum_stable, clean, sum;
+	check_run(noisy, guide, valid, opt, clean_default, sum_default);
+	opt.stable_ties = true;
+	check_run(noisy, guide, valid, opt, clean_stable, sum_stable);
+	check_report("ties, stable_ties changes the output", (check_difference(clean_default, clean_stable) > 0) ? 0 : 1, 0);
+	GuidedNLMeansProfile<PixelType> seeded( opt );
+	seeded.propagate = true;
+	check_run(noisy, guide, valid, seeded, clean, sum);
+	check_report("ties, propagate", std::max(check_difference(clean, clean_stable), check_difference(sum, sum_stable)), 0);
+	seeded.stable_ties = false;
+	check_run(noisy, guide, valid, seeded, clean, sum);
+	check_report("ties, propagate (stable_ties always)", std::max(check_difference(clean, clean_stable), check_difference(sum, sum_stable)), 0);
+}
+
+int main() {
+
+	cv::Mat_<PixelType> noisy;
+	cv::Mat_<PixelGuidaType> guide;
+	cv::Mat_<bool> valid;
+	check_scene(96, 104, 12345u, noisy, guide, valid);
+
+	for(size_t k=0; k<sizeof(option_checks)/sizeof(option_checks[0]); k++) {
+		const OptionCheck &c = option_checks[k];
+		GuidedNLMeansProfile<PixelType> opt;
+		check_profile(opt, c.stack_size, 21, c.step);
+		OptionRun ref, run;
+		opt.info = &ref.info;
+		check_run(noisy, guide, valid, opt, ref.clean, ref.sum);
+		c.set(opt);
+		opt.info = &run.info;
+		check_run(noisy, guide, valid, opt, run.clean, run.sum);
+		check_report(c.name, check_difference(run.clean, ref.clean, c.mean), c.tolerance);
+		if (c.property) check_report(c.property_name, c.property(ref, run, opt), 0);
+	}
+	check_pca_distances(noisy, guide, valid);
+	check_knn_candidates(guide);
+	check_sampled_offsets();
+	check_aggregate_all(noisy, guide, valid);
+	check_ties(noisy, valid, guide);
+	return check_failures;
+}
@@ -0,0 +1,87 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * check_preview.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Anteprima progressiva (preview_passes): le uscite finali devono
+ *  coincidere con quelle senza anteprima, "preview" deve essere chiamata
+ *  una volta per passata (l'ultima con la stima finale) e un'eccezione
+ *  lanciata da "preview" deve interrompere l'elaborazione.
+ */
+#include "check_common.hpp"
+
+struct PreviewLog {
+	int calls;
+	int last_pass;
+	int passes;
+	int stop_at;					// passata da interrompere (da 1, 0 = nessuna)
+	cv::Mat_<PixelType> last;
+};
+
+struct PreviewStop {};
+
+static void on_preview(const cv::Mat_<PixelType> &image, int pass, int passes, void *data) {
+	PreviewLog *log = (PreviewLog *) data;
+	log->calls++;
+	log->last_pass = pass;
+	log->passes = passes;
+	image.copyTo(log->last);
+	if (pass == log->stop_at) throw PreviewStop();
+}
+
+int main() {
+
+	cv::Mat_<PixelType> noisy;
+	cv::Mat_<PixelGuidaType> guide;
+	cv::Mat_<bool> valid;
+	check_scene(96, 104, 12345u, noisy, guide, valid);
+	GuidedNLMeansProfile<PixelType> opt;
+	check_profile(opt);
+	cv::Mat_<PixelType> clean, sum;
+	check_run(noisy, guide, valid, opt, clean, sum);
+
+	PreviewLog log;
+	log.calls = 0;
+	log.last_pass = log.passes = -1;
+	log.stop_at = 0;
+	GuidedNLMeansProfile<PixelType> preview( opt );
+	preview.preview_passes = 3;
+	preview.preview = on_preview;
+	preview.preview_data = &log;
+	cv::Mat_<PixelType> clean_p, sum_p;
+	check_run(noisy, guide, valid, preview, clean_p, sum_p);
+	check_report("preview, outputs", std::max(check_difference(clean_p, clean), check_difference(sum_p, sum)), 0);
+	check_report("preview, calls", abs(log.calls - 3) + abs(log.passes - 3) + abs(log.last_pass - 3), 0);
+
+	// ultima anteprima = stima finale (dove ci sono stime)
+	double diff = 0;
+	for(int i=0; i<clean.rows; i++)
+		for(int j=0; j<clean.cols; j++)
+			if (sum(i,j) > 0) diff = std::max(diff, (double) fabsf(log.last(i,j) - clean(i,j)));
+	check_report("preview, last image", diff, 0);
+
+	// interruzione alla prima passata
+	log.calls = 0;
+	log.stop_at = 1;
+	bool stopped = false;
+	try {
+		check_run(noisy, guide, valid, preview, clean_p, sum_p);
+	} catch (const PreviewStop &) {
+		stopped = true;
+	}
+	check_report("preview, exception", (stopped && log.calls == 1) ? 0 : 1, 0);
+
+	return check_failures;
+}
@@ -0,0 +1,92 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * check_roi.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  guided_nlmeans_roi: le uscite di ogni rettangolo (anche su un'immagine
+ *  con righe non contigue) devono coincidere con il ritaglio di quelle di
+ *  guided_nlmeans sulla scena intera; guided_nlmeans_halo: modificare gli
+ *  ingressi oltre il bordo non deve cambiare le uscite del rettangolo.
+ */
+#include "check_common.hpp"
+
+static void crop(const cv::Mat_<PixelType> &src, const cv::Rect &r, cv::Mat_<PixelType> &dest) {
+	copy_rect(src, r, dest);
+}
+
+static void check_rects(const char *name, const cv::Mat_<PixelType> &noisy, const cv::Mat_<PixelGuidaType> &guide,
+		const cv::Mat_<bool> &valid, const GuidedNLMeansProfile<PixelType> &opt) {
+	cv::Mat_<PixelType> clean, sum;
+	check_run(noisy, guide, valid, opt, clean, sum);
+	const cv::Rect rects[] = { cv::Rect(0, 0, 30, 20), cv::Rect(37, 41, 25, 18), cv::Rect(noisy.cols-17, noisy.rows-9, 17, 9),
+			cv::Rect(50, 0, 1, 1), cv::Rect(0, 0, noisy.cols, noisy.rows) };
+	double diff = 0;
+	for(size_t k=0; k<sizeof(rects)/sizeof(rects[0]); k++) {
+		cv::Mat_<PixelType> clean_roi, sum_roi, clean_crop, sum_crop;
+		guided_nlmeans_roi<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+				noisy, guide, valid, rects[k], clean_roi, sum_roi, opt);
+		crop(clean, rects[k], clean_crop);
+		crop(sum, rects[k], sum_crop);
+		diff = std::max(diff, std::max(check_difference(clean_roi, clean_crop), check_difference(sum_roi, sum_crop)));
+	}
+	check_report(name, diff, 0);
+}
+
+int main() {
+
+	cv::Mat_<PixelType> noisy;
+	cv::Mat_<PixelGuidaType> guide;
+	cv::Mat_<bool> valid;
+	check_scene(96, 104, 12345u, noisy, guide, valid);
+	GuidedNLMeansProfile<PixelType> opt;
+	check_profile(opt);
+
+	check_rects("roi", noisy, guide, valid, opt);
+	GuidedNLMeansProfile<PixelType> variant( opt );
+	variant.aggregate_all = true;
+	check_rects("roi, aggregate_all", noisy, guide, valid, variant);
+	variant = opt;
+	variant.symmetric_cache = 64;
+	variant.guide_bound = true;
+	variant.sar_bound = true;
+	variant.propagate = true;
+	check_rects("roi, cache/bounds/propagate", noisy, guide, valid, variant);
+
+	// scena su memoria esterna con righe non contigue
+	std::vector<PixelType> buffer( (size_t) noisy.rows * (noisy.cols + 5) );
+	cv::Mat_<PixelType> strided(noisy.rows, noisy.cols, &buffer[0], (noisy.cols + 5) * sizeof(PixelType));
+	for(int i=0; i<noisy.rows; i++)
+		for(int j=0; j<noisy.cols; j++) strided(i,j) = noisy(i,j);
+	check_rects("roi, strided scene", strided, guide, valid, opt);
+
+	// ingressi modificati oltre il bordo: uscite del rettangolo invariate
+	cv::Rect roi(40, 36, 20, 16);
+	cv::Size halo = guided_nlmeans_halo(opt);
+	cv::Mat_<PixelType> clean_roi, sum_roi, clean_far, sum_far;
+	guided_nlmeans_roi<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, roi, clean_roi, sum_roi, opt);
+	cv::Mat_<PixelType> far( noisy.size() );
+	for(int i=0; i<noisy.rows; i++)
+		for(int j=0; j<noisy.cols; j++) {
+			bool inside = i >= roi.y-halo.height && i < roi.y+roi.height+halo.height &&
+					j >= roi.x-halo.width && j < roi.x+roi.width+halo.width;
+			far(i,j) = inside ? noisy(i,j) : noisy(i,j) * 3 + 1;
+		}
+	guided_nlmeans_roi<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			far, guide, valid, roi, clean_far, sum_far, opt);
+	check_report("halo", std::max(check_difference(clean_far, clean_roi), check_difference(sum_far, sum_roi)), 0);
+
+	return check_failures;
+}
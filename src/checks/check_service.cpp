@@ -0,0 +1,119 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * check_service.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Servizio locale (service/gnlm_service.hpp): un server con un solo thread
+ *  di elaborazione in un thread di questo processo, una connessione inattiva
+ *  e un client che invia tile della scena sintetica. Le uscite devono
+ *  coincidere con guided_nlmeans nel processo, la seconda richiesta con gli
+ *  stessi parametri deve riusare il profilo; un diametro pari, un vicinato
+ *  piu' grande del tile e una guida con un numero di bande diverso devono
+ *  essere rifiutati, e il server deve continuare a rispondere.
+ */
+#include <unistd.h>
+#include "check_common.hpp"
+#include "../service/gnlm_service.hpp"
+
+static void* serve(void *server) {
+	((GuidedNLMeansService<GUIDA_NUM_BANDS> *) server)->run();
+	return 0;
+}
+
+static void check_tile(const char *name, GuidedNLMeansClient &client, const GNLMServiceRequest &req, unsigned int seed,
+		int expected_hit) {
+	cv::Mat_<PixelType> noisy;
+	cv::Mat_<PixelGuidaType> guide;
+	cv::Mat_<bool> valid;
+	check_scene(64, 72, seed, noisy, guide, valid);
+	cv::Mat_<PixelType> tile_noisy = client.noisy();
+	cv::Mat_<PixelGuidaType> tile_guide = client.guide<GUIDA_NUM_BANDS>();
+	cv::Mat_<unsigned char> tile_valid = client.valid();
+	for(int i=0; i<noisy.rows; i++)
+		for(int j=0; j<noisy.cols; j++) {
+			tile_noisy(i,j) = noisy(i,j);
+			tile_guide(i,j) = guide(i,j);
+			tile_valid(i,j) = valid(i,j) ? 1 : 0;
+		}
+	GNLMServiceReply reply;
+	if (client.process(req, reply) != GNLM_SERVICE_OK) {
+		check_report(name, HUGE_VAL, 0);
+		return;
+	}
+
+	GuidedNLMeansProfile<PixelType> opt;
+	opt.config(req.block_size, req.stack_size, req.search_diameter, req.step, (PixelType) req.tau_match, (PixelType) req.beta,
+			(PixelType) req.alpha, (PixelType) req.thDist, (PixelType) req.lambda1, (PixelType) req.lambda2);
+	opt.symmetric_cache = req.symmetric_cache;
+	opt.guide_bound     = (req.guide_bound != 0);
+	opt.sar_bound       = (req.sar_bound != 0);
+	cv::Mat_<PixelType> clean, sum;
+	check_run(noisy, guide, valid, opt, clean, sum);
+	double diff = std::max(check_difference(client.clean(), clean), check_difference(client.sum(), sum));
+	check_report(name, (reply.plan_hit == expected_hit) ? diff : HUGE_VAL, 0);
+}
+
+int main() {
+
+	char path[64];
+	sprintf(path, "/tmp/gnlm_check.%d", (int) getpid());
+	GuidedNLMeansService<GUIDA_NUM_BANDS> server(1);
+	if (!server.start(path)) {
+		fprintf(stderr, "cannot listen on %s\n", path);
+		return 1;
+	}
+	pthread_t thread;
+	pthread_create(&thread, 0, serve, &server);
+
+	// parametri di check_profile
+	GuidedNLMeansProfile<PixelType> profile;
+	check_profile(profile);
+	GNLMServiceRequest req;
+	req.stack_size      = profile.max_matched;
+	req.search_diameter = profile.search_diameter;
+	req.thDist          = profile.thDist;
+	req.lambda1         = profile.lambda1;
+	req.lambda2         = profile.lambda2;
+
+	GuidedNLMeansClient idle, client;
+	bool connected = idle.connect(path) && client.connect(path) && client.allocate(64, 72, GUIDA_NUM_BANDS);
+	if (connected) {
+		check_tile("service", client, req, 12345u, 0);
+		check_tile("service, same plan", client, req, 54321u, 1);
+		req.symmetric_cache = 64;
+		req.guide_bound = 1;
+		req.sar_bound = 1;
+		check_tile("service, cache/bounds", client, req, 12345u, 0);
+
+		// richieste non valide, poi di nuovo lo stesso tile
+		GNLMServiceRequest bad( req );
+		GNLMServiceReply reply;
+		bad.search_diameter = 20;
+		check_report("service, even search_diameter", (client.process(bad, reply) == GNLM_SERVICE_BAD_REQUEST) ? 0 : 1, 0);
+		bad.search_diameter = 39;
+		client.allocate(24, 24, GUIDA_NUM_BANDS);
+		check_report("service, search window larger than the tile", (client.process(bad, reply) == GNLM_SERVICE_BAD_REQUEST) ? 0 : 1, 0);
+		client.allocate(64, 72, GUIDA_NUM_BANDS+1);
+		check_report("service, other bands", (client.process(req, reply) == GNLM_SERVICE_BAD_BANDS) ? 0 : 1, 0);
+		client.allocate(64, 72, GUIDA_NUM_BANDS);
+		check_tile("service, after the rejected requests", client, req, 12345u, 1);
+	} else {
+		check_report("service, connection", HUGE_VAL, 0);
+	}
+
+	server.stop();
+	pthread_join(thread, 0);
+	return check_failures;
+}
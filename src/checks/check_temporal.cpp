@@ -0,0 +1,66 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * check_temporal.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  guided_nlmeans_temporal: senza temporal_joint ogni data deve coincidere
+ *  con guided_nlmeans sulla data; con temporal_joint e due date uguali,
+ *  con guided_nlmeans sulla data a meno degli arrotondamenti (la media delle
+ *  distanze e' la distanza).
+ *  guided_nlmeans_channels con due canali uguali: come guided_nlmeans sul
+ *  canale con soglia e lambda1 riferiti alla somma (thDist*2, lambda1/2).
+ */
+#include "check_common.hpp"
+
+int main() {
+
+	cv::Mat_<PixelType> noisy, other;
+	cv::Mat_<PixelGuidaType> guide, other_guide;
+	cv::Mat_<bool> valid, other_valid;
+	check_scene(96, 104, 12345u, noisy, guide, valid);
+	check_scene(96, 104, 54321u, other, other_guide, other_valid);
+	GuidedNLMeansProfile<PixelType> opt;
+	check_profile(opt);
+
+	std::vector< cv::Mat_<PixelType> > dates, clean_dates, sum_dates;
+	dates.push_back(noisy);
+	dates.push_back(other);
+	guided_nlmeans_temporal<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			dates, guide, valid, clean_dates, sum_dates, opt);
+	for(size_t t=0; t<dates.size(); t++) {
+		cv::Mat_<PixelType> clean, sum;
+		check_run(dates[t], guide, valid, opt, clean, sum);
+		check_report(t ? "temporal, date 1" : "temporal, date 0",
+				std::max(check_difference(clean_dates[t], clean), check_difference(sum_dates[t], sum)), 0);
+	}
+
+	GuidedNLMeansProfile<PixelType> joint( opt );
+	joint.temporal_joint = true;
+	dates[1] = noisy;
+	guided_nlmeans_temporal<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			dates, guide, valid, clean_dates, sum_dates, joint);
+	cv::Mat_<PixelType> clean, sum;
+	check_run(noisy, guide, valid, opt, clean, sum);
+	check_report("temporal_joint, equal dates", std::max(check_difference(clean_dates[0], clean), check_difference(clean_dates[1], clean)), 1e-5);
+
+	GuidedNLMeansProfile<PixelType> channels( opt );
+	channels.thDist  = opt.thDist * 2;
+	channels.lambda1 = opt.lambda1 / 2;
+	guided_nlmeans_channels<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			dates, guide, valid, clean_dates, sum_dates, channels);
+	check_report("channels, equal channels", std::max(check_difference(clean_dates[0], clean), check_difference(clean_dates[1], clean)), 1e-5);
+
+	return check_failures;
+}
@@ -0,0 +1,106 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * check_update.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  guided_nlmeans_update: dopo la modifica di SAR, guida e classi in alcuni
+ *  rettangoli (anche sovrapposti o sul bordo), le uscite aggiornate devono
+ *  coincidere con una nuova elaborazione dell'intera immagine, elaborando
+ *  solo i "reference block" che contribuiscono ai rettangoli con il bordo.
+ */
+#include "check_common.hpp"
+
+static void modify(const cv::Rect &r, unsigned int seed,
+		cv::Mat_<PixelType> &noisy, cv::Mat_<PixelGuidaType> &guide, cv::Mat_<bool> &valid) {
+	for(int i=r.y; i<r.y+r.height; i++)
+		for(int j=r.x; j<r.x+r.width; j++) {
+			double u = check_uniform(seed);
+			noisy(i,j) = (PixelType) (noisy(i,j) * 2 + 10 * u);
+			for(int b=0; b<GUIDA_NUM_BANDS; b++) guide(i,j)[b] += (PixelType) (30 * u);
+			valid(i,j) = (u > 0.1);
+		}
+}
+
+static void check_dirty(const char *name, const std::vector<cv::Rect> &dirty, const GuidedNLMeansProfile<PixelType> &opt) {
+	cv::Mat_<PixelType> noisy;
+	cv::Mat_<PixelGuidaType> guide;
+	cv::Mat_<bool> valid;
+	check_scene(96, 104, 12345u, noisy, guide, valid);
+	cv::Mat_<PixelType> clean, sum, full_clean, full_sum;
+	check_run(noisy, guide, valid, opt, clean, sum);
+
+	for(size_t k=0; k<dirty.size(); k++) modify(dirty[k], 777u + (unsigned int) k, noisy, guide, valid);
+	guided_nlmeans_update<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, dirty, clean, sum, opt);
+	check_run(noisy, guide, valid, opt, full_clean, full_sum);
+	check_report(name, std::max(check_difference(clean, full_clean), check_difference(sum, full_sum)), 0);
+}
+
+/*
+ * "reference block" elaborati per una piccola modifica interna alla scena:
+ * esattamente quelli della griglia della scena che contribuiscono al
+ * rettangolo modificato con il bordo di guided_nlmeans_halo, una piccola
+ * frazione di quelli dell'intera immagine.
+ */
+static void check_references(const char *name, const GuidedNLMeansProfile<PixelType> &opt) {
+	cv::Mat_<PixelType> noisy;
+	cv::Mat_<PixelGuidaType> guide;
+	cv::Mat_<bool> valid;
+	check_scene(192, 208, 12345u, noisy, guide, valid);
+	GuidedNLMeansInfo info;
+	GuidedNLMeansProfile<PixelType> counted( opt );
+	counted.info = &info;
+	cv::Mat_<PixelType> clean, sum;
+	check_run(noisy, guide, valid, counted, clean, sum);
+	double full = info.references;
+
+	std::vector<cv::Rect> dirty(1, cv::Rect(100, 90, 12, 9));
+	modify(dirty[0], 777u, noisy, guide, valid);
+	guided_nlmeans_update<PixelType, PixelGuidaType, CheckDistance1, CheckDistance2>(
+			noisy, guide, valid, dirty, clean, sum, counted);
+
+	// riferimenti della griglia della scena i cui blocchi (estesi di reach) intersecano il rettangolo influenzato
+	cv::Size halo = guided_nlmeans_halo(opt);
+	int reach = opt.aggregate_all ? (opt.search_diameter-1)/2 : 0;
+	cv::Rect r(dirty[0].x-halo.width, dirty[0].y-halo.height, dirty[0].width+2*halo.width, dirty[0].height+2*halo.height);
+	AdaptiveStepper stepper( noisy.rows, noisy.cols, opt.block_rows, opt.block_cols, opt.step );
+	double expected = 0;
+	for(int row = stepper.begin_row(); stepper.has_row(); row = stepper.next_row())
+		for(int col = stepper.begin_col(); stepper.has_col(); col = stepper.next_col())
+			if (row-reach < r.y+r.height && row+opt.block_rows+reach > r.y &&
+					col-reach < r.x+r.width && col+opt.block_cols+reach > r.x) expected++;
+	check_report(name, (expected < 0.25*full) ? fabs(info.references - expected) : HUGE_VAL, 0);
+}
+
+int main() {
+
+	GuidedNLMeansProfile<PixelType> opt;
+	check_profile(opt);
+
+	std::vector<cv::Rect> dirty;
+	dirty.push_back(cv::Rect(40, 30, 12, 9));
+	check_dirty("update, one rectangle", dirty, opt);
+	dirty.push_back(cv::Rect(45, 35, 20, 4));
+	dirty.push_back(cv::Rect(0, 88, 104, 8));
+	check_dirty("update, overlapping and border", dirty, opt);
+
+	GuidedNLMeansProfile<PixelType> variant( opt );
+	variant.aggregate_all = true;
+	check_dirty("update, aggregate_all", dirty, variant);
+	check_references("update, references of a small edit", opt);
+	check_references("update, references, aggregate_all", variant);
+
+	return check_failures;
+}
@@ -0,0 +1,47 @@
+#!/bin/sh
+# Compila ed esegue i controlli check_*.cpp (Linux 64 bit); termina con un
+# codice non nullo se un controllo fallisce:
+#
+#   cd ./src/checks
+#   sh run_checks.sh
+#
+# Servono le librerie statiche di OpenCV 2.1.0 usate da matlab/compile_a64.m
+# (libcv.a, libcxcore.a e libopencv_lapack.a nella cartella lib_static_a64) e un
+# g++ che accetti gli header di OpenCV 2.1.0 della cartella include (come quello
+# supportato da MATLAB 2017a, g++ 4.9; le versioni recenti rifiutano cxmat.hpp).
+# GNLM_FLAGS e GNLM_LIBS sostituiscono le opzioni e le librerie di default.
+
+FLAGS=${GNLM_FLAGS:-"-O3 -D_GLIBCXX_USE_CXX11_ABI=0 -I../../include -DGUIDA_NUM_BANDS=4"}
+LIBS=${GNLM_LIBS:-"../../lib_static_a64/libcv.a ../../lib_static_a64/libcxcore.a ../../lib_static_a64/libopencv_lapack.a"}
+
+# prerequisiti: librerie presenti e header di OpenCV compilabili
+for lib in $LIBS; do
+	case "$lib" in
+		-*) ;;
+		*) if [ ! -f "$lib" ]; then
+			echo "run_checks.sh: $lib not found; the checks need the OpenCV 2.1.0 static libraries" >&2
+			echo "  (libcv.a, libcxcore.a, libopencv_lapack.a, as matlab/compile_a64.m): copy them to" >&2
+			echo "  lib_static_a64 or set GNLM_LIBS" >&2
+			exit 2
+		fi ;;
+	esac
+done
+if ! printf '#include <opencv/cv.h>\nint main() { return 0; }\n' | g++ $FLAGS -x c++ -fsyntax-only - 2>/dev/null; then
+	echo "run_checks.sh: g++ $(g++ -dumpversion) cannot compile the OpenCV 2.1.0 headers with \"$FLAGS\";" >&2
+	echo "  use an older g++ (e.g. 4.9, as supported by MATLAB 2017a) or set GNLM_FLAGS" >&2
+	exit 2
+fi
+
+failed=0
+for src in check_*.cpp; do
+	name=${src%.cpp}
+	echo "== $name"
+	extra=""
+	if [ "$name" = check_capi ]; then extra="../capi/gnlm.cpp"; fi
+	if ! g++ $FLAGS $src $extra $LIBS -lpthread -lrt -o $name; then
+		failed=1
+		continue
+	fi
+	./$name || failed=1
+done
+exit $failed
@@ -105,6 +105,39 @@ void aggregation_iter( const Stack_Buffer<PixelType> &stackT2D, const std::vecto
 	}
 }
 
+/*
+ * Come aggregation_iter, con un peso diverso per ogni blocco: il blocco
+ * i-esimo e' aggregato con peso scale[i] (i blocchi con peso nullo sono ignorati).
+ */
+template <typename PixelType, typename ScaleType>
+void aggregation_iter_weighted( const Stack_Buffer<PixelType> &stackT2D, const std::vector< std::pair<int,int> > &matched, const std::vector<ScaleType> &scale, Sliding_Accessor<PixelType> &image, Sliding_Accessor<PixelType> &weights, const AggregationOptions<PixelType> &opt, int Nb )
+{
+
+	assert( stackT2D.blks() >= Nb && (int) matched.size() >= Nb && (int) scale.size() >= Nb );
+
+	// finestra 2D
+	const cv::Mat_<PixelType>& winMat = opt.win2D.getMatrix();
+
+	// blocco di 'appoggio'
+	cv::Mat_<PixelType> blockMat( stackT2D.rows() , stackT2D.cols() );
+
+	/* scorri i blocchi "matched" */
+	for(int i=0; i<Nb; i++)
+	{
+		if (scale[i] <= 0) continue;
+
+		// applicazione della finestra 2D sul blocco (per ridurre gli effetti ai bordi)
+		opt.win2D( stackT2D[i], blockMat );
+
+		int row = matched[i].first;
+		int col = matched[i].second;
+
+		// aggiornamento delle immagini d'uscita
+		multiply_and_accumulate( blockMat, scale[i], image(row,col) );		//   image(row,col) += blockMat * scale[i];
+		multiply_and_accumulate( winMat  , scale[i], weights(row,col) );	// weights(row,col) +=   winMat * scale[i];
+	}
+}
+
 template <typename PixelType, typename ScaleType>
 void aggregation1( const cv::Mat_<PixelType> &block,  std::pair<int,int> pos, const ScaleType &scale, Sliding_Accessor<PixelType> &image, Sliding_Accessor<PixelType> &weights, const AggregationOptions<PixelType> &opt ) {
 
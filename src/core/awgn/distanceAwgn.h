@@ -29,14 +29,17 @@ class DistanceAwgn
 	typedef Type DistanceType;
 	const int max_matched;		 // numero massimo di blocchi da selezionare
 	const Type max_distance;	 // distanza massima tra 2 blocchi
+	const bool stable_ties;		 // regola delle distanze identiche (vedi BlockMatchingDataList)
 
 	DistanceAwgn(BlockMatchOptions<Type> opt) :
-		max_matched(opt.max_matched), max_distance(opt.max_distance) {}
+		max_matched(opt.max_matched), max_distance(opt.max_distance), stable_ties(opt.stable_ties) {}
 
 	inline Type computeDistance( const cv::Mat_<Type> &src1, const cv::Mat_<Type> &src2, Type sup_distance) const;
 
 	inline Type computeDistance2( const cv::Mat_<Type> &srcY, const cv::Mat_<Type> &srcZ, const cv::Mat_<Type> &refY, const cv::Mat_<Type> &refZ, Type sup_distance) const;
 
+	inline Type computeTerm( const Type &el1, const Type &el2 ) const;
+
 	inline DistanceType getMaxMatched() const;
 
 	inline DistanceType getMaxMatched2() const;
@@ -92,6 +92,12 @@ inline Type DistanceAwgn<Type>::computeDistance2( const cv::Mat_<Type> &srcY, co
 	return dist;
 }
 
+template <typename Type>
+inline Type DistanceAwgn<Type>::computeTerm( const Type &el1, const Type &el2 ) const {
+	Type diff = el1-el2;
+	return diff*diff;
+}
+
 template <typename Type>
 inline typename DistanceAwgn<Type>::DistanceType DistanceAwgn<Type>::getMaxMatched() const {
 	return max_distance*max_distance;
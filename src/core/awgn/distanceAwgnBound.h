@@ -0,0 +1,105 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// 
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+// 
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * distanceAwgnBound.h
+ *
+ *  Created on: 19/10/2026
+ *
+ */
+#ifndef _DISTANCEAWGNBOUND_H_
+#define _DISTANCEAWGNBOUND_H_
+#include <vector>
+#include <cmath>
+#include <assert.h>
+#include <opencv/cv.h>
+#include "../block_matching.h"
+#include "../../utils/block_sums.h"
+
+/*
+ * Limite inferiore della SSD (DistanceAwgn, DistanceAwgnVec) calcolato dalle
+ * statistiche dei blocchi. Indicando con mu_k la media della banda k e con
+ * rho la norma del blocco privato delle medie di banda (n = block_rows*block_cols):
+ *
+ *     SSD(p,q) = n * sum_k (mu_p,k - mu_q,k)^2 + ||R_p - R_q||^2
+ *             >= n * sum_k (mu_p,k - mu_q,k)^2 + (rho_p - rho_q)^2
+ *
+ * Le statistiche sono calcolate una volta sola con le immagini integrali
+ * (una banda alla volta). Il limite viene ridotto di un piccolo margine per
+ * tenere conto degli arrotondamenti della SSD calcolata in singola precisione.
+ */
+template <typename Type, typename ElementType>
+class DistanceAwgnBound : public DistanceLowerBound<Type>
+{
+	typedef typename cv::DataType<ElementType>::channel_type channel_type;
+	enum { nc = cv::DataType<ElementType>::channels };
+
+	int cols_;					// num. di blocchi su una riga
+	double n;					// num. di pixel del blocco
+	std::vector<double> means;	// [blocco][banda]
+	std::vector<double> rho;	// norma del residuo
+	std::vector<double> energy;	// energia del blocco
+
+ public:
+
+	DistanceAwgnBound(const cv::Mat_<ElementType> &src, int block_rows, int block_cols, bool enabled=true)
+		: cols_(src.cols-block_cols+1), n(block_rows*block_cols) {
+		if (!enabled) return;
+		int rows = src.rows-block_rows+1;
+		size_t N = (size_t) rows*cols_;
+		means.resize(N*nc);
+		rho.resize(N);
+		energy.resize(N);
+
+		// medie di banda
+		cv::Mat_<double> band(src.rows, src.cols);
+		for(int k=0; k<nc; k++) {
+			for(int i=0; i<src.rows; i++) for(int j=0; j<src.cols; j++) {
+				band(i,j) = ((const channel_type*) &src(i,j))[k];
+			}
+			block_sums(band, block_rows, block_cols, means, nc, k);
+		}
+		for(size_t b=0; b<N*nc; b++) means[b] /= n;
+
+		// energia e norma del residuo
+		for(int i=0; i<src.rows; i++) for(int j=0; j<src.cols; j++) {
+			const channel_type* el = (const channel_type*) &src(i,j);
+			double e = 0;
+			for(int k=0; k<nc; k++) e += (double) el[k]*el[k];
+			band(i,j) = e;
+		}
+		block_sums(band, block_rows, block_cols, energy, 1, 0);
+		for(size_t b=0; b<N; b++) {
+			double r = energy[b];
+			for(int k=0; k<nc; k++) r -= n*means[b*nc+k]*means[b*nc+k];
+			rho[b] = std::sqrt(std::max(r, 0.0));
+		}
+	}
+
+	virtual Type lower_bound(std::pair<int,int> pos, std::pair<int,int> ref) const {
+		size_t p = (size_t) pos.first*cols_ + pos.second;
+		size_t q = (size_t) ref.first*cols_ + ref.second;
+		const double* mp = &means[p*nc];
+		const double* mq = &means[q*nc];
+		double dm = 0;
+		for(int k=0; k<nc; k++) {
+			double d = mp[k]-mq[k];
+			dm += d*d;
+		}
+		double dr = rho[p]-rho[q];
+		// margine per gli arrotondamenti (SSD in singola precisione, cancellazione nel residuo)
+		return (Type) ((1.0-1e-3)*(n*dm + dr*dr) - 1e-6*(energy[p]+energy[q]));
+	}
+
+};
+
+#endif
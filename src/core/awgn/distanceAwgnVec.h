@@ -32,9 +32,10 @@ class DistanceAwgnVec
     typedef cv::Vec<Type, nc> ElementType;
 	const int max_matched;		 // numero massimo di blocchi da selezionare
 	const Type max_distance;	 // distanza massima tra 2 blocchi
+	const bool stable_ties;		 // regola delle distanze identiche (vedi BlockMatchingDataList)
 
 	DistanceAwgnVec(BlockMatchOptions<Type> opt) :
-		max_matched(opt.max_matched), max_distance(opt.max_distance) {}
+		max_matched(opt.max_matched), max_distance(opt.max_distance), stable_ties(opt.stable_ties) {}
 
 	inline Type computeDistance( const cv::Mat_<ElementType> &src1, const cv::Mat_<ElementType> &src2, Type sup_distance) const {
     	assert( src1.rows == src2.rows && src1.cols == src2.cols );
@@ -57,6 +58,20 @@ class DistanceAwgnVec
         return dist;
     }
 
+	/*
+	 * Il metodo restituisce il contributo di una singola coppia di pixel
+	 * alla distanza (computeDistance e' la somma dei contributi sul blocco).
+	 */
+	inline Type computeTerm( const ElementType &el1, const ElementType &el2 ) const {
+        Type dist = Type();
+        Type diff;
+        for(int k=0; k < nc; k++) {
+            diff = el1[k] - el2[k];
+            dist += diff*diff;
+        }
+        return dist;
+    }
+
 	//inline Type computeDistance2( const cv::Mat_<ElementType> &srcY, const cv::Mat_<ElementType> &srcZ, const cv::Mat_<ElementType> &refY, const cv::Mat_<ElementType> &refZ, Type sup_distance) const;
 
 	inline DistanceType getMaxMatched() const {
@@ -0,0 +1,229 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// 
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+// 
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * pcaDescriptors.h
+ *
+ *  Created on: 19/10/2026
+ *
+ */
+#ifndef _PCADESCRIPTORS_H_
+#define _PCADESCRIPTORS_H_
+#include <vector>
+#include <cmath>
+#include <assert.h>
+#include <opencv/cv.h>
+
+/*
+ * Descrittori PCA dei blocchi della guida.
+ *
+ * Ogni blocco (block_rows x block_cols x nc valori) e' proiettato sui primi
+ * "dims" componenti principali, stimati da un campione di blocchi presi su
+ * una griglia regolare. La base e' calcolata con l'iterazione di sottospazio
+ * (V <- orth(X'XV)): per le distanze conta solo il sottospazio, quindi non
+ * serve ordinare i singoli autovettori.
+ *
+ * La proiezione e' una contrazione, per cui la distanza tra i descrittori
+ * non supera mai la SSD tra i blocchi originali.
+ */
+template <typename Type, typename ElementType>
+class PcaDescriptors
+{
+	typedef typename cv::DataType<ElementType>::channel_type channel_type;
+	enum { nc = cv::DataType<ElementType>::channels };
+
+	const cv::Mat_<ElementType> &src;
+	int block_rows;
+	int block_cols;
+	int rows_;					// num. di blocchi su una colonna
+	int cols_;					// num. di blocchi su una riga
+	int dims_;					// dimensione dei descrittori
+	int length;					// dimensione dei blocchi (block_rows*block_cols*nc)
+	double energy_;				// frazione dell'energia catturata dalla base
+
+	std::vector<double> mean;	// blocco medio
+	std::vector<double> basis;	// base [dims][length]
+	std::vector<Type> desc;		// descrittori [blocco][dims]
+
+	void get_block(int row, int col, std::vector<double> &x) const {
+		int t = 0;
+		for(int i=0; i<block_rows; i++) {
+			for(int j=0; j<block_cols; j++) {
+				const channel_type* el = (const channel_type*) &src(row+i, col+j);
+				for(int k=0; k<nc; k++) x[t++] = el[k];
+			}
+		}
+	}
+
+	/* ortonormalizzazione di Gram-Schmidt (modificato) delle righe di "v" */
+	static void orthonormalize(std::vector<double> &v, int dims, int length) {
+		for(int a=0; a<dims; a++) {
+			double* va = &v[(size_t)a*length];
+			for(int b=0; b<a; b++) {
+				const double* vb = &v[(size_t)b*length];
+				double dot = 0;
+				for(int t=0; t<length; t++) dot += va[t]*vb[t];
+				for(int t=0; t<length; t++) va[t] -= dot*vb[t];
+			}
+			double nrm = 0;
+			for(int t=0; t<length; t++) nrm += va[t]*va[t];
+			nrm = std::sqrt(nrm);
+			if (nrm > 0) for(int t=0; t<length; t++) va[t] /= nrm;
+		}
+	}
+
+	void learn(int max_samples, int iterations) {
+		int rows = rows_;
+		int stride = 1;
+		while (((rows+stride-1)/stride) * ((cols_+stride-1)/stride) > max_samples) stride++;
+
+		// campione centrato (una riga per blocco)
+		std::vector<double> X;
+		std::vector<double> x(length);
+		int N = 0;
+		for(int i=0; i<rows; i+=stride) {
+			for(int j=0; j<cols_; j+=stride) {
+				get_block(i, j, x);
+				X.insert(X.end(), x.begin(), x.end());
+				for(int t=0; t<length; t++) mean[t] += x[t];
+				N++;
+			}
+		}
+		for(int t=0; t<length; t++) mean[t] /= N;
+		double total = 0;
+		for(int n=0; n<N; n++) {
+			double* xn = &X[(size_t)n*length];
+			for(int t=0; t<length; t++) {
+				xn[t] -= mean[t];
+				total += xn[t]*xn[t];
+			}
+		}
+
+		// inizializzazione pseudo-casuale (riproducibile) della base
+		unsigned int seed = 12345u;
+		for(size_t t=0; t<basis.size(); t++) {
+			seed = seed*1103515245u + 12345u;
+			basis[t] = ((seed >> 8) & 0xFFFF) / 65536.0 - 0.5;
+		}
+		orthonormalize(basis, dims_, length);
+
+		// iterazione di sottospazio: V <- orth(X'(XV))
+		std::vector<double> Z((size_t)N*dims_);
+		for(int it=0; it<=iterations; it++) {
+			for(int n=0; n<N; n++) {
+				const double* xn = &X[(size_t)n*length];
+				for(int a=0; a<dims_; a++) {
+					const double* va = &basis[(size_t)a*length];
+					double dot = 0;
+					for(int t=0; t<length; t++) dot += xn[t]*va[t];
+					Z[(size_t)n*dims_+a] = dot;
+				}
+			}
+			if (it==iterations) break;
+			std::fill(basis.begin(), basis.end(), 0.0);
+			for(int n=0; n<N; n++) {
+				const double* xn = &X[(size_t)n*length];
+				for(int a=0; a<dims_; a++) {
+					double z = Z[(size_t)n*dims_+a];
+					double* va = &basis[(size_t)a*length];
+					for(int t=0; t<length; t++) va[t] += z*xn[t];
+				}
+			}
+			orthonormalize(basis, dims_, length);
+		}
+
+		// energia catturata
+		double captured = 0;
+		for(size_t t=0; t<Z.size(); t++) captured += Z[t]*Z[t];
+		energy_ = (total > 0) ? captured/total : 1.0;
+	}
+
+ public:
+
+	typedef Type DescriptorType;
+
+	/*
+	 * PARAMETRI D'INGRESSO:
+	 *   1) source          = immagine guida
+	 *   2) block_rows/cols = dimensioni dei blocchi
+	 *   3) dims            = dimensione dei descrittori (0 = descrittori non calcolati)
+	 *   4) max_samples     = numero massimo di blocchi usati per stimare la base
+	 *   5) iterations      = iterazioni di sottospazio
+	 */
+	PcaDescriptors(const cv::Mat_<ElementType> &source, int block_rows_, int block_cols_, int dims,
+			int max_samples=4096, int iterations=6)
+		: src(source), block_rows(block_rows_), block_cols(block_cols_),
+		  rows_(source.rows-block_rows_+1), cols_(source.cols-block_cols_+1), dims_(0),
+		  length(block_rows_*block_cols_*nc), energy_(0) {
+		if (dims <= 0) return;
+		dims_ = std::min(dims, length);
+		mean.assign(length, 0.0);
+		basis.resize((size_t)dims_*length);
+		learn(max_samples, iterations);
+
+		// proiezione di tutti i blocchi
+		desc.resize((size_t)rows_*cols_*dims_);
+		std::vector<double> x(length);
+		for(int i=0; i<rows_; i++) {
+			for(int j=0; j<cols_; j++) {
+				get_block(i, j, x);
+				for(int t=0; t<length; t++) x[t] -= mean[t];
+				Type* d = &desc[((size_t)i*cols_+j)*dims_];
+				for(int a=0; a<dims_; a++) {
+					const double* va = &basis[(size_t)a*length];
+					double dot = 0;
+					for(int t=0; t<length; t++) dot += x[t]*va[t];
+					d[a] = (Type) dot;
+				}
+			}
+		}
+	}
+
+	int dims() const {
+		return dims_;
+	}
+
+	int rows() const {
+		return rows_;
+	}
+
+	int cols() const {
+		return cols_;
+	}
+
+	/* descrittore del blocco "pos" */
+	inline const Type* descriptor(std::pair<int,int> pos) const {
+		return &desc[((size_t)pos.first*cols_+pos.second)*dims_];
+	}
+
+	/* frazione dell'energia (dei blocchi campionati) catturata dai descrittori */
+	double energy() const {
+		return energy_;
+	}
+
+	/*
+	 * Distanza approssimata (SSD tra i descrittori) tra i blocchi "pos" e "ref".
+	 */
+	inline Type operator()(std::pair<int,int> pos, std::pair<int,int> ref) const {
+		const Type* a = descriptor(pos);
+		const Type* b = descriptor(ref);
+		Type dist = Type();
+		for(int k=0; k<dims_; k++) {
+			Type diff = a[k]-b[k];
+			dist += diff*diff;
+		}
+		return dist;
+	}
+
+};
+
+#endif
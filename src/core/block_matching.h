@@ -23,14 +23,50 @@
 
 template <typename PixelType>
 struct BlockMatchOptions {
-	int max_matched;		 // numero massimo di blocchi da selezionare
+	int max_matched;		 // numero massimo di blocchi da selezionare (0 = tutti, vedi BlockMatchingDataList)
 	PixelType max_distance;	 // distanza massima tra 2 blocchi
+	bool stable_ties;		 // a parita' di distanza prevale il blocco inserito per primo (vedi BlockMatchingDataList)
 
 	BlockMatchOptions()
-			: max_matched(0), max_distance(PixelType()) {}
+			: max_matched(0), max_distance(PixelType()), stable_ties(false) {}
 
-	BlockMatchOptions( int matched, PixelType distance)
-		: max_matched(matched), max_distance(distance) {}
+	BlockMatchOptions( int matched, PixelType distance, bool stable = false)
+		: max_matched(matched), max_distance(distance), stable_ties(stable) {}
+};
+
+/*
+ * Limite inferiore (economico) di una distanza tra blocchi: permette di
+ * scartare un candidato senza calcolare la distanza completa.
+ * Il valore restituito non deve MAI superare la distanza calcolata.
+ */
+template <typename DistanceType>
+class DistanceLowerBound {
+ public:
+
+	/* contatori: limiti valutati e candidati scartati */
+	mutable double tests;
+	mutable double rejects;
+
+	DistanceLowerBound() : tests(0), rejects(0) {}
+
+	/*
+	 * Limite inferiore della distanza tra i blocchi di posizione "pos" e "ref".
+	 */
+	virtual DistanceType lower_bound(std::pair<int,int> pos, std::pair<int,int> ref) const =0;
+
+	/*
+	 * Il metodo restituisce "true" se la distanza supera sicuramente "sup_distance".
+	 */
+	virtual bool reject(std::pair<int,int> pos, std::pair<int,int> ref, DistanceType sup_distance) const {
+		tests++;
+		if (lower_bound(pos, ref) > sup_distance) {
+			rejects++;
+			return true;
+		}
+		return false;
+	}
+
+	virtual ~DistanceLowerBound() {};
 };
 
 template <typename Type, typename TypePoint>
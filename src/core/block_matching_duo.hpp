@@ -32,8 +32,25 @@
 
 #include "../utils/accessors.h"
 #include "../utils/neighborhood.h"
+#include "block_matching.h"
+#include "distance_cache.hpp"
 #include <assert.h>
+#include <limits>
+#include <vector>
+#include <algorithm>
 
+/*
+ * Lista dei blocchi con le distanze minori, in ordine crescente.
+ * A parita' di distanza vale la regola della versione 2018, per cui con
+ * distanze identiche (frequenti con alpha=0 e guida a valori interi) la lista
+ * dipende anche dai candidati inseriti e poi scartati; con "stable_ties"
+ * prevale il blocco inserito per primo e la lista dipende solo dalle distanze
+ * e dall'ordine di inserimento (come richiedono la ricerca con soglia
+ * iniziale e guided_nlmeans_multi per coincidere con la ricerca esaustiva
+ * con la stessa regola). Con max_length = 0 la lista non ha limiti: i
+ * candidati sono accumulati e ordinati una sola volta alla lettura (stesso
+ * ordine della lista limitata con "stable_ties", ma inserimento costante).
+ */
 template <typename TypeDist, typename TypeData, typename TypePoint>
         class BlockMatchingDataList {
     
@@ -44,28 +61,48 @@ template <typename TypeDist, typename TypeData, typename TypePoint>
         BlockMatchingItem* next;
     };
     
+    static bool closer(const BlockMatchingItem &a, const BlockMatchingItem &b) {
+        return a.dist < b.dist;
+    }
+    
     size_t size_;
     size_t max_size;
     TypeDist max_dist;
+    bool stable;
     BlockMatchingItem* head;
     BlockMatchingItem* allocate;
+    std::vector<BlockMatchingItem> collected;	// [SENZA LIMITE] candidati, ordinati alla lettura
+    bool sorted;
+    
+    inline void sort_collected() {
+        if (!sorted) std::stable_sort(collected.begin(), collected.end(), closer);
+        sorted = true;
+    }
     
         public:
             
-            BlockMatchingDataList( size_t max_length, TypeDist max_distance)
-            : size_(0),max_size(max_length),max_dist(max_distance),
-                    head(0),allocate(new BlockMatchingItem[max_length]) {};
+            BlockMatchingDataList( size_t max_length, TypeDist max_distance, bool stable_ties = false)
+            : size_(0),max_size(max_length),max_dist(max_distance),stable(stable_ties),
+                    head(0),allocate(new BlockMatchingItem[max_length]),sorted(true) {};
                     
                     ~BlockMatchingDataList() {
-                        delete allocate;
+                        delete[] allocate;
                     }
                     
                     inline size_t size() {
-                        return size_;
+                        return (max_size>0) ? size_ : collected.size();
                     }
                     
                     inline void getMatchingList(std::vector< TypeData > &dest_data ,
                             std::vector< TypePoint > &dest_point, size_t Q) {
+                        if (max_size==0) {
+                            sort_collected();
+                            for(size_t i = 0; i<collected.size() && i<Q; i++) {
+                                dest_data[i]  = collected[i].data;
+                                dest_point[i] = collected[i].point;
+                            }
+                            return;
+                        }
                         BlockMatchingItem* pos = head;
                         for(size_t i = size_; i>0;) {
                             if ((--i)<Q) {
@@ -76,9 +113,31 @@ template <typename TypeDist, typename TypeData, typename TypePoint>
                         }
                     }
                     
+                    // distanze di ordinamento, nello stesso ordine di getMatchingList
+                    inline void getMatchingDist(std::vector< TypeDist > &dest_dist, size_t Q) {
+                        if (max_size==0) {
+                            sort_collected();
+                            for(size_t i = 0; i<collected.size() && i<Q; i++) dest_dist[i] = collected[i].dist;
+                            return;
+                        }
+                        BlockMatchingItem* pos = head;
+                        for(size_t i = size_; i>0;) {
+                            if ((--i)<Q) dest_dist[i] = pos->dist;
+                            pos = pos->next;
+                        }
+                    }
+                    
                     inline TypeDist insert( TypeDist dist, TypeData data, TypePoint point ) {
                         BlockMatchingItem* pos_next = 0;
                         BlockMatchingItem* item = 0;
+                        if (max_size==0) {
+                            if (!(dist > max_dist)) {
+                                BlockMatchingItem added = { dist, data, point, 0 };
+                                collected.push_back(added);
+                                sorted = false;
+                            }
+                            return max_dist;
+                        }
                         if (size_ < max_size) {
                             if (dist > max_dist) {
                                 return max_dist;
@@ -94,9 +153,10 @@ template <typename TypeDist, typename TypeData, typename TypePoint>
                             }
                         }
                         
+                        // con "stable_ties" un blocco a pari distanza dell'ultimo lo segue
                         if (head==0) {
                             head = item;
-                        } else if ((head->dist)<dist) {
+                        } else if ((head->dist)<dist || (stable && (head->dist)==dist)) {
                             pos_next = head;
                             head = item;
                         } else {
@@ -120,15 +180,24 @@ template <typename TypeDist, typename TypeData, typename TypePoint>
                     }
 };
 
-template <typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1, typename OpDistance2>
-        void block_matching_duo_th(const Neighborhood& neighborhood, typename OpDistance1::DistanceType alpha1,
+/*
+ * Block matching sui candidati restituiti dall'iteratore "iter" (tutti
+ * appartenenti al vicinato), visitati nell'ordine dell'iteratore.
+ * Se "dest_sel" non e' nullo, vi sono copiate le distanze di selezione dei blocchi.
+ */
+template <typename CandidateIterator, typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1, typename OpDistance2>
+        void block_matching_duo_th_iter(CandidateIterator &iter, const Neighborhood& neighborhood, typename OpDistance1::DistanceType alpha1,
         typename OpDistance1::DistanceType th1,
         const OpDistance1 &opt1, const OpDistance2 &opt2,
         const BlockAccessor1 &src1, const BlockAccessor2 &src2,
         typename OpDistance1::DistanceType lambda1, typename OpDistance2::DistanceType lambda2,
         std::vector< std::pair<int,int> > &dest_point,
         std::vector<typename OpDistance1::DistanceType> &dest_dist,
-        const cv::Mat_<bool> &valClass) {
+        const cv::Mat_<bool> &valClass,
+        SymmetricDistanceCache<typename OpDistance1::DistanceType> *cache = 0,
+        const DistanceLowerBound<typename OpDistance2::DistanceType> *bound2 = 0,
+        const DistanceLowerBound<typename OpDistance1::DistanceType> *bound1 = 0,
+        std::vector<typename OpDistance1::DistanceType> *dest_sel = 0) {
     
     typedef typename BlockAccessor1::pixel_type pixel1_t;
     typedef typename BlockAccessor2::pixel_type pixel2_t;
@@ -140,15 +209,13 @@ template <typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1
     size_t Ncheck = 0;
     size_t NcheckTh1 = 0;
     size_t NcheckThEq = 0;
-    BlockMatchingDataList<dist_t, dist_t, std::pair<int,int> > list(opt1.max_matched, max_distance);
+    BlockMatchingDataList<dist_t, dist_t, std::pair<int,int> > list(opt1.max_matched, max_distance, opt1.stable_ties);
     
     if (valClass(neighborhood.central().first, neighborhood.central().second)) {
         
         // blocco di riferimento
         cv::Mat_<pixel1_t> ref_1block = src1(neighborhood.central().first, neighborhood.central().second);
         cv::Mat_<pixel2_t> ref_2block = src2(neighborhood.central().first, neighborhood.central().second);
-        IteratorScan2Fast iter(neighborhood);    
-        //IteratorSpiralFast iter(neighborhood);
         
         if (alpha1==0) {
             dist_t max_distance1 = opt1.max_distance;
@@ -160,10 +227,14 @@ template <typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1
                 std::pair<int,int> pos = iter.next();
                 if (valClass(pos.first,pos.second)) {
                     Ncheck++;
-                    dist_t dist1 = opt1.computeDistance(src1(pos.first,pos.second), ref_1block, max_distance1);
+                    // il candidato e' scartato se non supera il test SAR
+                    if (bound1 && bound1->reject(pos, neighborhood.central(), th1)) continue;
+                    // il candidato e' scartato se la distanza della guida supera la soglia
+                    if (bound2 && bound2->reject(pos, neighborhood.central(), max_distance)) continue;
+                    dist_t dist1 = cached_distance(cache, 0, pos, opt1, src1(pos.first,pos.second), ref_1block, max_distance1);
                     if (dist1<th1) {
 			NcheckTh1++;
-                        dist_t distS = opt2.computeDistance(src2(pos.first,pos.second), ref_2block, max_distance);
+                        dist_t distS = cached_distance(cache, 1, pos, opt2, src2(pos.first,pos.second), ref_2block, max_distance);
                         max_distance = list.insert( distS, lambda1*dist1+lambda2*distS, pos );
                     }
                 }
@@ -180,10 +251,12 @@ template <typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1
                 std::pair<int,int> pos = iter.next();
                 if (valClass(pos.first,pos.second)) {
                     Ncheck++;
-                    dist_t distS = opt1.computeDistance(src1(pos.first,pos.second), ref_1block, max_distance);
+                    // il candidato e' scartato se non supera il test SAR
+                    if (bound1 && bound1->reject(pos, neighborhood.central(), th1)) continue;
+                    dist_t distS = cached_distance(cache, 0, pos, opt1, src1(pos.first,pos.second), ref_1block, max_distance);
                     if (distS<th1) {
 			NcheckTh1++;
-                        dist_t dist2 = opt2.computeDistance(src2(pos.first,pos.second), ref_2block, max_distance2);
+                        dist_t dist2 = cached_distance(cache, 1, pos, opt2, src2(pos.first,pos.second), ref_2block, max_distance2);
                         // considera il blocco solo se la distanza � minore della soglia
                         max_distance = list.insert( distS, lambda1*distS+lambda2*dist2, pos );
                     }
@@ -199,12 +272,16 @@ template <typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1
                 std::pair<int,int> pos = iter.next();
                 if (valClass(pos.first,pos.second)) {
                     Ncheck++;
-                    dist_t dist1 = opt1.computeDistance(src1(pos.first,pos.second), ref_1block, max_distance/alpha1);
+                    // il candidato e' scartato se non supera il test SAR
+                    if (bound1 && bound1->reject(pos, neighborhood.central(), th1)) continue;
+                    // la distanza SAR e' non negativa: basta il contributo della guida
+                    if (bound2 && bound2->reject(pos, neighborhood.central(), max_distance/alpha2)) continue;
+                    dist_t dist1 = cached_distance(cache, 0, pos, opt1, src1(pos.first,pos.second), ref_1block, max_distance/alpha1);
                     dist_t dist2 = 0;
                     dist_t distS = max_distance;
                     if (dist1<th1) {
 			NcheckTh1++;
-                        dist2 = opt2.computeDistance(src2(pos.first,pos.second), ref_2block, max_distance/alpha2);
+                        dist2 = cached_distance(cache, 1, pos, opt2, src2(pos.first,pos.second), ref_2block, max_distance/alpha2);
                         distS = alpha1*dist1+alpha2*dist2;
                         // considera il blocco solo se la distanza � minore della soglia
                         max_distance = list.insert( distS, lambda1*dist1+lambda2*dist2, pos );
@@ -225,7 +302,178 @@ template <typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1
     dest_point.resize(N);
     dest_dist.resize(N);
     list.getMatchingList(dest_dist, dest_point, N);
+    if (dest_sel) {
+        // distanze di selezione (alpha1*dist1+alpha2*dist2) dei blocchi
+        dest_sel->resize(N);
+        list.getMatchingDist(*dest_sel, N);
+    }
+    
+}
+
+template <typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1, typename OpDistance2>
+        void block_matching_duo_th(const Neighborhood& neighborhood, typename OpDistance1::DistanceType alpha1,
+        typename OpDistance1::DistanceType th1,
+        const OpDistance1 &opt1, const OpDistance2 &opt2,
+        const BlockAccessor1 &src1, const BlockAccessor2 &src2,
+        typename OpDistance1::DistanceType lambda1, typename OpDistance2::DistanceType lambda2,
+        std::vector< std::pair<int,int> > &dest_point,
+        std::vector<typename OpDistance1::DistanceType> &dest_dist,
+        const cv::Mat_<bool> &valClass,
+        SymmetricDistanceCache<typename OpDistance1::DistanceType> *cache = 0,
+        const DistanceLowerBound<typename OpDistance2::DistanceType> *bound2 = 0,
+        const DistanceLowerBound<typename OpDistance1::DistanceType> *bound1 = 0,
+        std::vector<typename OpDistance1::DistanceType> *dest_sel = 0) {
+    
+    IteratorScan2Fast iter(neighborhood);
+    //IteratorSpiralFast iter(neighborhood);
+    block_matching_duo_th_iter(iter, neighborhood, alpha1, th1, opt1, opt2, src1, src2,
+            lambda1, lambda2, dest_point, dest_dist, valClass, cache, bound2, bound1, dest_sel);
+    
+}
+
+/*
+ * Versione di block_matching_duo_th in cui le distanze sono lette dalle somme
+ * incrementali di SlidingDistance (vedi sliding_distance.hpp), gia' centrate
+ * sul blocco di riferimento. La selezione e l'ordine di visita sono gli stessi
+ * della versione esaustiva; le distanze coincidono a meno degli arrotondamenti.
+ */
+template <typename SlidingDistance1, typename SlidingDistance2>
+        void block_matching_duo_th_inc(const Neighborhood& neighborhood, typename SlidingDistance1::DistanceType alpha1,
+        typename SlidingDistance1::DistanceType th1,
+        const SlidingDistance1 &sd1, const SlidingDistance2 &sd2,
+        typename SlidingDistance1::DistanceType lambda1, typename SlidingDistance2::DistanceType lambda2,
+        std::vector< std::pair<int,int> > &dest_point,
+        std::vector<typename SlidingDistance1::DistanceType> &dest_dist,
+        const cv::Mat_<bool> &valClass) {
+    
+    typedef typename SlidingDistance1::DistanceType dist_t;
+    
+    dist_t alpha2 = 1.0 - alpha1;
+    BlockMatchingDataList<dist_t, dist_t, std::pair<int,int> > list(sd1.distance().max_matched, sd1.distance().max_distance, sd1.distance().stable_ties);
+    
+    if (valClass(neighborhood.central().first, neighborhood.central().second)) {
+        
+        assert( sd1.central() == neighborhood.central() && sd2.central() == neighborhood.central() );
+        IteratorScan2Fast iter(neighborhood);
+        
+        while (iter.hasNext()) {
+            std::pair<int,int> pos = iter.next();
+            if (valClass(pos.first,pos.second)) {
+                dist_t dist1 = sd1(pos);
+                if (dist1<th1) {
+                    dist_t dist2 = sd2(pos);
+                    dist_t distS = (alpha1==0) ? dist2 : ((alpha1==1) ? dist1 : alpha1*dist1+alpha2*dist2);
+                    list.insert( distS, lambda1*dist1+lambda2*dist2, pos );
+                }
+            }
+        }
+    } else {
+        list.insert( 0.0, 1.0, neighborhood.central());
+    }
+    
+    size_t N = list.size();
+    dest_point.resize(N);
+    dest_dist.resize(N);
+    list.getMatchingList(dest_dist, dest_point, N);
+    
+}
+
+/*
+ * Versione di block_matching_duo_th in cui la distanza della guida usata per
+ * la selezione e' quella approssimata tra i descrittori (vedi
+ * awgn/pcaDescriptors.h); le distanze restituite (e quindi i pesi) usano
+ * sempre la distanza esatta dei blocchi selezionati.
+ * Se rerank>0 sono selezionati rerank*max_matched candidati con la distanza
+ * approssimata e, tra questi, i max_matched migliori con la distanza esatta;
+ * in "changes" e' accumulato il numero di blocchi selezionati dal re-ranking
+ * che non sarebbero stati scelti con la sola distanza approssimata, in
+ * "avoided" quello delle distanze esatte della guida non calcolate (candidati
+ * che superano il test SAR meno distanze calcolate).
+ */
+template <typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1, typename OpDistance2, typename Descriptors>
+        void block_matching_duo_th_desc(const Neighborhood& neighborhood, typename OpDistance1::DistanceType alpha1,
+        typename OpDistance1::DistanceType th1,
+        const OpDistance1 &opt1, const OpDistance2 &opt2,
+        const BlockAccessor1 &src1, const BlockAccessor2 &src2,
+        const Descriptors &desc, size_t rerank,
+        typename OpDistance1::DistanceType lambda1, typename OpDistance2::DistanceType lambda2,
+        std::vector< std::pair<int,int> > &dest_point,
+        std::vector<typename OpDistance1::DistanceType> &dest_dist,
+        const cv::Mat_<bool> &valClass, size_t &changes, size_t &avoided,
+        const DistanceLowerBound<typename OpDistance1::DistanceType> *bound1 = 0) {
+    
+    typedef typename BlockAccessor1::pixel_type pixel1_t;
+    typedef typename BlockAccessor2::pixel_type pixel2_t;
+    typedef typename    OpDistance1::DistanceType dist_t;
+    typedef std::pair<dist_t,dist_t> dist_pair;
+    
+    if (!valClass(neighborhood.central().first, neighborhood.central().second)) {
+        dest_point.assign(1, neighborhood.central());
+        dest_dist.assign(1, 1.0);
+        return;
+    }
+    
+    dist_t alpha2 = 1.0 - alpha1;
+    size_t Q = opt1.max_matched;
+    BlockMatchingDataList<dist_t, dist_pair, std::pair<int,int> > list((rerank>0) ? rerank*Q : Q, opt1.max_distance, opt1.stable_ties);
+    
+    // blocchi di riferimento
+    cv::Mat_<pixel1_t> ref_1block = src1(neighborhood.central().first, neighborhood.central().second);
+    cv::Mat_<pixel2_t> ref_2block = src2(neighborhood.central().first, neighborhood.central().second);
+    IteratorScan2Fast iter(neighborhood);
+    size_t passed = 0;
     
+    while (iter.hasNext()) {
+        std::pair<int,int> pos = iter.next();
+        if (valClass(pos.first,pos.second)) {
+            // il candidato e' scartato se non supera il test SAR
+            if (bound1 && bound1->reject(pos, neighborhood.central(), th1)) continue;
+            dist_t dist1 = opt1.computeDistance(src1(pos.first,pos.second), ref_1block, opt1.max_distance);
+            if (dist1<th1) {
+                passed++;
+                dist_t dist2 = desc(pos, neighborhood.central());
+                dist_t distS = (alpha1==0) ? dist2 : ((alpha1==1) ? dist1 : alpha1*dist1+alpha2*dist2);
+                list.insert( distS, dist_pair(dist1, dist2), pos );
+            }
+        }
+    }
+    
+    size_t N = list.size();
+    std::vector<dist_pair> dists(N);
+    std::vector< std::pair<int,int> > points(N);
+    list.getMatchingList(dists, points, N);
+    avoided += passed - N;
+    
+    if (rerank>0) {
+        // re-ranking con la distanza esatta della guida
+        typedef std::pair<dist_t,size_t> data_t;
+        BlockMatchingDataList<dist_t, data_t, std::pair<int,int> > list2(Q, std::numeric_limits<dist_t>::max(), opt1.stable_ties);
+        for(size_t i=0; i<N; i++) {
+            std::pair<int,int> pos = points[i];
+            dist_t dist1 = dists[i].first;
+            dist_t dist2 = opt2.computeDistance(src2(pos.first,pos.second), ref_2block, std::numeric_limits<dist_t>::max());
+            dist_t distS = (alpha1==0) ? dist2 : ((alpha1==1) ? dist1 : alpha1*dist1+alpha2*dist2);
+            list2.insert( distS, data_t(lambda1*dist1+lambda2*dist2, i), pos );
+        }
+        N = list2.size();
+        std::vector<data_t> data(N);
+        dest_point.resize(N);
+        dest_dist.resize(N);
+        list2.getMatchingList(data, dest_point, N);
+        for(size_t i=0; i<N; i++) {
+            dest_dist[i] = data[i].first;
+            if (data[i].second>=Q) changes++;
+        }
+    } else {
+        // pesi con la distanza esatta della guida dei blocchi selezionati
+        dest_point.swap(points);
+        dest_dist.resize(N);
+        for(size_t i=0; i<N; i++) {
+            std::pair<int,int> pos = dest_point[i];
+            dist_t dist2 = opt2.computeDistance(src2(pos.first,pos.second), ref_2block, std::numeric_limits<dist_t>::max());
+            dest_dist[i] = lambda1*dists[i].first+lambda2*dist2;
+        }
+    }
     
 }
 
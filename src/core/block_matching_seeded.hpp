@@ -0,0 +1,203 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// 
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+// 
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * block_matching_seeded.hpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Block matching esaustivo con soglia iniziale ricavata dai blocchi
+ *  selezionati per il "reference block" precedente.
+ */
+#ifndef _BLOCK_MATCHING_SEEDED_HPP_
+#define _BLOCK_MATCHING_SEEDED_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <cmath>
+#include "../utils/neighborhood.h"
+#include "block_matching.h"
+#include "block_matching_duo.hpp"
+
+/*
+ * I blocchi selezionati per il riferimento precedente (sulla stessa riga o,
+ * per il primo riferimento di una riga, per il primo della riga precedente)
+ * che cadono nel nuovo vicinato sono valutati per primi. Se almeno
+ * max_matched di essi superano il test SAR, la max_matched-esima distanza T
+ * e' un limite superiore della distanza dell'ultimo blocco selezionato dalla
+ * ricerca esaustiva: durante la scansione i candidati con distanza maggiore
+ * di T sono scartati, calcolando la distanza della guida (con PDE rispetto
+ * a T) prima di quella SAR.
+ *
+ * I candidati scartati non possono comparire nella lista finale e quelli
+ * restanti sono inseriti nello stesso ordine e con gli stessi valori della
+ * versione esaustiva (IteratorScan2Fast, stessi argomenti delle distanze):
+ * la lista (sempre con "stable_ties", perche' con la regola della versione
+ * 2018 l'ordine delle distanze identiche dipende anche dai candidati
+ * scartati) coincide con quella di block_matching_duo_th con stable_ties.
+ */
+class SeededBlockMatching
+{
+	typedef std::pair<int,int> pair;
+
+	int radius;
+	int diameter;
+
+	/* distanze dei "seed" per il riferimento corrente */
+	std::vector<unsigned int> visited;
+	std::vector<double> seed_dist1;
+	std::vector<double> seed_dist2;
+	unsigned int stamp;
+
+	/* blocchi selezionati dai riferimenti precedenti */
+	std::vector<pair> previous;		// riferimento precedente sulla riga
+	std::vector<pair> row_first;	// primo riferimento della riga precedente
+	std::vector<pair> row_first_next;
+	int current_row;
+
+ public:
+
+	/* statistiche */
+	double seeds;		// "seed" valutati
+	double seeded;		// riferimenti con soglia iniziale
+	double pruned;		// candidati scartati con la soglia iniziale
+
+	SeededBlockMatching(int search_diameter)
+		: radius((search_diameter-1)/2), diameter(search_diameter),
+		  visited((size_t)search_diameter*search_diameter, 0u),
+		  seed_dist1((size_t)search_diameter*search_diameter),
+		  seed_dist2((size_t)search_diameter*search_diameter),
+		  stamp(0), current_row(-1), seeds(0), seeded(0), pruned(0) {}
+
+	template <typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1, typename OpDistance2>
+	void match(const Neighborhood& neighborhood, typename OpDistance1::DistanceType alpha1,
+			typename OpDistance1::DistanceType th1,
+			const OpDistance1 &opt1, const OpDistance2 &opt2,
+			const BlockAccessor1 &src1, const BlockAccessor2 &src2,
+			typename OpDistance1::DistanceType lambda1, typename OpDistance2::DistanceType lambda2,
+			std::vector<pair> &dest_point,
+			std::vector<typename OpDistance1::DistanceType> &dest_dist,
+			const cv::Mat_<bool> &valClass,
+			const DistanceLowerBound<typename OpDistance2::DistanceType> *bound2 = 0,
+			const DistanceLowerBound<typename OpDistance1::DistanceType> *bound1 = 0) {
+
+		typedef typename BlockAccessor1::pixel_type pixel1_t;
+		typedef typename BlockAccessor2::pixel_type pixel2_t;
+		typedef typename    OpDistance1::DistanceType dist_t;
+
+		pair center = neighborhood.central();
+		bool first_of_row = (center.first != current_row);
+		if (first_of_row) {
+			current_row = center.first;
+			row_first.swap(row_first_next);
+		}
+		const std::vector<pair> &seed_list = first_of_row ? row_first : previous;
+
+		if ((++stamp) == 0) {
+			std::fill(visited.begin(), visited.end(), 0u);
+			stamp = 1;
+		}
+
+		dist_t alpha2 = 1.0 - alpha1;
+		dist_t inf = std::numeric_limits<dist_t>::max();
+		BlockMatchingDataList<dist_t, dist_t, pair> list(opt1.max_matched, opt1.max_distance, true);
+
+		if (valClass(center.first, center.second)) {
+
+			cv::Mat_<pixel1_t> ref_1block = src1(center.first, center.second);
+			cv::Mat_<pixel2_t> ref_2block = src2(center.first, center.second);
+
+			// distanze dei "seed" e soglia iniziale
+			std::vector<dist_t> seed_distS;
+			for(size_t i=0; i<seed_list.size(); i++) {
+				pair pos = seed_list[i];
+				if (!neighborhood.validate(pos) || !valClass(pos.first,pos.second)) continue;
+				size_t index = (size_t)(pos.first-center.first+radius)*diameter + (pos.second-center.second+radius);
+				if (visited[index] == stamp) continue;
+				visited[index] = stamp;
+				seeds++;
+				dist_t dist1 = opt1.computeDistance(src1(pos.first,pos.second), ref_1block, opt1.max_distance);
+				dist_t dist2 = opt2.computeDistance(src2(pos.first,pos.second), ref_2block, inf);
+				seed_dist1[index] = dist1;
+				seed_dist2[index] = dist2;
+				dist_t distS = (alpha1==0) ? dist2 : ((alpha1==1) ? dist1 : alpha1*dist1+alpha2*dist2);
+				if (dist1<th1 && distS<=opt1.max_distance) seed_distS.push_back(distS);
+			}
+			dist_t T = inf;
+			size_t K = opt1.max_matched;
+			if (K>0 && seed_distS.size()>=K) {
+				std::nth_element(seed_distS.begin(), seed_distS.begin()+(K-1), seed_distS.end());
+				T = seed_distS[K-1];
+				seeded++;
+			}
+
+			dist_t max_distance = (alpha1==0) ? opt2.max_distance :
+					((alpha1==1) ? opt1.max_distance : alpha1*opt1.max_distance+alpha2*opt2.max_distance);
+			IteratorScan2Fast iter(neighborhood);
+			while (iter.hasNext()) {
+				pair pos = iter.next();
+				if (!valClass(pos.first,pos.second)) continue;
+				// il candidato e' scartato se non supera il test SAR
+				if (bound1 && bound1->reject(pos, center, th1)) continue;
+				size_t index = (size_t)(pos.first-center.first+radius)*diameter + (pos.second-center.second+radius);
+				bool is_seed = (visited[index] == stamp);
+				dist_t sup = std::min(max_distance, T);
+
+				dist_t dist1 = 0, dist2 = 0, distS = 0;
+				if (alpha1==1) {
+					dist1 = is_seed ? (dist_t) seed_dist1[index] :
+							opt1.computeDistance(src1(pos.first,pos.second), ref_1block, max_distance);
+					if (dist1>T) { pruned++; continue; }
+					if (!(dist1<th1)) continue;
+					dist2 = is_seed ? (dist_t) seed_dist2[index] :
+							opt2.computeDistance(src2(pos.first,pos.second), ref_2block, opt2.max_distance);
+					distS = dist1;
+				} else {
+					// prima la distanza della guida, con PDE rispetto alla soglia
+					// (con alpha>0 la soglia ha un margine per gli arrotondamenti del termine SAR)
+					dist_t Tm = (alpha1==0 || T==inf) ? T : T + (dist_t) 1e-3*(std::abs(T)+1);
+					dist_t sup2 = (alpha1==0) ? sup : std::min(max_distance, Tm)/alpha2;
+					if (bound2 && bound2->reject(pos, center, sup2)) continue;
+					dist2 = is_seed ? (dist_t) seed_dist2[index] :
+							opt2.computeDistance(src2(pos.first,pos.second), ref_2block, sup2);
+					if (alpha2*dist2>Tm) { pruned++; continue; }
+					if (alpha1!=0 && !is_seed && dist2>sup2 && sup2<max_distance/alpha2) {
+						// interrotta dalla soglia ma non esclusa: distanza completa come nella versione esaustiva
+						dist2 = opt2.computeDistance(src2(pos.first,pos.second), ref_2block, max_distance/alpha2);
+					}
+					dist1 = is_seed ? (dist_t) seed_dist1[index] :
+							opt1.computeDistance(src1(pos.first,pos.second), ref_1block,
+							(alpha1==0) ? opt1.max_distance : max_distance/alpha1);
+					if (!(dist1<th1)) continue;
+					distS = (alpha1==0) ? dist2 : alpha1*dist1+alpha2*dist2;
+					if (distS>T) { pruned++; continue; }
+				}
+				max_distance = list.insert( distS, lambda1*dist1+lambda2*dist2, pos );
+			}
+		} else {
+			list.insert( 0.0, 1.0, center );
+		}
+
+		size_t N = list.size();
+		dest_point.resize(N);
+		dest_dist.resize(N);
+		list.getMatchingList(dest_dist, dest_point, N);
+
+		previous = dest_point;
+		if (first_of_row) row_first_next = dest_point;
+	}
+
+};
+
+#endif
@@ -0,0 +1,133 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * block_matching_temporal.hpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Block matching di una serie multi-temporale di immagini SAR con una
+ *  sola guida: la distanza della guida e' calcolata una volta per ogni
+ *  coppia (riferimento, candidato) e condivisa da tutte le date.
+ */
+#ifndef _BLOCK_MATCHING_TEMPORAL_HPP_
+#define _BLOCK_MATCHING_TEMPORAL_HPP_
+
+#include <vector>
+#include <utility>
+#include <limits>
+#include <algorithm>
+#include "../utils/neighborhood.h"
+#include "block_matching.h"
+#include "block_matching_duo.hpp"
+
+/*
+ * Block matching con una lista per ogni data (src1[t]) e la distanza della
+ * guida (src2) comune: per ogni candidato sono calcolate le distanze SAR di
+ * tutte le date e, se almeno una supera il test SAR, una sola distanza della
+ * guida (con PDE rispetto alla soglia piu' ampia delle liste interessate).
+ * Le liste coincidono con quelle di block_matching_duo_th per ogni data.
+ *
+ * Con "joint" la distanza SAR e' la somma delle distanze delle date
+ * (OpDistance1::computeDistanceSum), moltiplicata per "joint_scale" (1/N
+ * per la media), e c'e' una sola lista
+ * (dest_point[0], dest_dist[0]), comune a tutte le date.
+ * "guide_distances" conta le distanze della guida calcolate.
+ */
+template <typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1, typename OpDistance2>
+        void block_matching_duo_th_temporal(const Neighborhood& neighborhood, typename OpDistance1::DistanceType alpha1,
+        typename OpDistance1::DistanceType th1,
+        const OpDistance1 &opt1, const OpDistance2 &opt2,
+        const std::vector<const BlockAccessor1*> &src1, const BlockAccessor2 &src2,
+        typename OpDistance1::DistanceType lambda1, typename OpDistance2::DistanceType lambda2,
+        std::vector< std::vector< std::pair<int,int> > > &dest_point,
+        std::vector< std::vector<typename OpDistance1::DistanceType> > &dest_dist,
+        const cv::Mat_<bool> &valClass, bool joint, double joint_scale, double &guide_distances) {
+
+    typedef typename BlockAccessor1::pixel_type pixel1_t;
+    typedef typename BlockAccessor2::pixel_type pixel2_t;
+    typedef typename    OpDistance1::DistanceType dist_t;
+    typedef BlockMatchingDataList<dist_t, dist_t, std::pair<int,int> > list_t;
+
+    int num_dates = (int) src1.size();
+    int num_lists = joint ? 1 : num_dates;
+    dist_t alpha2 = 1.0 - alpha1;
+    dist_t inf = std::numeric_limits<dist_t>::infinity();
+    std::pair<int,int> center = neighborhood.central();
+
+    std::vector<list_t*> lists(num_lists);
+    std::vector<dist_t> sup(num_lists);
+    for(int t=0; t<num_lists; t++) {
+        lists[t] = new list_t(opt1.max_matched, opt1.max_distance, opt1.stable_ties);
+        sup[t] = inf;
+    }
+
+    if (valClass(center.first, center.second)) {
+
+        // blocchi di riferimento
+        std::vector< cv::Mat_<pixel1_t> > ref_1block(num_dates);
+        for(int t=0; t<num_dates; t++) ref_1block[t] = (*src1[t])(center.first, center.second);
+        cv::Mat_<pixel2_t> ref_2block = src2(center.first, center.second);
+        std::vector<dist_t> dist1(num_dates);
+        std::vector< cv::Mat_<pixel1_t> > cand_1block(num_dates);
+
+        IteratorScan2Fast iter(neighborhood);
+        while (iter.hasNext()) {
+            std::pair<int,int> pos = iter.next();
+            if (!valClass(pos.first,pos.second)) continue;
+
+            // distanze SAR (con "joint" la somma delle date, in un solo passo, pesata)
+            if (joint) {
+                for(int t=0; t<num_dates; t++) cand_1block[t] = (*src1[t])(pos.first,pos.second);
+                dist1[0] = (dist_t) (opt1.computeDistanceSum(cand_1block, ref_1block) * joint_scale);
+            } else {
+                for(int t=0; t<num_dates; t++)
+                    dist1[t] = opt1.computeDistance((*src1[t])(pos.first,pos.second), ref_1block[t], inf);
+            }
+
+            // soglia della distanza della guida: la piu' ampia tra le liste interessate
+            bool passed = false;
+            dist_t sup2 = -inf;
+            for(int t=0; t<num_lists; t++) {
+                if (!(dist1[t]<th1)) continue;
+                passed = true;
+                sup2 = (alpha2>0) ? std::max(sup2, sup[t]/alpha2) : inf;
+            }
+            if (!passed) continue;
+
+            // distanza della guida, una sola per tutte le date
+            dist_t dist2 = opt2.computeDistance(src2(pos.first,pos.second), ref_2block, sup2);
+            guide_distances++;
+
+            for(int t=0; t<num_lists; t++) {
+                if (!(dist1[t]<th1)) continue;
+                dist_t distS = (alpha1==0) ? dist2 : ((alpha1==1) ? dist1[t] : alpha1*dist1[t]+alpha2*dist2);
+                sup[t] = lists[t]->insert( distS, lambda1*dist1[t]+lambda2*dist2, pos );
+            }
+        }
+    } else {
+        for(int t=0; t<num_lists; t++) lists[t]->insert( 0.0, 1.0, center );
+    }
+
+    dest_point.resize(num_lists);
+    dest_dist.resize(num_lists);
+    for(int t=0; t<num_lists; t++) {
+        size_t N = lists[t]->size();
+        dest_point[t].resize(N);
+        dest_dist[t].resize(N);
+        lists[t]->getMatchingList(dest_dist[t], dest_point[t], N);
+        delete lists[t];
+    }
+
+}
+
+#endif /* _BLOCK_MATCHING_TEMPORAL_HPP_ */
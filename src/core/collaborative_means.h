@@ -22,7 +22,17 @@
 #include "../utils/buffers.h"
 
 template <typename PixelType>
-PixelType collaborative_means( Stack_Buffer<PixelType> &stackT3D, std::vector<PixelType> &dest_dist, int Nb);
+PixelType collaborative_weights( const std::vector<PixelType> &dists, PixelType filter_parameter, int Nb, std::vector<PixelType> &weights);
+
+template <typename PixelType>
+PixelType collaborative_means_weighted( Stack_Buffer<PixelType> &stackT3D, const std::vector<PixelType> &weights, PixelType w_sum, int Nb);
+
+template <typename PixelType>
+PixelType collaborative_means( Stack_Buffer<PixelType> &stackT3D, std::vector<PixelType> &dists, PixelType filter_parameter, int Nb, std::vector<PixelType> *block_weights = 0);
+
+template <typename PixelType>
+int collaborative_truncation( std::vector< std::pair<int,int> > &points, std::vector<PixelType> &dists,
+		std::vector<PixelType> &weights, PixelType &w_sum, int Nb, double tolerance);
 
 #include "collaborative_means.hpp"
 #endif
@@ -25,18 +25,22 @@
 #include <assert.h>
 #include "win2D.h"
 
+/*
+ * Pesi dei blocchi dello stack (1 per il blocco di riferimento, exp(-(d-d_min)/h^2)
+ * per gli altri, 0 se tutti sono troppo lontani) copiati in "weights"; il metodo
+ * restituisce la loro somma. I pesi sono calcolati una volta e usati sia da
+ * collaborative_truncation sia da collaborative_means_weighted.
+ */
 template <typename PixelType>
-PixelType collaborative_means( Stack_Buffer<PixelType> &stackT3D, std::vector<PixelType> &dists, PixelType filter_parameter, int Nb) {
+PixelType collaborative_weights( const std::vector<PixelType> &dists, PixelType filter_parameter, int Nb, std::vector<PixelType> &weights) {
 
-	// dimensioni degli stack
-	int Nr = stackT3D.rows();
-	int Nc = stackT3D.cols();
-	PixelType w_sum;
+	PixelType w_sum = 1.0;
 	PixelType w;
 	PixelType d_min = PixelType(0.0);
 	filter_parameter *= filter_parameter;
-	cv::Mat_<PixelType> blockSup(Nr,Nc,PixelType());
-	
+	weights.assign(std::max(Nb, 1), PixelType(0.0));
+	weights[0] = PixelType(1.0);
+
 	if (Nb>1) {
 		d_min = dists[1];
 		for(int k=1; k < Nb; k++ ) {
@@ -45,21 +49,35 @@ PixelType collaborative_means( Stack_Buffer<PixelType> &stackT3D, std::vector<Pi
 			}
 		}
 	}
-	
-	if (d_min>16*filter_parameter) {
-		w_sum = 1.0;
-		multiply_and_accumulate(stackT3D[0],PixelType(1.0),blockSup);
-		//mexPrintf("corrected  %d %f %f \n", Nb, dists[0], d_min);
-	} else {
-		w_sum = 1.0;
-		multiply_and_accumulate(stackT3D[0],PixelType(1.0),blockSup);
-		for(int k=1; k < Nb; k++ ) {
-			w = exp(-(dists[k]-d_min)/filter_parameter);
-			multiply_and_accumulate(stackT3D[k],w,blockSup);
-			w_sum += w;
-		}
+
+	// solo il blocco di riferimento
+	if (d_min>16*filter_parameter) return w_sum;
+
+	for(int k=1; k < Nb; k++ ) {
+		w = exp(-(dists[k]-d_min)/filter_parameter);
+		weights[k] = w;
+		w_sum += w;
+	}
+	return w_sum;
+}
+
+/*
+ * Media dei primi Nb blocchi dello stack con i pesi "weights" (di somma w_sum),
+ * che sostituisce tutti i blocchi dello stack; restituisce w_sum.
+ */
+template <typename PixelType>
+PixelType collaborative_means_weighted( Stack_Buffer<PixelType> &stackT3D, const std::vector<PixelType> &weights, PixelType w_sum, int Nb) {
+
+	// dimensioni degli stack
+	int Nr = stackT3D.rows();
+	int Nc = stackT3D.cols();
+	cv::Mat_<PixelType> blockSup(Nr,Nc,PixelType());
+
+	multiply_and_accumulate(stackT3D[0],PixelType(1.0),blockSup);
+	for(int k=1; k < Nb; k++ ) {
+		if (weights[k] != 0) multiply_and_accumulate(stackT3D[k],weights[k],blockSup);
 	}
-	
+
 	blockSup /= w_sum;
 
 	for( int k=0; k < Nb; k++ ) {
@@ -70,6 +88,51 @@ PixelType collaborative_means( Stack_Buffer<PixelType> &stackT3D, std::vector<Pi
 	return w_sum;
 }
 
+/*
+ * Media pesata dello stack (il risultato sostituisce tutti i blocchi dello
+ * stack); se "block_weights" non e' nullo, vi sono copiati i pesi dei blocchi.
+ */
+template <typename PixelType>
+PixelType collaborative_means( Stack_Buffer<PixelType> &stackT3D, std::vector<PixelType> &dists, PixelType filter_parameter, int Nb, std::vector<PixelType> *block_weights) {
+
+	std::vector<PixelType> weights;
+	PixelType w_sum = collaborative_weights(dists, filter_parameter, Nb, weights);
+	if (block_weights) block_weights->swap(weights);
+	return collaborative_means_weighted(stackT3D, block_weights ? *block_weights : weights, w_sum, Nb);
+}
+
+/*
+ * Troncamento dello stack: il metodo conserva (compattandoli in testa a
+ * "points", "dists" e "weights", il blocco di riferimento per primo) solo i
+ * blocchi con peso (da collaborative_weights) non inferiore a tolerance*W/Nb,
+ * dove W = w_sum e' la somma dei pesi di tutti gli Nb blocchi, aggiorna w_sum
+ * alla somma dei pesi conservati e restituisce il numero di blocchi conservati.
+ * I pesi scartati sono al piu' tolerance*W, e la media di
+ * collaborative_means_weighted sui blocchi conservati differisce di
+ * conseguenza per meno di "tolerance" (in rapporto alla dinamica dei blocchi).
+ */
+template <typename PixelType>
+int collaborative_truncation( std::vector< std::pair<int,int> > &points, std::vector<PixelType> &dists,
+		std::vector<PixelType> &weights, PixelType &w_sum, int Nb, double tolerance) {
+
+	if (Nb<=1 || tolerance<=0) return Nb;
+
+	// soglia sul peso: il blocco col peso massimo (pari a 1) e' sempre conservato
+	PixelType w_min = (PixelType) (tolerance*w_sum/Nb);
+	int Nk = 1;
+	w_sum = 1.0;
+	for(int k=1; k < Nb; k++ ) {
+		if (weights[k]>=w_min) {
+			points[Nk]  = points[k];
+			dists[Nk]   = dists[k];
+			weights[Nk] = weights[k];
+			w_sum += weights[k];
+			Nk++;
+		}
+	}
+	return Nk;
+}
+
 
 
 #endif
@@ -0,0 +1,235 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// 
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+// 
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * descriptor_forest.hpp
+ *
+ *  Created on: 19/10/2026
+ *
+ */
+#ifndef _DESCRIPTOR_FOREST_HPP_
+#define _DESCRIPTOR_FOREST_HPP_
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <limits>
+
+/*
+ * Kd-tree dei descrittori dei blocchi (ad es. PcaDescriptors), uno per ogni
+ * tassello (tile_size x tile_size posizioni) dell'immagine.
+ *
+ * La ricerca restituisce gli M blocchi piu' vicini (nello spazio dei
+ * descrittori) al blocco di riferimento tra quelli interni al vicinato:
+ * sono visitati solo i tasselli che intersecano il vicinato e i nodi sono
+ * scartati sia per la posizione sia per la distanza dal piano di taglio.
+ * I candidati sono restituiti nell'ordine di visita di IteratorScan2Fast,
+ * quindi se M non e' inferiore all'area del vicinato il risultato del
+ * block matching coincide con quello esaustivo (tranne per i riferimenti
+ * sulla prima riga, dove IteratorScan2Fast visita due volte la riga centrale).
+ */
+template <typename Descriptors>
+class DescriptorForest
+{
+	typedef typename Descriptors::DescriptorType Type;
+	typedef std::pair<int,int> pair;
+	typedef std::pair<Type,int> item;
+
+	struct Node {
+		int dim;					// componente del taglio (-1 = foglia)
+		Type split;					// soglia del taglio
+		int left, right;			// figli
+		int begin, end;				// blocchi della foglia
+		int rmin, rmax, cmin, cmax;	// estensione spaziale dei blocchi del nodo
+	};
+
+	struct LessDim {
+		const Descriptors &desc;
+		int cols, dim;
+		LessDim(const Descriptors &desc_, int cols_, int dim_) : desc(desc_), cols(cols_), dim(dim_) {}
+		bool operator()(int a, int b) const {
+			return desc.descriptor(std::make_pair(a/cols, a%cols))[dim] < desc.descriptor(std::make_pair(b/cols, b%cols))[dim];
+		}
+	};
+
+	struct ScanOrder {
+		int center_row;
+		ScanOrder(int center_row_) : center_row(center_row_) {}
+		bool operator()(const pair &a, const pair &b) const {
+			bool wa = a.first < center_row, wb = b.first < center_row;
+			if (wa != wb) return wb;
+			return a < b;
+		}
+	};
+
+	enum { leaf_size = 8 };
+
+	const Descriptors &desc;
+	int rows_, cols_, dims_;
+	int tile_size;
+	int tiles_rows, tiles_cols;
+
+	std::vector<Node> nodes;
+	std::vector<int> roots;		// radice di ogni tassello
+	std::vector<int> points;	// indici lineari dei blocchi
+
+	/* stato della ricerca */
+	const Type* query_desc;
+	pair query_center;
+	pair query_topleft, query_downright;
+	size_t query_size;
+	std::vector<item> heap;
+
+	int build(int begin, int end) {
+		Node node;
+		node.begin = begin; node.end = end;
+		node.left = node.right = -1;
+		node.dim = -1; node.split = Type();
+		node.rmin = rows_; node.rmax = -1; node.cmin = cols_; node.cmax = -1;
+		for(int i=begin; i<end; i++) {
+			int r = points[i]/cols_, c = points[i]%cols_;
+			node.rmin = std::min(node.rmin, r); node.rmax = std::max(node.rmax, r);
+			node.cmin = std::min(node.cmin, c); node.cmax = std::max(node.cmax, c);
+		}
+
+		if (end-begin > leaf_size) {
+			// taglio lungo la componente di massima escursione
+			Type best = -1;
+			for(int k=0; k<dims_; k++) {
+				Type vmin = desc.descriptor(std::make_pair(points[begin]/cols_, points[begin]%cols_))[k], vmax = vmin;
+				for(int i=begin+1; i<end; i++) {
+					Type v = desc.descriptor(std::make_pair(points[i]/cols_, points[i]%cols_))[k];
+					if (v<vmin) vmin = v;
+					if (v>vmax) vmax = v;
+				}
+				if (vmax-vmin > best) { best = vmax-vmin; node.dim = k; }
+			}
+			int mid = (begin+end)/2;
+			std::nth_element(points.begin()+begin, points.begin()+mid, points.begin()+end, LessDim(desc, cols_, node.dim));
+			node.split = desc.descriptor(std::make_pair(points[mid]/cols_, points[mid]%cols_))[node.dim];
+		}
+
+		int index = (int) nodes.size();
+		nodes.push_back(node);
+		if (node.dim >= 0) {
+			int mid = (begin+end)/2;
+			int left  = build(begin, mid);
+			int right = build(mid, end);
+			nodes[index].left  = left;
+			nodes[index].right = right;
+		}
+		return index;
+	}
+
+	inline void consider(int p) {
+		pair pos(p/cols_, p%cols_);
+		if (pos.first  < query_topleft.first  || pos.first  > query_downright.first ||
+			pos.second < query_topleft.second || pos.second > query_downright.second ||
+			pos == query_center) return;
+		Type worst = (heap.size() < query_size) ? std::numeric_limits<Type>::max() : heap.front().first;
+		const Type* x = desc.descriptor(pos);
+		Type dist = Type();
+		for(int k=0; k<dims_ && dist<worst; k++) {
+			Type diff = x[k]-query_desc[k];
+			dist += diff*diff;
+		}
+		distances++;
+		if (dist < worst) {
+			if (heap.size() >= query_size) {
+				std::pop_heap(heap.begin(), heap.end());
+				heap.pop_back();
+			}
+			heap.push_back(item(dist, p));
+			std::push_heap(heap.begin(), heap.end());
+		}
+	}
+
+	void search(int index) {
+		const Node &node = nodes[index];
+		if (node.rmax < query_topleft.first  || node.rmin > query_downright.first ||
+			node.cmax < query_topleft.second || node.cmin > query_downright.second) return;
+		if (node.dim < 0) {
+			for(int i=node.begin; i<node.end; i++) consider(points[i]);
+		} else {
+			Type diff = query_desc[node.dim] - node.split;
+			search( (diff<0) ? node.left : node.right );
+			if (heap.size() < query_size || diff*diff < heap.front().first)
+				search( (diff<0) ? node.right : node.left );
+		}
+	}
+
+ public:
+
+	/* statistiche */
+	double queries;		// ricerche effettuate
+	double distances;	// distanze tra descrittori calcolate
+
+	/*
+	 * PARAMETRI D'INGRESSO:
+	 *   1) descriptors = descrittori dei blocchi
+	 *   2) tile_size   = lato (in blocchi) dei tasselli
+	 *   3) enabled     = se falso la struttura non e' costruita
+	 */
+	DescriptorForest(const Descriptors &descriptors, int tile_size_, bool enabled)
+		: desc(descriptors), rows_(descriptors.rows()), cols_(descriptors.cols()), dims_(descriptors.dims()),
+		  tile_size(std::max(tile_size_, 1)), tiles_rows(0), tiles_cols(0),
+		  query_desc(0), query_size(0), queries(0), distances(0) {
+		if (!enabled || dims_ <= 0) return;
+		tiles_rows = (rows_+tile_size-1)/tile_size;
+		tiles_cols = (cols_+tile_size-1)/tile_size;
+		points.reserve((size_t)rows_*cols_);
+		for(int ti=0; ti<tiles_rows; ti++) {
+			for(int tj=0; tj<tiles_cols; tj++) {
+				int begin = (int) points.size();
+				for(int r=ti*tile_size; r<std::min((ti+1)*tile_size, rows_); r++)
+					for(int c=tj*tile_size; c<std::min((tj+1)*tile_size, cols_); c++)
+						points.push_back(r*cols_+c);
+				roots.push_back( build(begin, (int) points.size()) );
+			}
+		}
+	}
+
+	bool enabled() const {
+		return !roots.empty();
+	}
+
+	/*
+	 * Il metodo restituisce in "dest" il blocco "center" e gli M-1 blocchi
+	 * piu' vicini ad esso tra quelli nel rettangolo [topleft, downright].
+	 */
+	void query(pair center, pair topleft, pair downright, size_t M, std::vector<pair> &dest) {
+		queries++;
+		query_desc = desc.descriptor(center);
+		query_center = center;
+		query_topleft = topleft;
+		query_downright = downright;
+		query_size = (M>1) ? M-1 : 0;
+		heap.clear();
+
+		if (query_size > 0) {
+			// prima il tassello che contiene il riferimento
+			int tc = center.first/tile_size, tcc = center.second/tile_size;
+			search( roots[tc*tiles_cols+tcc] );
+			for(int ti=topleft.first/tile_size; ti<=downright.first/tile_size; ti++)
+				for(int tj=topleft.second/tile_size; tj<=downright.second/tile_size; tj++)
+					if (ti!=tc || tj!=tcc) search( roots[ti*tiles_cols+tj] );
+		}
+
+		dest.resize(heap.size()+1);
+		dest[0] = center;
+		for(size_t i=0; i<heap.size(); i++)
+			dest[i+1] = std::make_pair(heap[i].second/cols_, heap[i].second%cols_);
+		std::sort(dest.begin(), dest.end(), ScanOrder(center.first));
+	}
+
+};
+
+#endif
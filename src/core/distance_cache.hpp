@@ -0,0 +1,224 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// 
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+// 
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * distance_cache.hpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Cache delle distanze tra coppie di "reference block", sfruttando la
+ *  simmetria d(p,q)=d(q,p) delle distanze SAR e della guida.
+ */
+#ifndef _DISTANCE_CACHE_HPP_
+#define _DISTANCE_CACHE_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+/*
+ * Quando il blocco candidato q e' anch'esso un "reference block", la coppia
+ * (p,q) verra' valutata una seconda volta, con i ruoli scambiati, quando il
+ * block-matching sara' centrato su q. La cache memorizza la coppia nella
+ * tabella del "reference block" che viene elaborato per ultimo, indicizzata
+ * dall'offset (in unita' di griglia) dell'altro blocco.
+ *
+ * Le tabelle sono organizzate come un buffer circolare di "band" righe di
+ * "reference block": una coppia viene memorizzata solo se la riga del blocco
+ * elaborato per ultimo cade nella banda corrente. Il numero di righe della
+ * banda e' limitato dalla memoria disponibile (max_bytes).
+ *
+ * Per le distanze con PDE il valore restituito puo' essere parziale: in tal
+ * caso viene memorizzato come limite inferiore, e riusato solo se supera la
+ * soglia corrente (cioe' se il candidato verrebbe comunque scartato).
+ */
+template <typename DistanceType>
+class SymmetricDistanceCache
+{
+ public:
+
+	typedef std::pair<int,int> pair;
+
+ private:
+
+	enum { EMPTY = 0, EXACT = 1, BOUND = 2 };
+
+	struct Entry {
+		DistanceType dist[2];
+		unsigned char state[2];
+	};
+
+	/* indice del "reference block" per ogni riga/colonna di blocco (-1 se assente) */
+	std::vector<int> row_ref;
+	std::vector<int> col_ref;
+	int ref_rows;
+	int ref_cols;
+
+	/* offset massimo (in unita' di griglia) tra due blocchi della stessa zona di ricerca */
+	int grid_radius;
+	int grid_diameter;
+
+	/* buffer circolare delle tabelle: [riga % band][colonna][offset] */
+	int band;
+	std::vector<Entry> table;
+
+	/* "reference block" corrente */
+	pair central_point;
+	int central_row;
+	int central_col;
+
+	inline Entry* entries(int ir, int ic) {
+		return &table[ ((size_t)(ir % band) * ref_cols + ic) * grid_diameter * grid_diameter ];
+	}
+
+	void clear_row(int ir) {
+		Entry* e = entries(ir, 0);
+		Entry* e_end = e + (size_t) ref_cols * grid_diameter * grid_diameter;
+		for(; e<e_end; e++) e->state[0] = e->state[1] = EMPTY;
+	}
+
+	/*
+	 * Posizione nella cache della coppia (centro, pos), oppure 0 se la
+	 * coppia non puo' essere memorizzata.
+	 */
+	Entry* slot(pair pos) {
+		int ir = row_ref[pos.first];
+		int ic = col_ref[pos.second];
+		if (ir < 0 || ic < 0) return 0;
+		int di = ir - central_row;
+		int dj = ic - central_col;
+		if (di==0 && dj==0) return 0;
+		// la coppia e' memorizzata nella tabella del blocco elaborato per ultimo
+		bool later = (di > 0) || (di == 0 && dj > 0);
+		int ir_last = later ? ir : central_row;
+		int ic_last = later ? ic : central_col;
+		if (later) {
+			di = -di;
+			dj = -dj;
+		}
+		if (ir_last - central_row >= band) return 0;
+		if (di < -grid_radius || dj < -grid_radius || dj > grid_radius) return 0;
+		return entries(ir_last, ic_last) + (di+grid_radius)*grid_diameter + (dj+grid_radius);
+	}
+
+ public:
+
+	/* contatori per valutare l'efficacia della cache */
+	double lookups;		// distanze richieste
+	double hits;		// distanze ottenute dalla cache
+
+	/*
+	 * PARAMETRI D'INGRESSO:
+	 *   1) row_index/col_index = indici dei "reference block" (vedi Stepper)
+	 *   2) rows/cols           = num. di blocchi su una colonna/riga dell'immagine
+	 *   3) search_diameter     = diametro della zona di ricerca
+	 *   4) max_bytes           = memoria massima per le tabelle
+	 */
+	SymmetricDistanceCache(const std::vector<int> &row_index, const std::vector<int> &col_index,
+			int rows, int cols, int search_diameter, size_t max_bytes)
+		: row_ref(rows, -1), col_ref(cols, -1),
+		  ref_rows(row_index.size()), ref_cols(col_index.size()),
+		  central_point(-1,-1), central_row(-1), central_col(0),
+		  lookups(0), hits(0) {
+		assert( search_diameter > 0 && search_diameter % 2 != 0 );
+		for(int i=0; i<ref_rows; i++) row_ref[row_index[i]] = i;
+		for(int j=0; j<ref_cols; j++) col_ref[col_index[j]] = j;
+
+		// passo minimo tra i "reference block" (l'ultimo puo' essere piu' vicino)
+		int step = rows;
+		for(int i=1; i<ref_rows; i++) step = std::min(step, row_index[i]-row_index[i-1]);
+		for(int j=1; j<ref_cols; j++) step = std::min(step, col_index[j]-col_index[j-1]);
+		if (step < 1) step = 1;
+		grid_radius   = (search_diameter-1)/2/step + 1;
+		grid_diameter = 2*grid_radius+1;
+
+		size_t row_bytes = sizeof(Entry) * ref_cols * grid_diameter * grid_diameter;
+		band = std::min( (size_t) std::min(grid_radius+1, ref_rows), max_bytes / row_bytes );
+		if (band > 0) {
+			table.resize( band * row_bytes / sizeof(Entry) );
+			for(int i=0; i<band; i++) clear_row(i);
+		}
+	}
+
+	/*
+	 * La cache e' attiva solo se la memoria consente almeno una riga di tabelle.
+	 */
+	bool enabled() const {
+		return band > 0;
+	}
+
+	size_t bytes() const {
+		return table.size() * sizeof(Entry);
+	}
+
+	/*
+	 * Il metodo imposta il "reference block" corrente. I blocchi devono
+	 * essere visitati nell'ordine dello Stepper (per righe).
+	 */
+	void set_center(pair point) {
+		int ir = row_ref[point.first];
+		int ic = col_ref[point.second];
+		assert( ir >= 0 && ic >= 0 && ir >= central_row );
+		// libera le righe che entrano nella banda
+		if (central_row >= 0) {
+			for(int r = std::max(central_row+band, ir); r < ir+band; r++) {
+				clear_row(r);
+			}
+		}
+		central_point = point;
+		central_row = ir;
+		central_col = ic;
+	}
+
+	pair central() const {
+		return central_point;
+	}
+
+	/*
+	 * Il metodo restituisce la distanza k-esima (k=0,1) tra il blocco centrale
+	 * e il blocco di posizione "pos", leggendola dalla cache oppure calcolandola
+	 * con op.computeDistance(block, ref_block, sup_distance).
+	 */
+	template <typename OpDistance, typename BlockType>
+	inline DistanceType distance(int k, pair pos, const OpDistance &op,
+			const BlockType &block, const BlockType &ref_block, DistanceType sup_distance) {
+		Entry* e = slot(pos);
+		lookups++;
+		if (e) {
+			if (e->state[k] == EXACT || (e->state[k] == BOUND && e->dist[k] > sup_distance)) {
+				hits++;
+				return e->dist[k];
+			}
+		}
+		DistanceType dist = op.computeDistance(block, ref_block, sup_distance);
+		if (e) {
+			e->dist[k]  = dist;
+			e->state[k] = (dist > sup_distance) ? BOUND : EXACT;
+		}
+		return dist;
+	}
+
+};
+
+/*
+ * Distanza k-esima tra "block" e "ref_block", eventualmente tramite la cache.
+ */
+template <typename OpDistance, typename BlockType>
+inline typename OpDistance::DistanceType cached_distance(SymmetricDistanceCache<typename OpDistance::DistanceType> *cache,
+		int k, std::pair<int,int> pos, const OpDistance &op,
+		const BlockType &block, const BlockType &ref_block, typename OpDistance::DistanceType sup_distance) {
+	if (cache) return cache->distance(k, pos, op, block, ref_block, sup_distance);
+	return op.computeDistance(block, ref_block, sup_distance);
+}
+
+#endif
@@ -0,0 +1,388 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * guide_cache.hpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Cache su file delle distanze della guida: la guida di un'area cambia
+ *  raramente, mentre le acquisizioni SAR si susseguono; le distanze della
+ *  guida di ogni "reference block" sono calcolate alla prima elaborazione
+ *  e lette dal file (mappato in memoria) nelle successive.
+ */
+#ifndef _GUIDE_CACHE_HPP_
+#define _GUIDE_CACHE_HPP_
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <utility>
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#else
+	#include <process.h>
+#endif
+#include "../utils/neighborhood.h"
+#include "block_matching.h"
+#include "block_matching_duo.hpp"
+
+/*
+ * Il file contiene un'intestazione e, per ogni "reference block" nell'ordine
+ * dello Stepper, la tabella delle distanze della guida di tutti gli offset
+ * del vicinato (search_diameter^2 valori, riga per riga; +inf fuori
+ * dall'immagine). Le distanze sono calcolate senza PDE e memorizzate senza
+ * quantizzazione, quindi il block matching coincide con quello esaustivo.
+ *
+ * In coda al file c'e' la somma di controllo delle tabelle (vedi checksum),
+ * verificata alla lettura.
+ *
+ * La chiave e' un hash (FNV-1a a 64 bit) dei pixel della guida, del tipo dei
+ * pixel e della geometria (blocco, diametro, passo): se il file non esiste o
+ * non corrisponde, la tabella e' calcolata e il file riscritto. Ogni
+ * elaborazione scrive in un proprio file temporaneo (nome unico), rinominato
+ * solo se completo: elaborazioni concorrenti sulla stessa cache non
+ * mescolano i dati.
+ */
+template <typename DistanceType>
+class GuideDistanceCache
+{
+ public:
+
+	typedef std::pair<int,int> pair;
+
+ private:
+
+	struct Header {
+		char magic[8];
+		unsigned long long key;
+		unsigned long long num_refs;
+		int rows, cols, block_rows, block_cols, search_diameter, step, dist_size, reserved;
+	};
+
+	std::string path;
+	std::string tmp_path;
+	Header header;
+	int diameter;
+	int radius;
+	size_t table_size;
+	size_t ref_index;
+
+	/* file letto (mappato in memoria) */
+	const DistanceType *data;
+	void *map_ptr;
+	size_t map_bytes;
+	std::vector<DistanceType> read_buffer;
+
+	/* file in scrittura */
+	FILE *out;
+	std::vector<DistanceType> row;
+	unsigned long long out_sum;
+
+	static void hash(unsigned long long &key, const void *ptr, size_t bytes) {
+		const unsigned char *p = (const unsigned char *) ptr;
+		for(size_t i=0; i<bytes; i++) {
+			key ^= p[i];
+			key *= 1099511628211ULL;
+		}
+	}
+
+	/*
+	 * Somma di controllo delle tabelle, aggiornata con "bytes" byte (multiplo
+	 * di 4): FNV-1a su parole di 32 bit.
+	 */
+	static void checksum(unsigned long long &sum, const void *ptr, size_t bytes) {
+		const unsigned char *p = (const unsigned char *) ptr;
+		for(size_t i=0; i+4<=bytes; i+=4) {
+			unsigned int word;
+			std::memcpy(&word, p+i, 4);
+			sum ^= word;
+			sum *= 1099511628211ULL;
+		}
+	}
+
+	/* file temporaneo accanto alla cache, con nome unico (creato in esclusiva) */
+	FILE* open_temporary() {
+		#ifndef _WIN32
+			std::vector<char> name(path.begin(), path.end());
+			const char suffix[] = ".XXXXXX";
+			name.insert(name.end(), suffix, suffix + sizeof(suffix));
+			int fd = mkstemp(&name[0]);
+			if (fd < 0) return 0;
+			tmp_path = &name[0];
+			fchmod(fd, 0644);
+			FILE *file = fdopen(fd, "wb");
+			if (file == 0) {
+				close(fd);
+				std::remove(tmp_path.c_str());
+			}
+			return file;
+		#else
+			static int counter = 0;
+			char suffix[64];
+			std::sprintf(suffix, ".%d.%d", (int) _getpid(), counter++);
+			tmp_path = path + suffix;
+			return std::fopen(tmp_path.c_str(), "wb");
+		#endif
+	}
+
+	bool open_read() {
+		size_t payload = map_bytes - sizeof(Header) - sizeof(unsigned long long);
+		unsigned long long sum = 14695981039346656037ULL, file_sum;
+		#ifndef _WIN32
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0) return false;
+			struct stat st;
+			if (fstat(fd, &st) != 0 || (size_t) st.st_size != map_bytes) {
+				close(fd);
+				return false;
+			}
+			void *ptr = mmap(0, map_bytes, PROT_READ, MAP_SHARED, fd, 0);
+			close(fd);
+			if (ptr == MAP_FAILED) return false;
+			const char *tables = (const char *) ptr + sizeof(Header);
+			bool ok = std::memcmp(ptr, &header, sizeof(Header)) == 0;
+			if (ok) {
+				checksum(sum, tables, payload);
+				std::memcpy(&file_sum, tables + payload, sizeof(file_sum));
+				ok = (sum == file_sum);
+			}
+			if (!ok) {
+				munmap(ptr, map_bytes);
+				return false;
+			}
+			map_ptr = ptr;
+			data = (const DistanceType *) tables;
+			return true;
+		#else
+			FILE *in = std::fopen(path.c_str(), "rb");
+			if (in == 0) return false;
+			Header file_header;
+			bool ok = std::fread(&file_header, sizeof(Header), 1, in) == 1 &&
+					std::memcmp(&file_header, &header, sizeof(Header)) == 0;
+			if (ok) {
+				read_buffer.resize(header.num_refs * table_size);
+				ok = std::fread(&read_buffer[0], sizeof(DistanceType), read_buffer.size(), in) == read_buffer.size() &&
+						std::fread(&file_sum, sizeof(file_sum), 1, in) == 1 && std::fgetc(in) == EOF;
+			}
+			if (ok) {
+				checksum(sum, &read_buffer[0], payload);
+				ok = (sum == file_sum);
+			}
+			std::fclose(in);
+			if (!ok) {
+				read_buffer.clear();
+				return false;
+			}
+			data = &read_buffer[0];
+			return true;
+		#endif
+	}
+
+ public:
+
+	/* distanze della guida calcolate (0 se la cache e' stata letta) */
+	double computed;
+
+	/*
+	 * PARAMETRI D'INGRESSO:
+	 *   1) filename        = file della cache (0 o vuoto = cache disattivata)
+	 *   2) guide           = immagine guida
+	 *   3) block_rows/cols = dimensioni dei blocchi
+	 *   4) search_diameter = diametro della zona di ricerca
+	 *   5) step            = distanza tra i "reference block"
+	 *   6) num_refs        = numero di "reference block" (vedi Stepper)
+	 */
+	template <typename PixelType2>
+	GuideDistanceCache(const char *filename, const cv::Mat_<PixelType2> &guide,
+			int block_rows, int block_cols, int search_diameter, int step, size_t num_refs)
+		: path(filename ? filename : ""), diameter(search_diameter), radius((search_diameter-1)/2),
+		  table_size((size_t) search_diameter*search_diameter), ref_index(0),
+		  data(0), map_ptr(0), map_bytes(0), out(0), out_sum(14695981039346656037ULL), computed(0) {
+		if (path.empty()) return;
+
+		std::memset(&header, 0, sizeof(Header));
+		std::memcpy(header.magic, "GNLMGDC2", 8);
+		header.num_refs   = num_refs;
+		header.rows       = guide.rows;
+		header.cols       = guide.cols;
+		header.block_rows = block_rows;
+		header.block_cols = block_cols;
+		header.search_diameter = search_diameter;
+		header.step       = step;
+		header.dist_size  = sizeof(DistanceType);
+
+		// chiave: pixel della guida, tipo dei pixel e geometria
+		unsigned long long key = 14695981039346656037ULL;
+		int elem_size = (int) sizeof(PixelType2);
+		hash(key, &elem_size, sizeof(int));
+		for(int i=0; i<guide.rows; i++)
+			hash(key, guide[i], sizeof(PixelType2)*guide.cols);
+		hash(key, &header.num_refs, sizeof(header.num_refs));
+		hash(key, &header.rows, 8*sizeof(int));
+		header.key = key;
+
+		map_bytes = sizeof(Header) + sizeof(DistanceType) * num_refs * table_size + sizeof(unsigned long long);
+		if (open_read()) return;
+
+		// cache assente o non valida: scritta durante l'elaborazione, in un file temporaneo unico
+		out = open_temporary();
+		if (out && std::fwrite(&header, sizeof(Header), 1, out) != 1) {
+			std::fclose(out);
+			std::remove(tmp_path.c_str());
+			out = 0;
+		}
+		row.resize(table_size);
+	}
+
+	~GuideDistanceCache() {
+		#ifndef _WIN32
+			if (map_ptr) munmap(map_ptr, map_bytes);
+		#endif
+		if (out) {
+			// elaborazione interrotta: il file incompleto e' eliminato
+			std::fclose(out);
+			std::remove(tmp_path.c_str());
+		}
+	}
+
+	/* la cache e' usata (letta o in scrittura) */
+	bool enabled() const {
+		return data != 0 || !row.empty();
+	}
+
+	/* la cache e' stata letta dal file */
+	bool loaded() const {
+		return data != 0;
+	}
+
+	/*
+	 * Il metodo restituisce la tabella delle distanze della guida del
+	 * "reference block" successivo (nell'ordine dello Stepper), centrato in
+	 * neighborhood.central(): letta dal file, oppure calcolata e scritta.
+	 */
+	template <typename OpDistance2, typename BlockAccessor2>
+	const DistanceType* table(const Neighborhood &neighborhood, const OpDistance2 &opt2, const BlockAccessor2 &src2) {
+		assert( ref_index < header.num_refs );
+		if (data) return data + (ref_index++) * table_size;
+
+		typedef typename BlockAccessor2::pixel_type pixel2_t;
+		DistanceType inf = std::numeric_limits<DistanceType>::infinity();
+		pair center = neighborhood.central();
+		pair tl = neighborhood.topleft();
+		pair dr = neighborhood.downright();
+		cv::Mat_<pixel2_t> ref_2block = src2(center.first, center.second);
+		std::fill(row.begin(), row.end(), inf);
+		for(int r=tl.first; r<=dr.first; r++)
+			for(int c=tl.second; c<=dr.second; c++) {
+				row[(r-center.first+radius)*diameter + (c-center.second+radius)] =
+						opt2.computeDistance(src2(r, c), ref_2block, inf);
+				computed++;
+			}
+
+		checksum(out_sum, &row[0], sizeof(DistanceType)*table_size);
+		if (out && std::fwrite(&row[0], sizeof(DistanceType), table_size, out) != table_size) {
+			std::fclose(out);
+			std::remove(tmp_path.c_str());
+			out = 0;
+		}
+		ref_index++;
+		return &row[0];
+	}
+
+	/*
+	 * Il metodo chiude il file in scrittura e, se tutte le tabelle sono
+	 * state scritte, lo rende disponibile alle elaborazioni successive.
+	 */
+	bool save() {
+		if (out == 0) return false;
+		bool ok = (ref_index == header.num_refs) && std::fwrite(&out_sum, sizeof(out_sum), 1, out) == 1;
+		ok = (std::fclose(out) == 0) && ok;
+		out = 0;
+		if (ok) ok = std::rename(tmp_path.c_str(), path.c_str()) == 0;
+		if (!ok) std::remove(tmp_path.c_str());
+		return ok;
+	}
+
+	int search_diameter() const {
+		return diameter;
+	}
+
+};
+
+/*
+ * Versione di block_matching_duo_th in cui la distanza della guida e' letta
+ * dalla tabella del "reference block" (vedi GuideDistanceCache::table).
+ * I candidati sono visitati nello stesso ordine della versione esaustiva e
+ * le distanze della guida sono esatte: con alpha1=0 la selezione coincide.
+ */
+template <typename BlockAccessor1, typename OpDistance1>
+        void block_matching_duo_th_table(const Neighborhood& neighborhood, typename OpDistance1::DistanceType alpha1,
+        typename OpDistance1::DistanceType th1,
+        const OpDistance1 &opt1, const BlockAccessor1 &src1,
+        const typename OpDistance1::DistanceType *table2, int diameter,
+        typename OpDistance1::DistanceType lambda1, typename OpDistance1::DistanceType lambda2,
+        std::vector< std::pair<int,int> > &dest_point,
+        std::vector<typename OpDistance1::DistanceType> &dest_dist,
+        const cv::Mat_<bool> &valClass,
+        const DistanceLowerBound<typename OpDistance1::DistanceType> *bound1 = 0,
+        std::vector<typename OpDistance1::DistanceType> *dest_sel = 0) {
+
+    typedef typename BlockAccessor1::pixel_type pixel1_t;
+    typedef typename    OpDistance1::DistanceType dist_t;
+
+    dist_t alpha2 = 1.0 - alpha1;
+    dist_t inf = std::numeric_limits<dist_t>::infinity();
+    int radius = (diameter-1)/2;
+    std::pair<int,int> center = neighborhood.central();
+    // le distanze SAR e della guida hanno la stessa soglia massima (vedi GuidedNLMeansProfile)
+    BlockMatchingDataList<dist_t, dist_t, std::pair<int,int> > list(opt1.max_matched, opt1.max_distance, opt1.stable_ties);
+
+    if (valClass(center.first, center.second)) {
+
+        cv::Mat_<pixel1_t> ref_1block = src1(center.first, center.second);
+        IteratorScan2Fast iter(neighborhood);
+        while (iter.hasNext()) {
+            std::pair<int,int> pos = iter.next();
+            if (!valClass(pos.first,pos.second)) continue;
+            // il candidato e' scartato se non supera il test SAR
+            if (bound1 && bound1->reject(pos, center, th1)) continue;
+            dist_t dist1 = opt1.computeDistance(src1(pos.first,pos.second), ref_1block, inf);
+            if (!(dist1<th1)) continue;
+            dist_t dist2 = table2[(pos.first-center.first+radius)*diameter + (pos.second-center.second+radius)];
+            dist_t distS = (alpha1==0) ? dist2 : ((alpha1==1) ? dist1 : alpha1*dist1+alpha2*dist2);
+            list.insert( distS, lambda1*dist1+lambda2*dist2, pos );
+        }
+    } else {
+        list.insert( 0.0, 1.0, center );
+    }
+
+    size_t N = list.size();
+    dest_point.resize(N);
+    dest_dist.resize(N);
+    list.getMatchingList(dest_dist, dest_point, N);
+    if (dest_sel) {
+        dest_sel->resize(N);
+        list.getMatchingDist(*dest_sel, N);
+    }
+
+}
+
+#endif /* _GUIDE_CACHE_HPP_ */
@@ -0,0 +1,200 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// 
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+// 
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * patch_match.hpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Block matching approssimato con propagazione e ricerca casuale
+ *  (stile PatchMatch).
+ */
+#ifndef _PATCH_MATCH_HPP_
+#define _PATCH_MATCH_HPP_
+
+#include <vector>
+#include <utility>
+#include <limits>
+#include "../utils/neighborhood.h"
+#include "block_matching.h"
+#include "block_matching_duo.hpp"
+
+/*
+ * Per ogni "reference block" i candidati sono, nell'ordine:
+ *   1) il blocco di riferimento;
+ *   2) gli offset selezionati per il riferimento precedente sulla stessa
+ *      riga e per quello sulla riga precedente nella stessa colonna
+ *      (propagazione);
+ *   3) "samples" posizioni casuali nel vicinato;
+ *   4) per "passes" passate, gli 8 vicini di ogni blocco selezionato e una
+ *      posizione casuale attorno ad esso, in un raggio che si dimezza ad ogni
+ *      passata.
+ * Ogni posizione e' valutata al piu' una volta, con le distanze esatte e lo
+ * stesso criterio di selezione di block_matching_duo_th.
+ *
+ * Lo stato (offset dei riferimenti precedenti) presuppone che i riferimenti
+ * siano visitati per righe, come con Stepper.
+ */
+class PatchMatchSearch
+{
+	typedef std::pair<int,int> pair;
+
+	int radius;
+	int diameter;
+	int passes;
+	int samples;
+
+	/* posizioni gia' valutate per il riferimento corrente */
+	std::vector<unsigned int> visited;
+	unsigned int stamp;
+
+	/* offset selezionati dai riferimenti precedenti */
+	std::vector< std::vector<pair> > upper;		// per colonna, riga precedente
+	std::vector<pair> left;						// riferimento precedente sulla riga
+	int left_row;
+
+	unsigned int seed;
+
+	inline int random(int n) {
+		seed = seed*1103515245u + 12345u;
+		return (int) ((seed >> 8) % (unsigned int) n);
+	}
+
+ public:
+
+	/* statistiche */
+	double references;	// riferimenti elaborati
+	double evaluations;	// posizioni valutate
+
+	/*
+	 * PARAMETRI D'INGRESSO:
+	 *   1) cols            = num. di blocchi su una riga
+	 *   2) search_diameter = diametro della zona di ricerca
+	 *   3) passes          = num. di passate di raffinamento
+	 *   4) samples         = num. di posizioni casuali iniziali
+	 */
+	PatchMatchSearch(int cols, int search_diameter, int passes_, int samples_)
+		: radius((search_diameter-1)/2), diameter(search_diameter),
+		  passes(passes_), samples(samples_),
+		  visited((size_t)search_diameter*search_diameter, 0u), stamp(0),
+		  upper(cols), left_row(-1), seed(12345u),
+		  references(0), evaluations(0) {}
+
+	template <typename BlockAccessor1, typename BlockAccessor2, typename OpDistance1, typename OpDistance2>
+	void match(const Neighborhood& neighborhood, typename OpDistance1::DistanceType alpha1,
+			typename OpDistance1::DistanceType th1,
+			const OpDistance1 &opt1, const OpDistance2 &opt2,
+			const BlockAccessor1 &src1, const BlockAccessor2 &src2,
+			typename OpDistance1::DistanceType lambda1, typename OpDistance2::DistanceType lambda2,
+			std::vector<pair> &dest_point,
+			std::vector<typename OpDistance1::DistanceType> &dest_dist,
+			const cv::Mat_<bool> &valClass,
+			const DistanceLowerBound<typename OpDistance1::DistanceType> *bound1 = 0) {
+
+		typedef typename BlockAccessor1::pixel_type pixel1_t;
+		typedef typename BlockAccessor2::pixel_type pixel2_t;
+		typedef typename    OpDistance1::DistanceType dist_t;
+
+		pair center = neighborhood.central();
+		references++;
+		if (center.first != left_row) {
+			left.clear();
+			left_row = center.first;
+		}
+
+		if (!valClass(center.first, center.second)) {
+			dest_point.assign(1, center);
+			dest_dist.assign(1, 1.0);
+			upper[center.second].clear();
+			left.clear();
+			return;
+		}
+
+		if ((++stamp) == 0) {
+			std::fill(visited.begin(), visited.end(), 0u);
+			stamp = 1;
+		}
+
+		dist_t alpha2 = 1.0 - alpha1;
+		dist_t max_distance = (alpha1==0) ? opt2.max_distance : opt1.max_distance;
+		BlockMatchingDataList<dist_t, dist_t, pair> list(opt1.max_matched, opt1.max_distance, opt1.stable_ties);
+		cv::Mat_<pixel1_t> ref_1block = src1(center.first, center.second);
+		cv::Mat_<pixel2_t> ref_2block = src2(center.first, center.second);
+
+		std::vector<pair> candidates;
+		candidates.push_back(center);
+		for(size_t i=0; i<left.size(); i++)
+			candidates.push_back(std::make_pair(center.first+left[i].first, center.second+left[i].second));
+		const std::vector<pair> &up = upper[center.second];
+		for(size_t i=0; i<up.size(); i++)
+			candidates.push_back(std::make_pair(center.first+up[i].first, center.second+up[i].second));
+		pair tl = neighborhood.topleft(), dr = neighborhood.downright();
+		for(int s=0; s<samples; s++)
+			candidates.push_back(std::make_pair(tl.first +random(dr.first -tl.first +1),
+			                                    tl.second+random(dr.second-tl.second+1)));
+
+		std::vector<dist_t> sel_dist;
+		std::vector<pair> selected;
+		int search_radius = radius;
+		for(int pass=0; ; pass++) {
+			for(size_t i=0; i<candidates.size(); i++) {
+				pair pos = candidates[i];
+				if (!neighborhood.validate(pos)) continue;
+				unsigned int &mark = visited[(size_t)(pos.first-center.first+radius)*diameter + (pos.second-center.second+radius)];
+				if (mark == stamp) continue;
+				mark = stamp;
+				if (!valClass(pos.first,pos.second)) continue;
+				evaluations++;
+				// il candidato e' scartato se non supera il test SAR
+				if (bound1 && bound1->reject(pos, center, th1)) continue;
+				dist_t dist1 = opt1.computeDistance(src1(pos.first,pos.second), ref_1block, opt1.max_distance);
+				if (dist1<th1) {
+					dist_t dist2 = opt2.computeDistance(src2(pos.first,pos.second), ref_2block,
+							(alpha1==0) ? max_distance : std::numeric_limits<dist_t>::max());
+					dist_t distS = (alpha1==0) ? dist2 : ((alpha1==1) ? dist1 : alpha1*dist1+alpha2*dist2);
+					dist_t sup = list.insert( distS, lambda1*dist1+lambda2*dist2, pos );
+					if (alpha1==0) max_distance = sup;
+				}
+			}
+
+			size_t N = list.size();
+			selected.resize(N);
+			sel_dist.resize(N);
+			list.getMatchingList(sel_dist, selected, N);
+			if (pass >= passes) break;
+
+			// raffinamento attorno ai blocchi selezionati
+			search_radius = std::max(search_radius/2, 1);
+			candidates.clear();
+			for(size_t i=0; i<N; i++) {
+				pair p = selected[i];
+				for(int di=-1; di<=1; di++)
+					for(int dj=-1; dj<=1; dj++)
+						if (di!=0 || dj!=0) candidates.push_back(std::make_pair(p.first+di, p.second+dj));
+				candidates.push_back(std::make_pair(p.first +random(2*search_radius+1)-search_radius,
+				                                    p.second+random(2*search_radius+1)-search_radius));
+			}
+		}
+
+		dest_point.swap(selected);
+		dest_dist.swap(sel_dist);
+
+		// offset da propagare ai riferimenti successivi
+		left.resize(dest_point.size());
+		for(size_t i=0; i<dest_point.size(); i++)
+			left[i] = std::make_pair(dest_point[i].first-center.first, dest_point[i].second-center.second);
+		upper[center.second] = left;
+	}
+
+};
+
+#endif
@@ -0,0 +1,241 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// 
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+// 
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * pyramid_search.hpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Preselezione multiscala (coarse-to-fine) dei candidati del block matching.
+ */
+#ifndef _PYRAMID_SEARCH_HPP_
+#define _PYRAMID_SEARCH_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+#include <opencv/cv.h>
+#include "../utils/neighborhood.h"
+
+/*
+ * Piramidi (medie 2x2) del log dell'immagine SAR e della guida.
+ *
+ * Al livello piu' grossolano il vicinato (ridotto) e' esplorato in modo
+ * esaustivo e sono conservati i "survivors" offset migliori; ad ogni livello
+ * piu' fine sono valutati solo i figli (3x3 posizioni attorno alla posizione
+ * raddoppiata) dei sopravvissuti. Al livello originale i figli dei
+ * sopravvissuti sono restituiti come candidati, nell'ordine di visita di
+ * IteratorScan2Fast, per il block matching con le distanze esatte.
+ *
+ * Il punteggio ai livelli ridotti e' la SSD della guida (alpha=0), del log
+ * SAR (alpha=1) o la loro combinazione con peso alpha.
+ */
+template <typename PixelType1, typename PixelType2>
+class PyramidSearch
+{
+	typedef std::pair<int,int> pair;
+	typedef std::pair<float,pair> item;
+	typedef typename cv::DataType<PixelType2>::channel_type channel_type;
+	enum { nc = cv::DataType<PixelType2>::channels };
+
+	struct Level {
+		int rows, cols;				// dimensioni dell'immagine
+		int block_rows, block_cols;	// dimensioni dei blocchi
+		int radius;					// raggio del vicinato
+		std::vector<float> sar;		// log SAR [rows][cols]
+		std::vector<float> guide;	// guida [rows][cols][nc]
+	};
+
+	std::vector<Level> levels;
+	int survivors;
+	float alpha;
+
+	struct ScanOrder {
+		int center_row;
+		ScanOrder(int center_row_) : center_row(center_row_) {}
+		bool operator()(const pair &a, const pair &b) const {
+			bool wa = a.first < center_row, wb = b.first < center_row;
+			if (wa != wb) return wb;
+			return a < b;
+		}
+	};
+
+	float score(const Level &lv, pair a, pair b) const {
+		float ds = 0, dg = 0;
+		for(int i=0; i<lv.block_rows; i++) {
+			int ia = (a.first+i)*lv.cols + a.second;
+			int ib = (b.first+i)*lv.cols + b.second;
+			for(int j=0; j<lv.block_cols; j++) {
+				if (alpha != 0) {
+					float d = lv.sar[ia+j] - lv.sar[ib+j];
+					ds += d*d;
+				}
+				if (alpha != 1) {
+					const float* ga = &lv.guide[(size_t)(ia+j)*nc];
+					const float* gb = &lv.guide[(size_t)(ib+j)*nc];
+					for(int k=0; k<nc; k++) {
+						float d = ga[k]-gb[k];
+						dg += d*d;
+					}
+				}
+			}
+		}
+		return alpha*ds + (1-alpha)*dg;
+	}
+
+	/* conserva in "best" i "survivors" candidati di punteggio minimo */
+	void select(const Level &lv, pair center, const std::vector<pair> &cands, std::vector<pair> &best) {
+		std::vector<item> scored;
+		scored.reserve(cands.size());
+		for(size_t i=0; i<cands.size(); i++) {
+			scored.push_back(item(score(lv, cands[i], center), cands[i]));
+			evaluations++;
+		}
+		size_t S = std::min(scored.size(), (size_t) survivors);
+		std::partial_sort(scored.begin(), scored.begin()+S, scored.end());
+		best.resize(S);
+		for(size_t i=0; i<S; i++) best[i] = scored[i].second;
+	}
+
+	/* figli (al livello l) delle posizioni "parents" (al livello l+1), interni al vicinato */
+	static void children(const Level &lv, pair center, const std::vector<pair> &parents, std::vector<pair> &dest) {
+		dest.clear();
+		for(size_t i=0; i<parents.size(); i++) {
+			for(int di=-1; di<=1; di++) {
+				for(int dj=-1; dj<=1; dj++) {
+					pair p(2*parents[i].first+di, 2*parents[i].second+dj);
+					if (p.first < 0 || p.first > lv.rows-lv.block_rows ||
+						p.second < 0 || p.second > lv.cols-lv.block_cols ||
+						std::abs(p.first-center.first) > lv.radius ||
+						std::abs(p.second-center.second) > lv.radius) continue;
+					dest.push_back(p);
+				}
+			}
+		}
+		std::sort(dest.begin(), dest.end());
+		dest.erase(std::unique(dest.begin(), dest.end()), dest.end());
+	}
+
+ public:
+
+	/* statistiche */
+	double references;		// riferimenti elaborati
+	double evaluations;		// punteggi calcolati ai livelli ridotti
+	double candidates;		// candidati restituiti al livello originale
+
+	/*
+	 * PARAMETRI D'INGRESSO:
+	 *   1) noisy, guide    = immagine SAR e guida
+	 *   2) block_rows/cols = dimensioni dei blocchi
+	 *   3) search_diameter = diametro della zona di ricerca
+	 *   4) num_levels      = livelli ridotti della piramide (0 = nessuno)
+	 *   5) survivors       = offset conservati ad ogni livello
+	 *   6) alpha           = peso della distanza SAR nel punteggio
+	 */
+	PyramidSearch(const cv::Mat_<PixelType1> &noisy, const cv::Mat_<PixelType2> &guide,
+			int block_rows, int block_cols, int search_diameter, int num_levels, int survivors_, double alpha_)
+		: survivors(std::max(survivors_, 1)), alpha((float) alpha_),
+		  references(0), evaluations(0), candidates(0) {
+		if (num_levels <= 0) return;
+
+		Level lv;
+		lv.rows = noisy.rows; lv.cols = noisy.cols;
+		lv.block_rows = block_rows; lv.block_cols = block_cols;
+		lv.radius = (search_diameter-1)/2;
+		lv.sar.resize((size_t)lv.rows*lv.cols);
+		lv.guide.resize((size_t)lv.rows*lv.cols*nc);
+		for(int i=0; i<lv.rows; i++) {
+			for(int j=0; j<lv.cols; j++) {
+				double v = noisy(i,j);
+				lv.sar[i*lv.cols+j] = (float) std::log(std::max(v, 1e-10));
+				const channel_type* g = (const channel_type*) &guide(i,j);
+				for(int k=0; k<nc; k++) lv.guide[(size_t)(i*lv.cols+j)*nc+k] = (float) g[k];
+			}
+		}
+		levels.push_back(lv);
+
+		for(int l=1; l<=num_levels; l++) {
+			const Level &fine = levels.back();
+			Level cl;
+			cl.rows = fine.rows/2; cl.cols = fine.cols/2;
+			cl.block_rows = std::max(fine.block_rows/2, 2);
+			cl.block_cols = std::max(fine.block_cols/2, 2);
+			cl.radius = (fine.radius+1)/2;
+			if (cl.rows < cl.block_rows || cl.cols < cl.block_cols) break;
+			cl.sar.resize((size_t)cl.rows*cl.cols);
+			cl.guide.resize((size_t)cl.rows*cl.cols*nc);
+			for(int i=0; i<cl.rows; i++) {
+				for(int j=0; j<cl.cols; j++) {
+					int f00 = (2*i)*fine.cols+2*j, f10 = f00+fine.cols;
+					cl.sar[i*cl.cols+j] = 0.25f*(fine.sar[f00]+fine.sar[f00+1]+fine.sar[f10]+fine.sar[f10+1]);
+					for(int k=0; k<nc; k++)
+						cl.guide[(size_t)(i*cl.cols+j)*nc+k] = 0.25f*(fine.guide[(size_t)f00*nc+k]+fine.guide[(size_t)(f00+1)*nc+k]+
+						                                            fine.guide[(size_t)f10*nc+k]+fine.guide[(size_t)(f10+1)*nc+k]);
+				}
+			}
+			levels.push_back(cl);
+		}
+		if (levels.size() < 2) levels.clear();
+
+		// al livello originale le distanze sono calcolate sulle immagini di ingresso
+		if (!levels.empty()) {
+			std::vector<float>().swap(levels[0].sar);
+			std::vector<float>().swap(levels[0].guide);
+		}
+	}
+
+	bool enabled() const {
+		return !levels.empty();
+	}
+
+	/*
+	 * Il metodo restituisce in "dest" i candidati del block matching per il
+	 * vicinato "neighborhood" (il blocco centrale e' sempre incluso).
+	 */
+	void search(const Neighborhood &neighborhood, std::vector<pair> &dest) {
+		references++;
+		pair center = neighborhood.central();
+		int L = (int) levels.size()-1;
+
+		// livello piu' grossolano: ricerca esaustiva
+		std::vector<pair> cands, best;
+		{
+			const Level &lv = levels[L];
+			pair c(std::min(center.first>>L, lv.rows-lv.block_rows), std::min(center.second>>L, lv.cols-lv.block_cols));
+			for(int i=std::max(c.first-lv.radius, 0); i<=std::min(c.first+lv.radius, lv.rows-lv.block_rows); i++)
+				for(int j=std::max(c.second-lv.radius, 0); j<=std::min(c.second+lv.radius, lv.cols-lv.block_cols); j++)
+					cands.push_back(std::make_pair(i,j));
+			select(lv, c, cands, best);
+		}
+
+		// livelli intermedi: solo i figli dei sopravvissuti
+		for(int l=L-1; l>=1; l--) {
+			const Level &lv = levels[l];
+			pair c(std::min(center.first>>l, lv.rows-lv.block_rows), std::min(center.second>>l, lv.cols-lv.block_cols));
+			children(lv, c, best, cands);
+			select(lv, c, cands, best);
+		}
+
+		// livello originale
+		children(levels[0], center, best, cands);
+		dest.clear();
+		dest.push_back(center);
+		for(size_t i=0; i<cands.size(); i++)
+			if (cands[i] != center && neighborhood.validate(cands[i])) dest.push_back(cands[i]);
+		std::sort(dest.begin(), dest.end(), ScanOrder(center.first));
+		candidates += dest.size();
+	}
+
+};
+
+#endif
@@ -0,0 +1,184 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// 
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+// 
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * sliding_distance.hpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Distanze tra blocchi aggiornate in modo incrementale lungo una riga di
+ *  "reference block" consecutivi (step=1).
+ */
+#ifndef _SLIDING_DISTANCE_HPP_
+#define _SLIDING_DISTANCE_HPP_
+
+#include <vector>
+#include <cassert>
+#include <opencv/cv.h>
+#include "../utils/neighborhood.h"
+
+/*
+ * La classe mantiene, per ogni offset (dr,dc) della zona di ricerca, le
+ * somme per colonna dei contributi pixel-a-pixel della distanza tra il
+ * blocco di riferimento e il blocco spostato di (dr,dc):
+ *
+ *     D(dr,dc) = sum_j T(dr,dc,col+j),   T(dr,dc,c) = sum_i op.computeTerm(x(row+dr+i,c+dc), x(row+i,c))
+ *
+ * Quando il blocco di riferimento si sposta di una colonna a destra basta
+ * calcolare la colonna entrante (block_rows termini) e sottrarre quella
+ * uscente, invece di ricalcolare block_rows*block_cols termini.
+ * Le colonne sono memorizzate in un buffer circolare di block_cols elementi.
+ *
+ * La distanza restituita coincide con OpDistance::computeDistance a meno
+ * degli arrotondamenti (non c'e' PDE: la distanza e' sempre completa).
+ */
+template <typename OpDistance, typename ElementType>
+class SlidingDistance
+{
+ public:
+
+	typedef typename OpDistance::DistanceType DistanceType;
+	typedef std::pair<int,int> pair;
+
+ private:
+
+	const cv::Mat_<ElementType> &src;
+	const OpDistance &op;
+
+	/* dimensioni dei blocchi e della zona di ricerca */
+	int block_rows;
+	int block_cols;
+	int radius;
+	int diameter;
+
+	/* blocchi contenuti nell'immagine */
+	int rows_;
+	int cols_;
+
+	/* posizione corrente del blocco di riferimento */
+	pair central_point;
+
+	/* termini per colonna [offset][colonna % block_cols] e somme [offset] */
+	std::vector<DistanceType> terms;
+	std::vector<double> sums;
+
+	inline int offset_index(int dr, int dc) const {
+		return (dr+radius)*diameter + (dc+radius);
+	}
+
+	/*
+	 * Contributo della colonna "c" (indice assoluto di pixel) per l'offset (dr,dc).
+	 * E' nullo se il blocco spostato esce dall'immagine (tali offset non
+	 * sono mai richiesti dal block-matching).
+	 */
+	DistanceType column_term(int dr, int dc, int c) const {
+		int row  = central_point.first;
+		int rowc = row + dr;
+		int cc   = c + dc;
+		if (rowc < 0 || rowc >= rows_ || cc < 0 || cc >= src.cols) return DistanceType();
+		DistanceType t = DistanceType();
+		for(int i=0; i < block_rows; i++) {
+			t += op.computeTerm( src(rowc+i, cc), src(row+i, c) );
+		}
+		return t;
+	}
+
+	void compute_all() {
+		int col = central_point.second;
+		for(int dr=-radius; dr<=radius; dr++) {
+			for(int dc=-radius; dc<=radius; dc++) {
+				int k = offset_index(dr,dc);
+				double s = 0;
+				for(int j=0; j < block_cols; j++) {
+					DistanceType t = column_term(dr, dc, col+j);
+					terms[k*block_cols + (col+j)%block_cols] = t;
+					s += t;
+				}
+				sums[k] = s;
+			}
+		}
+	}
+
+	void slide_right() {
+		int c_new = central_point.second + block_cols - 1;	// colonna entrante
+		int slot  = c_new % block_cols;						// stessa posizione della colonna uscente
+		for(int dr=-radius; dr<=radius; dr++) {
+			for(int dc=-radius; dc<=radius; dc++) {
+				int k = offset_index(dr,dc);
+				DistanceType t = column_term(dr, dc, c_new);
+				DistanceType &old = terms[k*block_cols + slot];
+				sums[k] += (double) t - (double) old;
+				old = t;
+			}
+		}
+	}
+
+ public:
+
+	/*
+	 * PARAMETRI D'INGRESSO:
+	 *   1) source          = immagine sorgente
+	 *   2) distance        = operatore di distanza (deve fornire computeTerm)
+	 *   3) block_rows/cols = dimensioni dei blocchi
+	 *   4) search_diameter = diametro della zona di ricerca
+	 */
+	SlidingDistance(const cv::Mat_<ElementType> &source, const OpDistance &distance,
+			int block_rows_, int block_cols_, int search_diameter)
+		: src(source), op(distance), block_rows(block_rows_), block_cols(block_cols_),
+		  radius((search_diameter-1)/2), diameter(search_diameter),
+		  rows_(source.rows-block_rows_+1), cols_(source.cols-block_cols_+1),
+		  central_point(-1,-1),
+		  terms(search_diameter*search_diameter*block_cols_),
+		  sums(search_diameter*search_diameter) {
+		assert( search_diameter > 0 && search_diameter % 2 != 0 );
+		assert( rows_ > 0 && cols_ > 0 );
+	}
+
+	/*
+	 * Il metodo sposta il blocco di riferimento. Se la nuova posizione e'
+	 * quella immediatamente a destra della corrente, l'aggiornamento e'
+	 * incrementale, altrimenti le somme vengono ricalcolate da capo.
+	 */
+	void set_center(pair point) {
+		assert( 0 <= point.first  && point.first  < rows_ );
+		assert( 0 <= point.second && point.second < cols_ );
+		if (point.first == central_point.first && point.second == central_point.second+1) {
+			central_point = point;
+			slide_right();
+		} else if (point != central_point) {
+			central_point = point;
+			compute_all();
+		}
+	}
+
+	pair central() const {
+		return central_point;
+	}
+
+	const OpDistance& distance() const {
+		return op;
+	}
+
+	/*
+	 * Il metodo restituisce la distanza tra il blocco di riferimento e il
+	 * blocco di posizione ASSOLUTA "pos" (interno alla zona di ricerca).
+	 */
+	inline DistanceType operator()(pair pos) const {
+		int dr = pos.first  - central_point.first;
+		int dc = pos.second - central_point.second;
+		assert( -radius <= dr && dr <= radius && -radius <= dc && dc <= radius );
+		return (DistanceType) sums[offset_index(dr,dc)];
+	}
+
+};
+
+#endif
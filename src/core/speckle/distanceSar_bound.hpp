@@ -0,0 +1,129 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// 
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+// 
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * distanceSar_bound.hpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Limite inferiore della distanza DistanceSar_int_sum (immagini intensita')
+ */
+#ifndef _DISTANCESAR_BOUND_HPP_
+#define _DISTANCESAR_BOUND_HPP_
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <opencv/cv.h>
+#include "../block_matching.h"
+#include "../../utils/block_sums.h"
+
+/*
+ * Con r = log(a) - log(b), il contributo di una coppia di pixel alla
+ * distanza DistanceSar_int_sum vale
+ *
+ *     log((a+b)^2/(4ab))/2 = log(cosh(r/2))
+ *
+ * che e' una funzione convessa di r. Per la disuguaglianza di Jensen,
+ * indicando con m la media del logaritmo dell'intensita' sul blocco
+ * (n = block_rows*block_cols):
+ *
+ *     D(p,q) >= n * log(cosh((m_p - m_q)/2))
+ *
+ * Le medie sono calcolate una volta sola con l'immagine integrale di log(a).
+ * I blocchi con pixel non positivi non hanno limite (restituisce 0).
+ * Il limite viene ridotto di un piccolo margine per tenere conto degli
+ * arrotondamenti della distanza calcolata in singola precisione.
+ */
+template <typename Type>
+class DistanceSar_bound : public DistanceLowerBound<Type>
+{
+	int cols_;						// num. di blocchi su una riga
+	double n;						// num. di pixel del blocco
+	std::vector<double> log_means;	// media di log(a) per ogni blocco
+	std::vector<double> invalid;	// num. di pixel non positivi per ogni blocco
+
+	/* soglia su |m_p - m_q| equivalente all'ultima soglia sulla distanza */
+	mutable Type last_sup;
+	mutable double diff_th;
+
+	inline double margin_bound(double x) const {
+		// log(cosh(x)) = |x| + log(1+exp(-2|x|)) - log(2)
+		double lc = x + std::log(1.0+std::exp(-2.0*x)) - std::log(2.0);
+		// margine per gli arrotondamenti (distanza in singola precisione)
+		return (1.0-1e-3)*n*lc - 1e-5*n;
+	}
+
+ public:
+
+	DistanceSar_bound(const cv::Mat_<Type> &src, int block_rows, int block_cols, bool enabled=true)
+		: cols_(src.cols-block_cols+1), n(block_rows*block_cols),
+		  last_sup(std::numeric_limits<Type>::quiet_NaN()), diff_th(0) {
+		if (!enabled) return;
+		size_t N = (size_t) (src.rows-block_rows+1)*cols_;
+		log_means.resize(N);
+		invalid.resize(N);
+
+		cv::Mat_<double> logs(src.rows, src.cols);
+		cv::Mat_<double> flags(src.rows, src.cols);
+		for(int i=0; i<src.rows; i++) for(int j=0; j<src.cols; j++) {
+			bool valid = src(i,j) > 0;
+			logs(i,j)  = valid ? std::log((double) src(i,j)) : 0.0;
+			flags(i,j) = valid ? 0.0 : 1.0;
+		}
+		block_sums(logs,  block_rows, block_cols, log_means);
+		block_sums(flags, block_rows, block_cols, invalid);
+		for(size_t b=0; b<N; b++) log_means[b] /= n;
+	}
+
+	virtual Type lower_bound(std::pair<int,int> pos, std::pair<int,int> ref) const {
+		size_t p = (size_t) pos.first*cols_ + pos.second;
+		size_t q = (size_t) ref.first*cols_ + ref.second;
+		if (invalid[p] > 0.5 || invalid[q] > 0.5) return 0;
+		return (Type) margin_bound( std::fabs(log_means[p]-log_means[q])/2.0 );
+	}
+
+	/*
+	 * Il limite e' crescente in |m_p - m_q|: la soglia sulla distanza (di solito
+	 * costante, th1) viene convertita una volta sola in una soglia sulle medie.
+	 */
+	virtual bool reject(std::pair<int,int> pos, std::pair<int,int> ref, Type sup_distance) const {
+		this->tests++;
+		if (!(sup_distance == last_sup)) {
+			last_sup = sup_distance;
+			double y = (sup_distance + 1e-5*n)/((1.0-1e-3)*n);	// log(cosh(x)) = y
+			if (!(y > 0)) {
+				diff_th = 0;
+			} else if (y > 30) {
+				diff_th = y + std::log(2.0);
+			} else {
+				double c = std::exp(y);
+				diff_th = std::log(c + std::sqrt(c*c-1.0));		// acosh(exp(y))
+			}
+			// oltre la soglia il limite deve superare sicuramente sup_distance
+			if (diff_th > 0) {
+				while (margin_bound(diff_th) < sup_distance) diff_th = diff_th*(1.0+1e-12) + 1e-15;
+			}
+		}
+		size_t p = (size_t) pos.first*cols_ + pos.second;
+		size_t q = (size_t) ref.first*cols_ + ref.second;
+		if (invalid[p] > 0.5 || invalid[q] > 0.5) return false;
+		if (std::fabs(log_means[p]-log_means[q])/2.0 > diff_th) {
+			this->rejects++;
+			return true;
+		}
+		return false;
+	}
+
+};
+
+#endif
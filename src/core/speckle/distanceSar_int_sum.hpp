@@ -22,6 +22,7 @@
 #define _DISTANCESAR_INT_SUM_HPP_
 
 #include <limits>
+#include <vector>
 #include "../block_matching.h"
 #include <assert.h>
 	
@@ -32,12 +33,14 @@ class DistanceSar_int_sum
 	typedef Type DistanceType;
 	const int max_matched;		 // numero massimo di blocchi da selezionare
 	const Type max_distance;	 // distanza massima tra 2 blocchi
+	const bool stable_ties;		 // regola delle distanze identiche (vedi BlockMatchingDataList)
 	
 
 
 	DistanceSar_int_sum(BlockMatchOptions<Type> opt, double L=1) :
 		max_matched(opt.max_matched),
-        max_distance(opt.max_distance) {}
+        max_distance(opt.max_distance),
+        stable_ties(opt.stable_ties) {}
 
 	inline Type computeDistance( const cv::Mat_<Type> &src1, const cv::Mat_<Type> &src2, Type sup_distance) const {
 		assert( src1.rows == src2.rows && src1.cols == src2.cols );
@@ -63,7 +66,55 @@ class DistanceSar_int_sum
 
 		return dist;
 	}
+
+	/*
+	 * Il metodo restituisce il contributo di una singola coppia di pixel
+	 * alla distanza (computeDistance e' la somma dei contributi sul blocco).
+	 */
+	inline Type computeTerm( const Type &el1, const Type &el2 ) const {
+		if (el1==el2) return 0;
+		Type sump = el1+el2;
+		return std::log(sump*sump/(4*el2*el1))/2.0;
+	}
     
+	/*
+	 * Il metodo restituisce la somma delle distanze di piu' coppie di blocchi
+	 * co-registrati (canali o date, src1[c] e src2[c]). Poiche' la somma dei
+	 * logaritmi e' il logaritmo del prodotto, i rapporti sono moltiplicati tra
+	 * loro e il logaritmo e' calcolato solo quando il prodotto diventa grande:
+	 * il costo non e' dominato dai logaritmi e cresce poco con il numero di canali.
+	 */
+	inline Type computeDistanceSum( const std::vector< cv::Mat_<Type> > &src1, const std::vector< cv::Mat_<Type> > &src2 ) const {
+		assert( src1.size() == src2.size() );
+		const double max_prod = 1e150;
+		double dist = 0;
+		double prod = 1;
+		const Type *row1;
+		const Type *row2;
+		Type sump;
+
+		for(size_t c=0; c < src1.size(); c++) {
+			assert( src1[c].rows == src2[c].rows && src1[c].cols == src2[c].cols );
+			for(int i=0; i < src1[c].rows; i++) {
+				row1 = src1[c][i];
+				row2 = src2[c][i];
+
+				for(int j=0; j<src1[c].cols; j++) {
+					if (row1[j]!=row2[j]) {
+						sump = (row1[j]+row2[j]);
+						prod *= sump*sump/(4*row2[j]*row1[j]);
+					}
+				}
+				if (prod > max_prod) {
+					dist += std::log(prod);
+					prod = 1;
+				}
+			}
+		}
+
+		return (Type) ((dist + std::log(prod))/2.0);
+	}
+
 	inline DistanceType getMaxMatched() const {
 		return max_distance;
 	}
@@ -0,0 +1,128 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * gnlm_client.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Client di prova del servizio locale: invia TILES tile sintetici di
+ *  SIZE x SIZE pixel (scena a celle costanti, speckle a 1 look, guida a
+ *  GUIDA_NUM_BANDS bande) con i parametri di default di guidedNLMeans.m
+ *  (stack_size 256, alpha 0, thDist/lambda per 1 look),
+ *  confronta il primo con guided_nlmeans nello stesso processo e riporta i
+ *  tempi per tile:
+ *
+ *    gnlm_client SOCKET [TILES] [SIZE]
+ *
+ *  Si compila come gnlm_service.cpp.
+ */
+#include <stdlib.h>
+#include <math.h>
+#include <opencv/cv.h>
+#include "gnlm_service.hpp"
+
+#ifndef GUIDA_NUM_BANDS
+#define GUIDA_NUM_BANDS 4
+#endif
+
+typedef cv::Vec<float, GUIDA_NUM_BANDS> PixelGuidaType;
+
+static double uniform(unsigned int &seed) {
+	seed = seed * 1664525u + 1013904223u;
+	return ((seed >> 8) + 1.0) / 16777217.0;		// in (0,1)
+}
+
+/* tile sintetico: riflettivita' costante su celle 16x16, speckle esponenziale */
+static void make_tile(unsigned int seed, cv::Mat_<float> noisy, cv::Mat_<PixelGuidaType> guide, cv::Mat_<unsigned char> valid) {
+	int cells_cols = (noisy.cols + 15) / 16;
+	std::vector<double> levels( ((noisy.rows + 15) / 16) * cells_cols );
+	for(size_t k=0; k<levels.size(); k++) levels[k] = 20.0 + 200.0 * uniform(seed);
+	for(int i=0; i<noisy.rows; i++)
+		for(int j=0; j<noisy.cols; j++) {
+			double r = levels[(i/16)*cells_cols + j/16];
+			noisy(i,j) = (float) (r * -log(uniform(seed)));
+			for(int b=0; b<GUIDA_NUM_BANDS; b++)
+				guide(i,j)[b] = (float) (r * (1.0 + 0.1*b) + 5.0 * (uniform(seed) - 0.5));
+			valid(i,j) = 1;
+		}
+}
+
+int main(int argc, char *argv[]) {
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s SOCKET [TILES] [SIZE]\n", argv[0]);
+		return 1;
+	}
+	int num_tiles = (argc > 2) ? atoi(argv[2]) : 100;
+	int size      = (argc > 3) ? atoi(argv[3]) : 64;
+
+	// parametri di default di guidedNLMeans.m (1 look); alpha = 0 e gli altri da GNLMServiceRequest
+	GNLMServiceRequest req;
+	double sigm_sar = req.block_size * sqrt(0.5*1.6449340668 - 0.6449340668);
+	double mu_sar   = req.block_size * req.block_size * (1.0 - log(2.0));
+	double mu_guide = req.block_size * req.block_size * GUIDA_NUM_BANDS;
+	req.stack_size = 256;
+	req.thDist  = sigm_sar * 2.0 + mu_sar;
+	req.lambda1 = 0.002 * 0.15 / mu_sar;
+	req.lambda2 = 0.002 * 0.85 / mu_guide;
+
+	GuidedNLMeansClient client;
+	if (!client.connect(argv[1])) {
+		fprintf(stderr, "cannot connect to %s\n", argv[1]);
+		return 1;
+	}
+	if (!client.allocate(size, size, GUIDA_NUM_BANDS)) {
+		fprintf(stderr, "cannot allocate the shared memory\n");
+		return 1;
+	}
+
+	double total = 0, processing = 0;
+	int hits = 0;
+	for(int t=0; t<num_tiles; t++) {
+		make_tile(12345u + t, client.noisy(), client.guide<GUIDA_NUM_BANDS>(), client.valid());
+		GNLMServiceReply reply;
+		double start = wall_clock();
+		int status = client.process(req, reply);
+		total += wall_clock() - start;
+		if (status != GNLM_SERVICE_OK) {
+			fprintf(stderr, "tile %d: error %d\n", t, status);
+			return 1;
+		}
+		processing += reply.time;
+		hits += reply.plan_hit;
+
+		if (t == 0) {
+			// stesso tile nel processo: uscite identiche
+			GuidedNLMeansProfile<float> opt;
+			opt.config(req.block_size, req.stack_size, req.search_diameter, req.step, (float) req.tau_match, (float) req.beta,
+					(float) req.alpha, (float) req.thDist, (float) req.lambda1, (float) req.lambda2);
+			cv::Mat_<unsigned char> valid = client.valid();
+			cv::Mat_<bool> valClass(size, size);
+			for(int i=0; i<size; i++)
+				for(int j=0; j<size; j++) valClass(i,j) = (valid(i,j) != 0);
+			cv::Mat_<float> clean, sum;
+			double local = wall_clock();
+			guided_nlmeans<float, PixelGuidaType, DistanceSar_int_sum<float>, DistanceAwgnVec<float, GUIDA_NUM_BANDS> >(
+					client.noisy(), client.guide<GUIDA_NUM_BANDS>(), valClass, clean, sum, opt);
+			local = wall_clock() - local;
+			cv::Mat_<float> remote = client.clean();
+			float diff = 0;
+			for(int i=0; i<size; i++)
+				for(int j=0; j<size; j++) diff = std::max(diff, fabsf(remote(i,j) - clean(i,j)));
+			printf("first tile: service %.4f s, in process %.4f s, max difference %g\n", total, local, diff);
+		}
+	}
+	printf("%d tiles of %dx%d: %.4f s per tile (%.4f s processing), plan hits %d\n",
+			num_tiles, size, size, total / num_tiles, processing / num_tiles, hits);
+	return 0;
+}
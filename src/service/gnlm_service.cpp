@@ -0,0 +1,67 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * gnlm_service.cpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Server del servizio locale (vedi gnlm_service.hpp):
+ *
+ *    gnlm_service SOCKET [THREADS]
+ *
+ *  Compilazione (dalla cartella src/service, con le librerie della cartella lib_static_a64):
+ *
+ *    g++ -O3 -D_GLIBCXX_USE_CXX11_ABI=0 -I../../include -DGUIDA_NUM_BANDS=4 gnlm_service.cpp
+ *        ../../lib_static_a64/libcv.a ../../lib_static_a64/libcxcore.a
+ *        ../../lib_static_a64/libopencv_lapack.a -lpthread -lrt -o gnlm_service
+ */
+#include <signal.h>
+#include <stdlib.h>
+#include <opencv/cv.h>
+#include "gnlm_service.hpp"
+
+#ifndef GUIDA_NUM_BANDS
+#define GUIDA_NUM_BANDS 4
+#endif
+
+static GuidedNLMeansService<GUIDA_NUM_BANDS> *service = 0;
+
+static void on_signal(int) {
+	if (service) service->stop();
+}
+
+int main(int argc, char *argv[]) {
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s SOCKET [THREADS]\n", argv[0]);
+		return 1;
+	}
+	int num_threads = (argc > 2) ? atoi(argv[2]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+	GuidedNLMeansService<GUIDA_NUM_BANDS> server(num_threads);
+	if (!server.start(argv[1])) {
+		fprintf(stderr, "cannot listen on %s\n", argv[1]);
+		return 1;
+	}
+	service = &server;
+	signal(SIGINT,  on_signal);
+	signal(SIGTERM, on_signal);
+	printf("listening on %s (%d threads, %d guide bands)\n", argv[1], std::max(num_threads, 1), GUIDA_NUM_BANDS);
+	fflush(stdout);
+
+	server.run();
+
+	printf("requests: %.0f, plan hits: %.0f, processing time: %.3f s\n",
+			server.num_requests(), server.num_plan_hits(), server.total_time());
+	return 0;
+}
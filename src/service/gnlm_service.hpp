@@ -0,0 +1,594 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * gnlm_service.hpp
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Servizio locale (solo POSIX) per l'elaborazione di molti tile piccoli
+ *  senza i costi di avvio: il server resta in ascolto su un socket Unix con
+ *  un gruppo di thread sempre attivi e i profili gia' configurati (finestra
+ *  di Kaiser compresa) in una cache; i tile passano per un segmento di
+ *  memoria condivisa del client (shm_open), mappato una volta per
+ *  connessione e letto/scritto dal server senza copie.
+ *  Il servizio e' riservato all'utente del server: il socket ha permessi
+ *  0600, le connessioni di altri utenti sono rifiutate (SO_PEERCRED) e sono
+ *  mappati solo segmenti "/gnlm.*" dello stesso utente.
+ */
+#ifndef _GNLM_SERVICE_HPP_
+#define _GNLM_SERVICE_HPP_
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <map>
+#include <deque>
+#include <set>
+#include <vector>
+#include <string>
+#include "../GNLM.hpp"
+#include "../utils/wall_clock.h"
+
+#define GNLM_SERVICE_MAGIC   0x4D4C4E47
+#define GNLM_SERVICE_VERSION 1
+
+/* esito di una richiesta */
+enum {
+	GNLM_SERVICE_OK = 0,
+	GNLM_SERVICE_BAD_REQUEST,	// parametri o dimensioni non validi (anche diametro pari o vicinato piu' grande del tile)
+	GNLM_SERVICE_BAD_BANDS,		// numero di bande della guida diverso da quello del server
+	GNLM_SERVICE_BAD_BUFFER,	// segmento di memoria condivisa assente o troppo piccolo
+	GNLM_SERVICE_FAILED			// errore durante l'elaborazione
+};
+
+/*
+ * Richiesta: dimensioni del tile, parametri del profilo (come in
+ * GuidedNLMeansProfile::config) e segmento di memoria condivisa con i dati.
+ * I valori iniziali sono quelli di guidedNLMeans.m che non dipendono dal
+ * rumore (alpha = 0: selezione con la sola distanza SAR); thDist, lambda1 e
+ * lambda2 vanno calcolati dal client.
+ */
+struct GNLMServiceRequest
+{
+	int32_t magic;
+	int32_t version;
+	int32_t rows;				// righe del tile
+	int32_t cols;				// colonne del tile
+	int32_t bands;				// bande della guida
+	int32_t block_size;			// righe/colonne del blocco
+	int32_t stack_size;			// lunghezza max dello stack
+	int32_t search_diameter;	// diametro della zona di ricerca
+	int32_t step;				// distanza tra i "reference block"
+	int32_t incremental;		// modalita' di GuidedNLMeansProfile (0/1)
+	int32_t guide_bound;
+	int32_t sar_bound;
+	double tau_match;
+	double beta;
+	double alpha;
+	double lambda1;
+	double lambda2;
+	double thDist;
+	double symmetric_cache;
+	uint64_t shm_bytes;			// dimensione del segmento
+	char shm_name[64];			// nome del segmento (shm_open)
+
+	GNLMServiceRequest() {
+		memset(this, 0, sizeof(*this));
+		magic = GNLM_SERVICE_MAGIC;
+		version = GNLM_SERVICE_VERSION;
+		block_size = 8; stack_size = 64; search_diameter = 39; step = 3;
+		tau_match = std::numeric_limits<double>::infinity(); beta = 2.0;
+		alpha = 0; lambda1 = 1; lambda2 = 1;		// alpha come in guidedNLMeans.m
+		thDist = std::numeric_limits<double>::infinity();
+	}
+};
+
+/* risposta */
+struct GNLMServiceReply
+{
+	int32_t status;				// GNLM_SERVICE_*
+	int32_t plan_hit;			// 1 se il profilo era gia' nella cache
+	double references;			// "reference block" elaborati
+	double time;				// tempo di elaborazione (s), senza la comunicazione
+
+	GNLMServiceReply() : status(GNLM_SERVICE_OK), plan_hit(0), references(0), time(0) {}
+};
+
+/*
+ * Disposizione dei dati nel segmento (float in intensita', righe contigue,
+ * sezioni allineate a 64 byte): noisy, guida (bande interlacciate), validita'
+ * (un byte per pixel, 0/1), e le uscite clean e sum scritte dal server.
+ */
+struct GNLMServiceLayout
+{
+	size_t noisy, guide, valid, clean, sum, bytes;
+
+	GNLMServiceLayout(int rows, int cols, int bands) {
+		size_t pixels = (size_t) rows * cols;
+		noisy = 0;
+		guide = align(noisy + pixels*sizeof(float));
+		valid = align(guide + pixels*bands*sizeof(float));
+		clean = align(valid + pixels);
+		sum   = align(clean + pixels*sizeof(float));
+		bytes = align(sum   + pixels*sizeof(float));
+	}
+
+	static size_t align(size_t n) { return (n + 63) & ~((size_t) 63); }
+};
+
+/* lettura/scrittura completa su socket (false alla chiusura o in caso di errore) */
+inline bool gnlm_service_io(int fd, void *data, size_t bytes, bool write_data) {
+	char *ptr = (char*) data;
+	while (bytes > 0) {
+		ssize_t n = write_data ? ::send(fd, ptr, bytes, MSG_NOSIGNAL) : ::recv(fd, ptr, bytes, 0);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return false;
+		ptr += n;
+		bytes -= (size_t) n;
+	}
+	return true;
+}
+
+/*
+ * Server: run() accetta le connessioni e attende (poll) le richieste su
+ * quelle inattive finche' non e' chiamato stop() (anche da un gestore di
+ * segnale); ogni richiesta pronta e' servita da un thread del gruppo, poi la
+ * connessione torna tra quelle inattive. I client connessi ma inattivi non
+ * occupano thread. I profili configurati sono conservati per parametri (al
+ * piu' max_plans, poi la cache e' svuotata).
+ */
+template <int NumBands>
+class GuidedNLMeansService
+{
+public:
+
+	typedef float PixelType;
+	typedef cv::Vec<PixelType, NumBands> PixelGuidaType;
+
+	GuidedNLMeansService(int num_threads_, int max_plans_ = 64)
+		: listen_fd(-1), num_threads(std::max(num_threads_, 1)), max_plans(max_plans_), stopping(0),
+		  requests(0), plan_hits(0), busy_time(0) {
+		pthread_mutex_init(&mutex, 0);
+		pthread_cond_init(&cond, 0);
+		wake[0] = wake[1] = -1;
+	}
+
+	~GuidedNLMeansService() {
+		close_all();
+		pthread_cond_destroy(&cond);
+		pthread_mutex_destroy(&mutex);
+	}
+
+	/* crea il socket in "path" e avvia i thread */
+	bool start(const char *path) {
+		sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (strlen(path) >= sizeof(addr.sun_path)) return false;
+		strcpy(addr.sun_path, path);
+		socket_path = path;
+
+		listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listen_fd < 0) return false;
+		::unlink(path);
+		// socket accessibile solo all'utente del server (anche durante la creazione)
+		mode_t mask = ::umask(0177);
+		bool bound = ::bind(listen_fd, (sockaddr*) &addr, sizeof(addr)) == 0;
+		::umask(mask);
+		if (!bound || ::chmod(path, 0600) != 0 || ::listen(listen_fd, 64) != 0) {
+			::close(listen_fd);
+			listen_fd = -1;
+			return false;
+		}
+
+		// pipe per risvegliare poll() quando un thread restituisce una connessione
+		if (::pipe(wake) != 0) return false;
+		::fcntl(wake[0], F_SETFL, O_NONBLOCK);
+		::fcntl(wake[1], F_SETFL, O_NONBLOCK);
+
+		threads.resize(num_threads);
+		for(int k=0; k<num_threads; k++)
+			pthread_create(&threads[k], 0, worker_main, this);
+		return true;
+	}
+
+	/* accetta le connessioni e distribuisce le richieste fino a stop() */
+	void run() {
+		std::vector<Connection*> idle;		// connessioni in attesa di una richiesta
+		std::vector<pollfd> fds;
+		while (!stopping) {
+			pthread_mutex_lock(&mutex);
+			idle.insert(idle.end(), returned.begin(), returned.end());
+			returned.clear();
+			pthread_mutex_unlock(&mutex);
+
+			fds.resize(2 + idle.size());
+			fds[0].fd = wake[0];
+			fds[1].fd = listen_fd;
+			for(size_t k=0; k<idle.size(); k++) fds[2+k].fd = idle[k]->fd;
+			for(size_t k=0; k<fds.size(); k++) { fds[k].events = POLLIN; fds[k].revents = 0; }
+			if (::poll(&fds[0], fds.size(), 200) <= 0) continue;
+
+			if (fds[0].revents) {
+				char buffer[64];
+				while (::read(wake[0], buffer, sizeof(buffer)) > 0) {}
+			}
+
+			// richieste pronte (o connessioni chiuse): ai thread
+			pthread_mutex_lock(&mutex);
+			size_t kept = 0;
+			for(size_t k=0; k<idle.size(); k++) {
+				if (fds[2+k].revents) ready.push_back(idle[k]);
+				else idle[kept++] = idle[k];
+			}
+			idle.resize(kept);
+			if (!ready.empty()) pthread_cond_broadcast(&cond);
+			pthread_mutex_unlock(&mutex);
+
+			if (fds[1].revents) {
+				int fd = ::accept(listen_fd, 0, 0);
+				if (fd < 0) continue;
+				if (!same_user(fd)) { ::close(fd); continue; }
+				// una richiesta incompleta non blocca un thread oltre il timeout
+				timeval timeout;
+				timeout.tv_sec = 10;
+				timeout.tv_usec = 0;
+				::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+				::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+				Connection *connection = new Connection(fd);
+				pthread_mutex_lock(&mutex);
+				connections.insert(connection);
+				pthread_mutex_unlock(&mutex);
+				idle.push_back(connection);
+			}
+		}
+		close_all();
+	}
+
+	/* richiesta di arresto: solo l'assegnazione di un flag */
+	void stop() { stopping = 1; }
+
+	/* statistiche */
+	double num_requests()  const { return requests;  }
+	double num_plan_hits() const { return plan_hits; }
+	double total_time()    const { return busy_time; }
+
+private:
+
+	typedef GuidedNLMeansProfile<PixelType> profile_t;
+
+	/* segmento di memoria condivisa mappato da una connessione */
+	struct Segment {
+		std::string name;
+		void *data;
+		size_t bytes;
+		Segment() : data(0), bytes(0) {}
+		~Segment() { release(); }
+		void release() {
+			if (data) ::munmap(data, bytes);
+			data = 0; bytes = 0; name.clear();
+		}
+		bool map(const char *name_, size_t bytes_) {
+			if (data && name == name_ && bytes >= bytes_) return true;
+			release();
+			if (!valid_shm_name(name_)) return false;
+			int fd = ::shm_open(name_, O_RDWR | O_NOFOLLOW, 0);
+			if (fd < 0) return false;
+			struct stat st;
+			if (::fstat(fd, &st) != 0 || st.st_uid != ::geteuid() || (size_t) st.st_size < bytes_) { ::close(fd); return false; }
+			void *ptr = ::mmap(0, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			::close(fd);
+			if (ptr == MAP_FAILED) return false;
+			data = ptr; bytes = (size_t) st.st_size; name = name_;
+			return true;
+		}
+	};
+
+	/* il processo all'altro capo della connessione e' dell'utente del server */
+	static bool same_user(int fd) {
+		#ifdef SO_PEERCRED
+			struct ucred cred;
+			socklen_t len = sizeof(cred);
+			if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) return false;
+			return cred.uid == ::geteuid();
+		#else
+			uid_t uid;
+			gid_t gid;
+			if (::getpeereid(fd, &uid, &gid) != 0) return false;
+			return uid == ::geteuid();
+		#endif
+	}
+
+	/* nomi dei segmenti creati da GuidedNLMeansClient: "/gnlm." senza altre "/" */
+	static bool valid_shm_name(const char *name) {
+		return strncmp(name, "/gnlm.", 6) == 0 && strchr(name+1, '/') == 0;
+	}
+
+	/* connessione con il segmento mappato per le sue richieste */
+	struct Connection {
+		int fd;
+		Segment segment;
+		Connection(int fd_) : fd(fd_) {}
+		~Connection() { ::close(fd); }
+	};
+
+	static void* worker_main(void *arg) {
+		((GuidedNLMeansService*) arg)->worker();
+		return 0;
+	}
+
+	void worker() {
+		while (true) {
+			pthread_mutex_lock(&mutex);
+			while (ready.empty() && !stopping) pthread_cond_wait(&cond, &mutex);
+			if (stopping) { pthread_mutex_unlock(&mutex); return; }
+			Connection *connection = ready.front();
+			ready.pop_front();
+			pthread_mutex_unlock(&mutex);
+
+			bool alive = serve(connection);
+
+			pthread_mutex_lock(&mutex);
+			if (alive) {
+				returned.push_back(connection);
+			} else {
+				connections.erase(connection);
+				delete connection;
+			}
+			pthread_mutex_unlock(&mutex);
+			if (alive) {
+				char c = 0;
+				ssize_t n = ::write(wake[1], &c, 1);
+				(void) n;
+			}
+		}
+	}
+
+	/* una richiesta della connessione (false se chiusa o non valida) */
+	bool serve(Connection *connection) {
+		GNLMServiceRequest req;
+		if (!gnlm_service_io(connection->fd, &req, sizeof(req), false)) return false;
+		GNLMServiceReply reply;
+		reply.status = process(req, connection->segment, reply);
+		return gnlm_service_io(connection->fd, &reply, sizeof(reply), true);
+	}
+
+	/* profilo dalla cache, configurato alla prima richiesta con gli stessi parametri */
+	profile_t plan(const GNLMServiceRequest &req, bool &hit) {
+		double values[] = { (double) req.block_size, (double) req.stack_size, (double) req.search_diameter,
+				(double) req.step, req.tau_match, req.beta, req.alpha, req.thDist, req.lambda1, req.lambda2,
+				(double) req.incremental, req.symmetric_cache, (double) req.guide_bound, (double) req.sar_bound };
+		std::vector<double> key(values, values + sizeof(values)/sizeof(values[0]));
+
+		pthread_mutex_lock(&mutex);
+		typename std::map< std::vector<double>, profile_t >::iterator it = plans.find(key);
+		hit = (it != plans.end());
+		if (hit) {
+			profile_t opt( it->second );
+			pthread_mutex_unlock(&mutex);
+			return opt;
+		}
+		pthread_mutex_unlock(&mutex);
+
+		profile_t opt;
+		opt.config(req.block_size, req.stack_size, req.search_diameter, req.step,
+				(PixelType) req.tau_match, (PixelType) req.beta, (PixelType) req.alpha,
+				(PixelType) req.thDist, (PixelType) req.lambda1, (PixelType) req.lambda2);
+		opt.incremental     = (req.incremental != 0);
+		opt.symmetric_cache = req.symmetric_cache;
+		opt.guide_bound     = (req.guide_bound != 0);
+		opt.sar_bound       = (req.sar_bound != 0);
+
+		pthread_mutex_lock(&mutex);
+		if ((int) plans.size() >= max_plans) plans.clear();
+		plans.insert(std::make_pair(key, opt));
+		pthread_mutex_unlock(&mutex);
+		return opt;
+	}
+
+	int process(GNLMServiceRequest &req, Segment &segment, GNLMServiceReply &reply) {
+		if (req.magic != GNLM_SERVICE_MAGIC || req.version != GNLM_SERVICE_VERSION) return GNLM_SERVICE_BAD_REQUEST;
+		if (req.bands != NumBands) return GNLM_SERVICE_BAD_BANDS;
+		if (req.block_size < 2 || req.stack_size < 1 || req.search_diameter < 2 || req.step < 1 ||
+				!(req.tau_match > 0) || !(req.beta > 0) || !(req.alpha >= 0 && req.alpha <= 1) ||
+				req.lambda1 < 0 || req.lambda2 < 0 || req.symmetric_cache < 0 ||
+				req.rows < req.block_size || req.cols < req.block_size)
+			return GNLM_SERVICE_BAD_REQUEST;
+		// diametro dispari e vicinato contenuto nelle posizioni dei blocchi (altrimenti assert)
+		if (req.search_diameter % 2 == 0 ||
+				(req.search_diameter-1)/2 >= std::min(req.rows, req.cols) - req.block_size + 1)
+			return GNLM_SERVICE_BAD_REQUEST;
+		req.shm_name[sizeof(req.shm_name)-1] = 0;
+		if (!valid_shm_name(req.shm_name)) return GNLM_SERVICE_BAD_BUFFER;
+		GNLMServiceLayout layout(req.rows, req.cols, req.bands);
+		if (req.shm_bytes < layout.bytes || !segment.map(req.shm_name, layout.bytes)) return GNLM_SERVICE_BAD_BUFFER;
+
+		double t = wall_clock();
+		bool hit;
+		profile_t opt = plan(req, hit);
+		GuidedNLMeansInfo info;
+		opt.info = &info;
+
+		// intestazioni sui dati del segmento: le uscite sono scritte al loro posto
+		char *base = (char*) segment.data;
+		cv::Mat_<PixelType>      noisy(req.rows, req.cols, (PixelType*) (base + layout.noisy));
+		cv::Mat_<PixelGuidaType> guida(req.rows, req.cols, (PixelGuidaType*) (base + layout.guide));
+		cv::Mat_<bool>           valClass(req.rows, req.cols, (bool*) (base + layout.valid));
+		cv::Mat_<PixelType>      clean(req.rows, req.cols, (PixelType*) (base + layout.clean));
+		cv::Mat_<PixelType>      sum(req.rows, req.cols, (PixelType*) (base + layout.sum));
+		try {
+			guided_nlmeans<PixelType, PixelGuidaType, DistanceSar_int_sum<PixelType>, DistanceAwgnVec<PixelType, NumBands> >(
+					noisy, guida, valClass, clean, sum, opt);
+		} catch (...) {
+			return GNLM_SERVICE_FAILED;
+		}
+		reply.plan_hit   = hit ? 1 : 0;
+		reply.references = info.references;
+		reply.time       = wall_clock() - t;
+
+		pthread_mutex_lock(&mutex);
+		requests++;
+		plan_hits += reply.plan_hit;
+		busy_time += reply.time;
+		pthread_mutex_unlock(&mutex);
+		return GNLM_SERVICE_OK;
+	}
+
+	/* arresto: chiude il socket e le connessioni, sblocca i thread e li attende */
+	void close_all() {
+		stopping = 1;
+		pthread_mutex_lock(&mutex);
+		typename std::set<Connection*>::iterator it;
+		for(it = connections.begin(); it != connections.end(); ++it) ::shutdown((*it)->fd, SHUT_RDWR);
+		pthread_cond_broadcast(&cond);
+		pthread_mutex_unlock(&mutex);
+		for(size_t k=0; k<threads.size(); k++) pthread_join(threads[k], 0);
+		threads.clear();
+		for(it = connections.begin(); it != connections.end(); ++it) delete *it;
+		connections.clear();
+		ready.clear();
+		returned.clear();
+		for(int k=0; k<2; k++) {
+			if (wake[k] >= 0) ::close(wake[k]);
+			wake[k] = -1;
+		}
+		if (listen_fd >= 0) {
+			::close(listen_fd);
+			::unlink(socket_path.c_str());
+			listen_fd = -1;
+		}
+	}
+
+	int listen_fd;
+	std::string socket_path;
+	int num_threads;
+	int max_plans;
+	volatile sig_atomic_t stopping;
+
+	int wake[2];
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	std::vector<pthread_t> threads;
+	std::set<Connection*> connections;	// tutte le connessioni aperte
+	std::deque<Connection*> ready;		// connessioni con una richiesta, in attesa di un thread
+	std::vector<Connection*> returned;	// connessioni servite, da riportare in poll()
+	std::map< std::vector<double>, profile_t > plans;
+
+	double requests, plan_hits, busy_time;
+};
+
+/*
+ * Client: il segmento di memoria condivisa e' creato (o ingrandito) da
+ * allocate() e riusato per tutti i tile; i dati sono scritti direttamente
+ * nelle intestazioni restituite da noisy(), guide(), valid() e le uscite
+ * lette da clean() e sum() dopo process().
+ */
+class GuidedNLMeansClient
+{
+public:
+
+	GuidedNLMeansClient() : fd(-1), data(0), bytes(0), rows(0), cols(0), bands(0), layout(0,0,0) {}
+
+	~GuidedNLMeansClient() {
+		if (fd >= 0) ::close(fd);
+		release();
+	}
+
+	bool connect(const char *path) {
+		sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (strlen(path) >= sizeof(addr.sun_path)) return false;
+		strcpy(addr.sun_path, path);
+		fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0) return false;
+		if (::connect(fd, (sockaddr*) &addr, sizeof(addr)) != 0) {
+			::close(fd);
+			fd = -1;
+			return false;
+		}
+		return true;
+	}
+
+	/* prepara il segmento per un tile rows x cols con "bands" bande di guida */
+	bool allocate(int rows_, int cols_, int bands_) {
+		GNLMServiceLayout new_layout(rows_, cols_, bands_);
+		if (!data || bytes < new_layout.bytes) {
+			release();
+			static int counter = 0;
+			char name_[64];
+			sprintf(name_, "/gnlm.%d.%d", (int) ::getpid(), counter++);
+			int shm = ::shm_open(name_, O_RDWR | O_CREAT | O_EXCL, 0600);
+			if (shm < 0) return false;
+			if (::ftruncate(shm, (off_t) new_layout.bytes) != 0) { ::close(shm); ::shm_unlink(name_); return false; }
+			void *ptr = ::mmap(0, new_layout.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+			::close(shm);
+			if (ptr == MAP_FAILED) { ::shm_unlink(name_); return false; }
+			data = ptr; bytes = new_layout.bytes; name = name_;
+		}
+		rows = rows_; cols = cols_; bands = bands_;
+		layout = new_layout;
+		return true;
+	}
+
+	cv::Mat_<float> noisy() { return cv::Mat_<float>(rows, cols, (float*) ((char*) data + layout.noisy)); }
+	cv::Mat_<float> clean() { return cv::Mat_<float>(rows, cols, (float*) ((char*) data + layout.clean)); }
+	cv::Mat_<float> sum()   { return cv::Mat_<float>(rows, cols, (float*) ((char*) data + layout.sum));   }
+	cv::Mat_<unsigned char> valid() { return cv::Mat_<unsigned char>(rows, cols, (unsigned char*) data + layout.valid); }
+	template <int NumBands>
+	cv::Mat_< cv::Vec<float, NumBands> > guide() {
+		return cv::Mat_< cv::Vec<float, NumBands> >(rows, cols, (cv::Vec<float, NumBands>*) ((char*) data + layout.guide));
+	}
+
+	/* elabora il tile del segmento con i parametri di "req" (dimensioni e segmento impostati qui) */
+	int process(GNLMServiceRequest req, GNLMServiceReply &reply) {
+		if (fd < 0 || !data) return GNLM_SERVICE_BAD_BUFFER;
+		req.rows = rows; req.cols = cols; req.bands = bands;
+		req.shm_bytes = bytes;
+		strncpy(req.shm_name, name.c_str(), sizeof(req.shm_name)-1);
+		if (!gnlm_service_io(fd, &req, sizeof(req), true) || !gnlm_service_io(fd, &reply, sizeof(reply), false))
+			return GNLM_SERVICE_FAILED;
+		return reply.status;
+	}
+
+private:
+
+	void release() {
+		if (data) {
+			::munmap(data, bytes);
+			::shm_unlink(name.c_str());
+		}
+		data = 0; bytes = 0;
+	}
+
+	int fd;
+	void *data;
+	size_t bytes;
+	std::string name;
+	int rows, cols, bands;
+	GNLMServiceLayout layout;
+};
+
+#endif /* _GNLM_SERVICE_HPP_ */
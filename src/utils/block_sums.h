@@ -0,0 +1,58 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// 
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+// 
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * block_sums.h
+ *
+ *  Created on: 19/10/2026
+ *
+ */
+
+#ifndef BLOCK_SUMS_H_
+#define BLOCK_SUMS_H_
+#include <cassert>
+#include <vector>
+#include <opencv/cv.h>
+
+/*
+ * La funzione calcola, tramite l'immagine integrale, la somma dei pixel di
+ * tutti i blocchi "sliding" dell'immagine. La somma del blocco (i,j) viene
+ * scritta in dest[(i*cols+j)*stride+offset], con cols = img.cols-block_cols+1.
+ */
+inline void block_sums(const cv::Mat_<double> &img, int block_rows, int block_cols, std::vector<double> &dest, int stride=1, int offset=0) {
+	int R = img.rows, C = img.cols;
+	int rows = R-block_rows+1, cols = C-block_cols+1;
+	assert( rows > 0 && cols > 0 );
+	assert( dest.size() >= (size_t) rows*cols*stride );
+
+	// immagine integrale
+	cv::Mat_<double> integ(R+1, C+1);
+	for(int j=0; j<=C; j++) integ(0,j) = 0;
+	for(int i=0; i<R; i++) {
+		double acc = 0;
+		integ(i+1,0) = 0;
+		for(int j=0; j<C; j++) {
+			acc += img(i,j);
+			integ(i+1,j+1) = integ(i,j+1) + acc;
+		}
+	}
+
+	// somme dei blocchi
+	for(int i=0; i<rows; i++) {
+		for(int j=0; j<cols; j++) {
+			dest[((size_t)i*cols+j)*stride+offset] = integ(i+block_rows,j+block_cols) - integ(i,j+block_cols)
+			                                       - integ(i+block_rows,j) + integ(i,j);
+		}
+	}
+}
+
+#endif
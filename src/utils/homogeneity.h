@@ -0,0 +1,129 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// 
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+// 
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * homogeneity.h
+ *
+ *  Created on: 19/10/2026
+ *
+ */
+
+#ifndef HOMOGENEITY_H_
+#define HOMOGENEITY_H_
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <opencv/cv.h>
+#include "block_sums.h"
+
+/*
+ * Mappa di disomogeneita' dei blocchi (una posizione per ogni blocco
+ * "sliding"): massimo tra
+ *   - l'energia media del gradiente della guida sul blocco e
+ *   - il coefficiente di variazione dell'immagine SAR sul blocco,
+ * ciascuno normalizzato per la sua mediana sull'immagine.
+ * Valori elevati indicano bordi o tessiture, valori vicini a 1 (o minori)
+ * zone omogenee.
+ */
+template <typename PixelType1, typename PixelType2>
+void homogeneity_map(const cv::Mat_<PixelType1> &noisy, const cv::Mat_<PixelType2> &guide,
+		int block_rows, int block_cols, cv::Mat_<float> &score) {
+
+	typedef typename cv::DataType<PixelType2>::channel_type channel_type;
+	const int nc = cv::DataType<PixelType2>::channels;
+	int R = noisy.rows, C = noisy.cols;
+	int rows = R-block_rows+1, cols = C-block_cols+1;
+	size_t N = (size_t) rows*cols;
+
+	// energia del gradiente della guida e momenti dell'immagine SAR
+	cv::Mat_<double> grad(R, C), sar(R, C), sar2(R, C);
+	for(int i=0; i<R; i++) {
+		for(int j=0; j<C; j++) {
+			const channel_type* g = (const channel_type*) &guide(i,j);
+			const channel_type* gr = (const channel_type*) &guide(i, std::min(j+1,C-1));
+			const channel_type* gd = (const channel_type*) &guide(std::min(i+1,R-1), j);
+			double e = 0;
+			for(int k=0; k<nc; k++) {
+				double dx = (double) gr[k]-g[k], dy = (double) gd[k]-g[k];
+				e += dx*dx + dy*dy;
+			}
+			grad(i,j) = e;
+			sar(i,j)  = noisy(i,j);
+			sar2(i,j) = (double) noisy(i,j)*noisy(i,j);
+		}
+	}
+
+	std::vector<double> g(N), m(N), m2(N);
+	block_sums(grad, block_rows, block_cols, g);
+	block_sums(sar,  block_rows, block_cols, m);
+	block_sums(sar2, block_rows, block_cols, m2);
+
+	double n = (double) block_rows*block_cols;
+	std::vector<double> cv_(N);
+	for(size_t t=0; t<N; t++) {
+		double mean = m[t]/n;
+		double var  = std::max(m2[t]/n - mean*mean, 0.0);
+		cv_[t] = (mean > 0) ? std::sqrt(var)/mean : 0.0;
+	}
+
+	// normalizzazione con le mediane
+	std::vector<double> tmp(g);
+	std::nth_element(tmp.begin(), tmp.begin()+N/2, tmp.end());
+	double med_g = std::max(tmp[N/2], 1e-12);
+	tmp = cv_;
+	std::nth_element(tmp.begin(), tmp.begin()+N/2, tmp.end());
+	double med_cv = std::max(tmp[N/2], 1e-12);
+
+	score.create(rows, cols);
+	for(int i=0; i<rows; i++)
+		for(int j=0; j<cols; j++) {
+			size_t t = (size_t) i*cols+j;
+			score(i,j) = (float) std::max(g[t]/med_g, cv_[t]/med_cv);
+		}
+}
+
+/*
+ * Il metodo seleziona la frazione "fraction" delle posizioni con
+ * disomogeneita' maggiore.
+ */
+inline void heterogeneous_mask(const cv::Mat_<float> &score, double fraction, cv::Mat_<unsigned char> &mask) {
+	std::vector<float> tmp;
+	for(int i=0; i<score.rows; i++)
+		for(int j=0; j<score.cols; j++) tmp.push_back(score(i,j));
+	mask.create(score.rows, score.cols);
+	if (tmp.empty()) return;
+	size_t k = (size_t) ((1.0-std::min(std::max(fraction, 0.0), 1.0))*(tmp.size()-1));
+	std::nth_element(tmp.begin(), tmp.begin()+k, tmp.end());
+	float th = tmp[k];
+	for(int i=0; i<score.rows; i++)
+		for(int j=0; j<score.cols; j++)
+			mask(i,j) = (fraction > 0 && score(i,j) >= th) ? 1 : 0;
+}
+
+/*
+ * Il metodo assegna ad ogni posizione il diametro della zona di ricerca:
+ * "max_diameter" nelle zone omogenee (score <= 1), decrescente fino a
+ * "min_diameter" per score >= 4 (bordi e tessiture). I diametri sono dispari.
+ */
+inline void diameter_map(const cv::Mat_<float> &score, int min_diameter, int max_diameter, cv::Mat_<unsigned char> &dest) {
+	min_diameter = std::max(std::min(min_diameter, max_diameter), 1);
+	dest.create(score.rows, score.cols);
+	for(int i=0; i<score.rows; i++)
+		for(int j=0; j<score.cols; j++) {
+			double t = std::min(std::max((score(i,j)-1.0)/3.0, 0.0), 1.0);
+			int d = (int) std::floor(max_diameter - t*(max_diameter-min_diameter) + 0.5);
+			if (d % 2 == 0) d = (d < max_diameter) ? d+1 : d-1;
+			dest(i,j) = (unsigned char) d;
+		}
+}
+
+#endif
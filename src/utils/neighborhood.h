@@ -22,6 +22,8 @@
 
 #include <cassert>
 #include <vector>
+#include <cmath>
+#include <algorithm>
 #include <opencv/cv.h>
 #include "accessors.h"
 
@@ -652,6 +654,177 @@ class IteratorSpiralFast : public Iterator<Neighborhood::pair> {
 	}
  };
 
+/*
+ * Iteratore su una lista di posizioni (ad es. i candidati preselezionati
+ * all'interno del vicinato).
+ */
+class IteratorList : public Iterator<Neighborhood::pair> {
+
+ public:
+
+	IteratorList(const std::vector<Neighborhood::pair>& list_) : list(list_) {
+		reset();
+	}
+
+	virtual void reset() {
+		index = 0;
+	}
+
+	virtual bool hasNext() {
+		return index < list.size();
+	}
+
+	virtual Neighborhood::pair next() {
+		if (index < list.size()) {
+			return list[index++];
+		} else {
+			return std::make_pair(0,0);
+		}
+	}
+
+ private:
+
+	const std::vector<Neighborhood::pair>& list;
+	size_t index;
+ };
+
+/*
+ * Sottoinsiemi di offset del vicinato, per una ricerca a campione.
+ *
+ * Il numero di offset e' una frazione ("budget") dell'area del vicinato;
+ * l'offset nullo (il blocco centrale) e' sempre incluso. Sono generate
+ * "variants" configurazioni diverse, alternate tra i riferimenti per non
+ * ripetere sempre le stesse lacune.
+ *   - RANDOM:     offset estratti in modo uniforme
+ *   - STRATIFIED: un offset estratto in ogni cella di una griglia regolare
+ *   - RADIAL:     densita' decrescente con la distanza dal centro
+ *                 (peso 1/(1+(d/r0)^2), con r0 = raggio/4)
+ * Gli offset sono ordinati come la visita di IteratorScan2Fast.
+ */
+class SampledOffsets {
+
+ public:
+
+	enum Pattern { RANDOM = 1, STRATIFIED = 2, RADIAL = 3 };
+
+	SampledOffsets(int diameter, int pattern, double budget, int variants = 8) {
+		int radius = (diameter-1)/2;
+		int area = diameter*diameter;
+		int count = (int) (budget*area + 0.5);
+		if (count < 1) count = 1;
+		if (count > area) count = area;
+		unsigned int seed = 12345u;
+
+		offsets.resize(variants);
+		for(int v=0; v<variants; v++) {
+			std::vector<Neighborhood::pair> &dest = offsets[v];
+			if (pattern == STRATIFIED) {
+				int cell = (int) std::floor(std::sqrt((double) area/count));
+				if (cell < 1) cell = 1;
+				for(int i=-radius; i<=radius; i+=cell) {
+					for(int j=-radius; j<=radius; j+=cell) {
+						int hi = std::min(cell, radius-i+1), hj = std::min(cell, radius-j+1);
+						Neighborhood::pair p(i + (int) (random(seed)*hi), j + (int) (random(seed)*hj));
+						if (p.first!=0 || p.second!=0) dest.push_back(p);
+					}
+				}
+				// rimuove a caso gli offset in eccesso
+				while ((int) dest.size() > count-1) {
+					size_t k = (size_t) (random(seed)*dest.size());
+					dest[k] = dest.back();
+					dest.pop_back();
+				}
+			} else {
+				// estrazione pesata senza reinserimento (chiave u^(1/w))
+				std::vector< std::pair<double,Neighborhood::pair> > keys;
+				double r0 = std::max(radius/4.0, 1.0);
+				for(int i=-radius; i<=radius; i++) {
+					for(int j=-radius; j<=radius; j++) {
+						if (i==0 && j==0) continue;
+						double w = (pattern == RADIAL) ? 1.0/(1.0+(i*i+j*j)/(r0*r0)) : 1.0;
+						keys.push_back(std::make_pair(-std::log(random(seed))/w, std::make_pair(i,j)));
+					}
+				}
+				size_t n = std::min(keys.size(), (size_t) (count-1));
+				std::partial_sort(keys.begin(), keys.begin()+n, keys.end());
+				for(size_t k=0; k<n; k++) dest.push_back(keys[k].second);
+			}
+			dest.push_back(std::make_pair(0,0));
+			std::sort(dest.begin(), dest.end(), ScanOrder());
+		}
+	}
+
+	/* offset per il riferimento "center" */
+	const std::vector<Neighborhood::pair>& get(Neighborhood::pair center) const {
+		return offsets[(size_t) (center.first*7 + center.second) % offsets.size()];
+	}
+
+ private:
+
+	std::vector< std::vector<Neighborhood::pair> > offsets;
+
+	/* ordine di IteratorScan2Fast: righe dal centro in giu', poi dall'alto */
+	struct ScanOrder {
+		bool operator()(const Neighborhood::pair &a, const Neighborhood::pair &b) const {
+			bool wa = a.first < 0, wb = b.first < 0;
+			if (wa != wb) return wb;
+			return a < b;
+		}
+	};
+
+	static double random(unsigned int &seed) {
+		seed = seed*1103515245u + 12345u;
+		return (((seed >> 8) & 0xFFFFFF) + 0.5) / 16777216.0;
+	}
+ };
+
+/*
+ * Iteratore sugli offset di SampledOffsets interni al vicinato.
+ */
+class IteratorOffsets : public Iterator<Neighborhood::pair> {
+
+ public:
+
+	IteratorOffsets(const Neighborhood& parent_, const std::vector<Neighborhood::pair>& offsets_)
+		: parent(parent_), offsets(offsets_) {
+		reset();
+	}
+
+	virtual void reset() {
+		index = 0;
+		central = parent.central();
+		skip();
+	}
+
+	virtual bool hasNext() {
+		return index < offsets.size();
+	}
+
+	virtual Neighborhood::pair next() {
+		if (index < offsets.size()) {
+			Neighborhood::pair ret(central.first+offsets[index].first, central.second+offsets[index].second);
+			index++;
+			skip();
+			return ret;
+		} else {
+			return std::make_pair(0,0);
+		}
+	}
+
+ private:
+
+	const Neighborhood& parent;
+	const std::vector<Neighborhood::pair>& offsets;
+	Neighborhood::pair central;
+	size_t index;
+
+	inline void skip() {
+		while (index < offsets.size() &&
+				!parent.validate(std::make_pair(central.first+offsets[index].first, central.second+offsets[index].second)))
+			index++;
+	}
+ };
+
 
 #include "neighborhood.hpp"
 #endif
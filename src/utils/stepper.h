@@ -22,6 +22,8 @@
 
 #include <cassert>
 #include <vector>
+#include <algorithm>
+#include <opencv/cv.h>
 
 class Stepper
 {
@@ -96,6 +98,15 @@ class Stepper
 		return col_index[++col_ptr % cols];
 	}
 
+	/* indici assoluti dei "ref. block" */
+	const std::vector<int>& row_indices() const {
+		return row_index;
+	}
+
+	const std::vector<int>& col_indices() const {
+		return col_index;
+	}
+
 	/* NON CANCELLARE */
 //	row_ptr = -1;
 //	col_ptr = col_index.size() - 1;
@@ -126,5 +137,139 @@ class Stepper
 //	}
 };
 
+/*
+ * Griglia di "reference block" a passo variabile: la griglia a passo
+ * "coarse_step" (limitato alle dimensioni del blocco, quindi ogni pixel e'
+ * coperto da almeno un "reference block") e' sempre presente; le posizioni
+ * della griglia a passo "step" sono aggiunte solo dove la maschera "dense"
+ * (una posizione per ogni blocco) e' non nulla.
+ * Senza maschera la griglia coincide con quella di Stepper.
+ * I "reference block" sono visitati per righe, con la stessa interfaccia di Stepper.
+ */
+class AdaptiveStepper
+{
+	/* indici di posizione */
+	unsigned int row_ptr;	// indice (relativo) di riga
+	unsigned int col_ptr;	// indice (relativo) di colonna
+
+	/* indici assoluti dei "reference block" */
+	std::vector<int> row_index;					// righe
+	std::vector< std::vector<int> > col_index;	// colonne di ogni riga
+
+	/* griglia a passo "step" */
+	std::vector<int> fine_rows;
+	std::vector<int> fine_cols;
+
+	size_t count;
+
+	static void grid(int last, int step, std::vector<int> &dest) {
+		dest.clear();
+		for(int i=0; i < last; i += step) dest.push_back(i);
+		dest.push_back(last);
+	}
+
+ public:
+
+	/*
+	 * PARAMETRI D'INGRESSO:
+	 *   1) image_rows  = num. di righe dell'immagine
+	 *   2) image_cols  = num. di colonne dell'immagine
+	 *   3) block_rows  = num. di righe dei blocchi
+	 *   4) block_cols  = num. di colonne dei blocchi
+	 *   5) step        = distanza tra i "ref. block" nelle zone selezionate
+	 *   6) dense       = maschera delle posizioni a passo "step" (0 = ovunque)
+	 *   7) coarse_step = distanza tra i "ref. block" altrove
+	 */
+	AdaptiveStepper( int image_rows, int image_cols, int block_rows, int block_cols, int step,
+			const cv::Mat_<unsigned char> *dense = 0, int coarse_step = 0 )
+		: row_ptr(0), col_ptr(0), count(0)
+	{
+		assert( block_rows > 0 && block_cols > 0 );
+		assert( image_rows >= block_rows && image_cols >= block_cols );
+		assert( step > 0 );
+
+		int last_row = image_rows - block_rows;
+		int last_col = image_cols - block_cols;
+		grid(last_row, step, fine_rows);
+		grid(last_col, step, fine_cols);
+
+		if (dense==0 || coarse_step<=step) {
+			row_index = fine_rows;
+			col_index.assign(fine_rows.size(), fine_cols);
+		} else {
+			assert( dense->rows == last_row+1 && dense->cols == last_col+1 );
+			// passo grossolano: multiplo di "step" (la griglia e' contenuta in quella fine)
+			// e non maggiore del blocco (copertura di tutti i pixel)
+			int coarse_rstep = std::max(step, (std::min(coarse_step, block_rows)/step)*step);
+			int coarse_cstep = std::max(step, (std::min(coarse_step, block_cols)/step)*step);
+			std::vector<int> coarse_rows, coarse_cols;
+			grid(last_row, coarse_rstep, coarse_rows);
+			grid(last_col, coarse_cstep, coarse_cols);
+
+			std::vector<int> rows(fine_rows);
+			rows.insert(rows.end(), coarse_rows.begin(), coarse_rows.end());
+			std::sort(rows.begin(), rows.end());
+			rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+			for(size_t r=0; r<rows.size(); r++) {
+				int row = rows[r];
+				std::vector<int> cols;
+				if (std::binary_search(coarse_rows.begin(), coarse_rows.end(), row))
+					cols = coarse_cols;
+				if (std::binary_search(fine_rows.begin(), fine_rows.end(), row))
+					for(size_t c=0; c<fine_cols.size(); c++)
+						if ((*dense)(row, fine_cols[c])) cols.push_back(fine_cols[c]);
+				if (cols.empty()) continue;
+				std::sort(cols.begin(), cols.end());
+				cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+				row_index.push_back(row);
+				col_index.push_back(cols);
+			}
+		}
+		for(size_t r=0; r<col_index.size(); r++) count += col_index[r].size();
+	}
+
+	int begin_row() {
+		col_ptr = 0;
+		return row_index[row_ptr = 0];
+	}
+
+	bool has_row() const {
+		return row_ptr < row_index.size();
+	}
+
+	int next_row() {
+		col_ptr = 0;
+		return row_index[++row_ptr % row_index.size()];
+	}
+
+	int begin_col() {
+		return col_index[row_ptr][col_ptr = 0];
+	}
+
+	bool has_col() const {
+		return col_ptr < col_index[row_ptr].size();
+	}
+
+	int next_col() {
+		const std::vector<int> &cols = col_index[row_ptr];
+		return cols[++col_ptr % cols.size()];
+	}
+
+	/* numero di "reference block" */
+	size_t size() const {
+		return count;
+	}
+
+	/* indici assoluti della griglia a passo "step" (contiene tutti i "ref. block") */
+	const std::vector<int>& row_indices() const {
+		return fine_rows;
+	}
+
+	const std::vector<int>& col_indices() const {
+		return fine_cols;
+	}
+};
+
 //#include "stepper.cpp"
 #endif
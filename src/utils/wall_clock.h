@@ -0,0 +1,44 @@
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//
+// Copyright (c) 2018 Image Processing Research Group of University Federico II of Naples ('GRIP-UNINA').
+// All rights reserved.
+// This software should be used, reproduced and modified only for informational and nonprofit purposes.
+//
+// By downloading and/or using any of these files, you implicitly agree to all the
+// terms of the license, as specified in the document LICENSE.txt
+// (included in this package) and online at
+// http://www.grip.unina.it/download/LICENSE_OPEN.txt
+//
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+ * wall_clock.h
+ *
+ *  Created on: 19/10/2026
+ *
+ *  Tempo reale (in secondi) senza dipendere da timer.cpp, per le
+ *  elaborazioni con scadenza; il riferimento e' arbitrario, solo le
+ *  differenze hanno senso.
+ */
+#ifndef _WALL_CLOCK_H_
+#define _WALL_CLOCK_H_
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <sys/time.h>
+#endif
+
+inline double wall_clock() {
+	#ifdef _WIN32
+		LARGE_INTEGER freq, count;
+		QueryPerformanceFrequency(&freq);
+		QueryPerformanceCounter(&count);
+		return (double) count.QuadPart / (double) freq.QuadPart;
+	#else
+		timeval tv;
+		gettimeofday(&tv, 0);
+		return (double) tv.tv_sec + (double) tv.tv_usec * 1e-6;
+	#endif
+}
+
+#endif /* _WALL_CLOCK_H_ */